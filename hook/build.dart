@@ -20,7 +20,17 @@ import 'package:native_toolchain_c/native_toolchain_c.dart';
 const _sources = [
   'src/native/particles.cpp',
   'src/native/physics.cpp',
+  'src/native/polygon.cpp',
+  'src/native/chain.cpp',
   'src/native/broadphase.cpp',
+  'src/native/spatial_grid.cpp',
+  'src/native/sort_and_sweep.cpp',
+  'src/native/wide_tree.cpp',
+  'src/native/constraint_graph.cpp',
+  'src/native/contact_solver.cpp',
+  'src/native/contact_table.cpp',
+  'src/native/continuous.cpp',
+  'src/native/island.cpp',
   'src/native/joints.cpp',
   'src/native/nodes.cpp',
   'src/native/abi_probe.cpp',
@@ -9,6 +9,7 @@ import 'package:vector_math/vector_math_64.dart' as v;
 /// Mimics Godot's RayCast2D:
 /// - `targetPosition`: The end point of the ray (relative to this node or absolute).
 /// - `enabled`: Whether the ray is actively casting.
+/// - `collisionMask`: Category bits of the bodies the ray can hit.
 /// - `colliding`: Whether the ray is currently hitting something.
 /// - `collisionPoint`: World position of the hit.
 /// - `collisionNormal`: Surface normal at the hit point.
@@ -24,6 +25,9 @@ class FRayCast2D extends FNode {
   /// Whether the ray should actively cast.
   bool enabled;
 
+  /// Only bodies whose category bits share a bit with this are hit.
+  int collisionMask;
+
   /// Color for debug drawing.
   Color debugColor;
 
@@ -52,6 +56,7 @@ class FRayCast2D extends FNode {
     super.name = 'RayCast2D',
     v.Vector2? targetPosition,
     this.enabled = true,
+    this.collisionMask = 0xFFFFFFFF,
     this.debugDraw = true,
     this.debugColor = Colors.red,
   }) : targetPosition = targetPosition ?? v.Vector2(0, -100);
@@ -81,7 +86,7 @@ class FRayCast2D extends FNode {
     final from = v.Vector2(origin.x, origin.y);
     final to = from + targetPosition;
 
-    final hit = FPhysicsSystem.rayCast(_world!, from.x, from.y, to.x, to.y);
+    final hit = FPhysicsSystem.rayCast(_world!, from.x, from.y, to.x, to.y, maskBits: collisionMask);
 
     _previousColliderBodyId = _colliderBodyId;
 
@@ -128,6 +128,14 @@ final class PhysicsWorld extends Struct {
   external int bodyFreeCount;
 }
 
+/// A rotation as its cosine and sine; `Rot` in physics.h.
+final class Rot extends Struct {
+  @Float()
+  external double c;
+  @Float()
+  external double s;
+}
+
 final class NativeBody extends Struct {
   @Uint32()
   external int id;
@@ -141,6 +149,7 @@ final class NativeBody extends Struct {
   external double y;
   @Float()
   external double rotation;
+  external Rot q; // cos and sin of rotation; written by the native core only
   @Float()
   external double vx;
   @Float()
@@ -185,6 +194,8 @@ final class NativeBody extends Struct {
   external int isAwake;
   @Int32()
   external int alive;
+  @Int32()
+  external int isBullet;
 }
 
 final class ParticleEmitter extends Struct {
@@ -245,6 +256,148 @@ final class RayCastHit extends Struct {
   external int hit;
 }
 
+/// Contact event types, matching `ContactEventType` in physics.h. Also the
+/// bit index in [setContactEventMask].
+abstract final class ContactEventType {
+  static const int begin = 0;
+  static const int end = 1;
+  static const int persist = 2;
+  static const int dropped = 3;
+}
+
+/// One entry of the native contact event stream (`ContactEvent` in physics.h).
+final class ContactEvent extends Struct {
+  @Int32()
+  external int type;
+  @Int32()
+  external int bodyA;
+  @Int32()
+  external int bodyB;
+  @Float()
+  external double x;
+  @Float()
+  external double y;
+  @Float()
+  external double normalX;
+  @Float()
+  external double normalY;
+  @Float()
+  external double approachSpeed;
+}
+
+/// One point of a contact's manifold, from [getContactPoints]
+/// (`ManifoldPoint` in physics.h).
+final class ManifoldPoint extends Struct {
+  /// Relative to body A's position when the manifold was built.
+  @Float()
+  external double anchorX;
+  @Float()
+  external double anchorY;
+
+  /// Negative when overlapping.
+  @Float()
+  external double separation;
+  @Float()
+  external double normalImpulse;
+  @Float()
+  external double tangentImpulse;
+
+  /// Names the point across steps: the feature it was clipped from.
+  @Uint32()
+  external int id;
+}
+
+/// One body for [createBodies] (`BodyDef` in physics.h).
+final class BodyDef extends Struct {
+  @Int32()
+  external int type;
+  @Int32()
+  external int shapeType;
+  @Float()
+  external double x;
+  @Float()
+  external double y;
+  @Float()
+  external double width;
+  @Float()
+  external double height;
+  @Float()
+  external double rotation;
+  @Float()
+  external double restitution;
+  @Float()
+  external double friction;
+  @Uint32()
+  external int categoryBits;
+  @Uint32()
+  external int maskBits;
+  @Int32()
+  external int isBullet;
+}
+
+/// One body's state from [getBodyTransforms] or [getAwakeBodyTransforms]
+/// (`BodyState` in physics.h).
+final class BodyState extends Struct {
+  @Int32()
+  external int id;
+  @Float()
+  external double x;
+  @Float()
+  external double y;
+  @Float()
+  external double rotation;
+  @Float()
+  external double vx;
+  @Float()
+  external double vy;
+  @Float()
+  external double angularVelocity;
+  @Int32()
+  external int awake;
+}
+
+/// A body pose from [getInterpolatedPoses] (`BodyPose` in physics.h).
+final class BodyPose extends Struct {
+  @Float()
+  external double x;
+  @Float()
+  external double y;
+  @Float()
+  external double rotation;
+}
+
+/// Broadphase work in the last step, and the shape of the trees now, from
+/// [getBroadphaseStats] (`BroadphaseStats` in physics.h).
+final class BroadphaseStats extends Struct {
+  /// Awake proxies checked against their fat AABB.
+  @Int32()
+  external int checkedProxies;
+
+  /// Proxies that had left their fat AABB and were reinserted.
+  @Int32()
+  external int reinsertions;
+
+  /// Pairs in the persistent pair set.
+  @Int32()
+  external int pairCount;
+
+  /// Height of the moving-body tree.
+  @Int32()
+  external int treeHeight;
+
+  /// Height of the static-body tree.
+  @Int32()
+  external int staticTreeHeight;
+
+  /// The moving-body tree's summed internal node perimeters over its root's.
+  @Float()
+  external double areaRatio;
+
+  /// The same for the static-body tree.
+  @Float()
+  external double staticAreaRatio;
+}
+
 // ---------------------------------------------------------------------------
 // Joints
 // ---------------------------------------------------------------------------
@@ -380,8 +533,11 @@ external int particlePoolConcurrency();
 
 // --- Physics world ---
 
-@Native<Pointer<PhysicsWorld> Function(Int32)>(symbol: 'create_physics_world')
-external Pointer<PhysicsWorld> createPhysicsWorld(int maxBodies);
+/// Creates a world of up to [maxBodies] bodies, with [broadphase] holding the
+/// moving ones: 0 tree, 1 grid, 2 sort and sweep (see `FBroadphase`).
+/// Returns nullptr for [maxBodies] below 1 or above 2^24.
+@Native<Pointer<PhysicsWorld> Function(Int32, Int32)>(symbol: 'create_physics_world')
+external Pointer<PhysicsWorld> createPhysicsWorld(int maxBodies, int broadphase);
 
 @Native<Void Function(Pointer<PhysicsWorld>)>(symbol: 'destroy_physics_world')
 external void destroyPhysicsWorld(Pointer<PhysicsWorld> world);
@@ -389,6 +545,17 @@ external void destroyPhysicsWorld(Pointer<PhysicsWorld> world);
 @Native<Void Function(Pointer<PhysicsWorld>, Float)>(symbol: 'step_physics', isLeaf: true)
 external void stepPhysics(Pointer<PhysicsWorld> world, double dt);
 
+/// Steps [frameDt] of time in whole [fixedDt] steps, at most [maxSubsteps],
+/// carrying the remainder natively, then writes the interpolated poses.
+/// Returns the number of steps taken.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Float, Float, Int32)>(symbol: 'step_physics_fixed', isLeaf: true)
+external int stepPhysicsFixed(Pointer<PhysicsWorld> world, double frameDt, double fixedDt, int maxSubsteps);
+
+/// The world's interpolated pose buffer, indexed by body id. Stable for the
+/// life of the world.
+@Native<Pointer<BodyPose> Function(Pointer<PhysicsWorld>)>(symbol: 'get_interpolated_poses', isLeaf: true)
+external Pointer<BodyPose> getInterpolatedPoses(Pointer<PhysicsWorld> world);
+
 /// Releases a body's slot back to the pool.
 ///
 /// Bodies used to be permanent: `create_body` handed out slots from a fixed
@@ -398,6 +565,42 @@ external void stepPhysics(Pointer<PhysicsWorld> world, double dt);
 @Native<Void Function(Pointer<PhysicsWorld>, Int32)>(symbol: 'destroy_body', isLeaf: true)
 external void destroyBody(Pointer<PhysicsWorld> world, int bodyId);
 
+/// Selects how the contact solver is threaded: 0 serial, 1 graph-colored,
+/// 2 per island (see `FSolverThreading`). Returns the previous mode.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Int32)>(symbol: 'set_solver_threading', isLeaf: true)
+external int setSolverThreading(Pointer<PhysicsWorld> world, int mode);
+
+/// Whether the graph-colored NGS solver solves contacts four at a time with
+/// SSE or NEON; on by default. The bodies come out bit for bit the same
+/// either way, so a test or benchmark can compare the two paths. Returns the
+/// previous setting.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Int32)>(symbol: 'set_wide_contact_solver', isLeaf: true)
+external int setWideContactSolver(Pointer<PhysicsWorld> world, int enabled);
+
+/// Selects the contact solver: 0 NGS, 1 soft step (see `FSolverMode`), with
+/// the soft step's substep count. Returns the previous mode.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Int32, Int32)>(symbol: 'set_solver_mode', isLeaf: true)
+external int setSolverMode(Pointer<PhysicsWorld> world, int mode, int subStepCount);
+
+/// Moves up to [max] queued contact events into [buffer], oldest first.
+/// Returns the number written.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Pointer<ContactEvent>, Int32)>(symbol: 'get_contact_events', isLeaf: true)
+external int getContactEvents(Pointer<PhysicsWorld> world, Pointer<ContactEvent> buffer, int max);
+
+/// Copies up to [max] points of the contact between two bodies, in either
+/// order, to [out], in manifold order. Returns the number written, 0 if they
+/// are not touching.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Int32, Int32, Pointer<ManifoldPoint>, Int32)>(
+  symbol: 'get_contact_points',
+  isLeaf: true,
+)
+external int getContactPoints(Pointer<PhysicsWorld> world, int bodyA, int bodyB, Pointer<ManifoldPoint> out, int max);
+
+/// Selects which [ContactEventType]s are queued, one bit each. Returns the
+/// previous mask.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Int32)>(symbol: 'set_contact_event_mask', isLeaf: true)
+external int setContactEventMask(Pointer<PhysicsWorld> world, int mask);
+
 @Native<Int32 Function(Pointer<PhysicsWorld>, Int32, Int32, Float, Float, Float, Float, Float, Uint32, Uint32)>(
   symbol: 'create_body',
   isLeaf: true,
@@ -415,6 +618,60 @@ external int createBody(
   int maskBits,
 );
 
+/// Creates [count] bodies from [defs] in one call, writing each id (or -1 once
+/// the pool is full) to [outIds]. Polygon and chain defs get -1 too; use
+/// [createPolygonBody] and [createChainBody]. Returns how many were created.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Pointer<BodyDef>, Int32, Pointer<Int32>)>(
+  symbol: 'create_bodies',
+  isLeaf: true,
+)
+external int createBodies(Pointer<PhysicsWorld> world, Pointer<BodyDef> defs, int count, Pointer<Int32> outIds);
+
+/// Creates a convex polygon body from [count] points ([vertices], interleaved
+/// x, y, up to 8) relative to ([x], [y]). The body sits at the hull's
+/// centroid. Returns -1 if the points do not span an area.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Int32, Float, Float, Float, Pointer<Float>, Int32, Uint32, Uint32)>(
+  symbol: 'create_polygon_body',
+  isLeaf: true,
+)
+external int createPolygonBody(
+  Pointer<PhysicsWorld> world,
+  int type,
+  double x,
+  double y,
+  double rotation,
+  Pointer<Float> vertices,
+  int count,
+  int categoryBits,
+  int maskBits,
+);
+
+/// Copies a polygon body's hull, in its local frame, to [outXY] (interleaved
+/// x, y, up to [max] vertices). Returns the vertex count; 0 for other shapes.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Int32, Pointer<Float>, Int32)>(symbol: 'get_polygon_vertices', isLeaf: true)
+external int getPolygonVertices(Pointer<PhysicsWorld> world, int bodyId, Pointer<Float> outXY, int max);
+
+/// Creates a static chain body from [count] world-space points ([vertices],
+/// interleaved x, y): one-sided segments, solid on their left. [loop] closes
+/// the chain. Returns -1 for fewer than 2 distinct points (3 for a loop), or
+/// for more than 65536 segments.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Pointer<Float>, Int32, Int32, Uint32, Uint32)>(
+  symbol: 'create_chain_body',
+  isLeaf: true,
+)
+external int createChainBody(
+  Pointer<PhysicsWorld> world,
+  Pointer<Float> vertices,
+  int count,
+  int loop,
+  int categoryBits,
+  int maskBits,
+);
+
+/// Releases [count] bodies in one call; see [destroyBody].
+@Native<Void Function(Pointer<PhysicsWorld>, Pointer<Int32>, Int32)>(symbol: 'destroy_bodies', isLeaf: true)
+external void destroyBodies(Pointer<PhysicsWorld> world, Pointer<Int32> ids, int count);
+
 @Native<Void Function(Pointer<PhysicsWorld>, Int32, Float, Float)>(symbol: 'apply_force', isLeaf: true)
 external void applyForce(Pointer<PhysicsWorld> world, int bodyId, double fx, double fy);
 
@@ -424,14 +681,54 @@ external void applyTorque(Pointer<PhysicsWorld> world, int bodyId, double torque
 @Native<Void Function(Pointer<PhysicsWorld>, Int32, Float, Float)>(symbol: 'set_body_velocity', isLeaf: true)
 external void setBodyVelocity(Pointer<PhysicsWorld> world, int bodyId, double vx, double vy);
 
+@Native<Void Function(Pointer<PhysicsWorld>, Int32, Uint32, Uint32)>(symbol: 'set_body_filter', isLeaf: true)
+external void setBodyFilter(Pointer<PhysicsWorld> world, int bodyId, int categoryBits, int maskBits);
+
 @Native<Void Function(Pointer<PhysicsWorld>, Int32, Pointer<Float>, Pointer<Float>)>(
   symbol: 'get_body_position',
   isLeaf: true,
 )
 external void getBodyPosition(Pointer<PhysicsWorld> world, int bodyId, Pointer<Float> outX, Pointer<Float> outY);
 
-@Native<RayCastHit Function(Pointer<PhysicsWorld>, Float, Float, Float, Float)>(symbol: 'ray_cast')
-external RayCastHit rayCast(Pointer<PhysicsWorld> world, double startX, double startY, double endX, double endY);
+/// Copies the state of each body in [ids] to [out], in order. Returns how
+/// many ids were live bodies; the others get a zeroed entry.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Pointer<Int32>, Int32, Pointer<BodyState>)>(
+  symbol: 'get_body_transforms',
+  isLeaf: true,
+)
+external int getBodyTransforms(Pointer<PhysicsWorld> world, Pointer<Int32> ids, int count, Pointer<BodyState> out);
+
+/// Copies the state of every awake body, and every body that fell asleep in
+/// the last step, to [out], up to [max]. Returns the number written.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Pointer<BodyState>, Int32)>(
+  symbol: 'get_awake_body_transforms',
+  isLeaf: true,
+)
+external int getAwakeBodyTransforms(Pointer<PhysicsWorld> world, Pointer<BodyState> out, int max);
+
+/// What the broadphase did in the last step.
+@Native<BroadphaseStats Function(Pointer<PhysicsWorld>)>(symbol: 'get_broadphase_stats', isLeaf: true)
+external BroadphaseStats getBroadphaseStats(Pointer<PhysicsWorld> world);
+
+/// Selects how the moving-body tree follows bodies out of their fat AABB:
+/// 0 reinsert, 1 incremental rebuild (see `FBroadphaseRebuild`). Returns the
+/// previous mode.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Int32)>(symbol: 'set_broadphase_rebuild', isLeaf: true)
+external int setBroadphaseRebuild(Pointer<PhysicsWorld> world, int mode);
+
+/// Rebuilds both broadphase trees top-down.
+@Native<Void Function(Pointer<PhysicsWorld>)>(symbol: 'rebuild_broadphase', isLeaf: true)
+external void rebuildBroadphase(Pointer<PhysicsWorld> world);
+
+/// Moved proxies at or above which a step's pair finding runs across the
+/// thread pool. The pairs come out the same either way, so a benchmark can
+/// compare both paths on one scene. Returns the previous threshold.
+@Native<Int32 Function(Pointer<PhysicsWorld>, Int32)>(symbol: 'set_pair_parallel_threshold', isLeaf: true)
+external int setPairParallelThreshold(Pointer<PhysicsWorld> world, int threshold);
+
+@Native<RayCastHit Function(Pointer<PhysicsWorld>, Float, Float, Float, Float, Uint32)>(symbol: 'ray_cast')
+external RayCastHit rayCast(
+    Pointer<PhysicsWorld> world, double startX, double startY, double endX, double endY, int maskBits);
 
 // --- Soft bodies ---
 
@@ -1,11 +1,12 @@
 import 'dart:ffi';
+import 'dart:typed_data';
 import 'package:ffi/ffi.dart';
 import 'package:flutter/material.dart';
 import 'package:vector_math/vector_math_64.dart' as v;
 import '../graph/node.dart';
 import '../graph/signal.dart';
 import '../native/flash_native_bindings.dart' as native;
-import '../native/flash_native_bindings.dart' show NativeBody, RayCastHit;
+import '../native/flash_native_bindings.dart' show BodyDef, BodyPose, BodyState, BroadphaseStats, ContactEvent, ContactEventType, NativeBody, RayCastHit;
 import '../native/flash_native.dart';
 import '../native/physics_ids.dart';
 
@@ -16,49 +17,280 @@ class FPhysicsSystem {
   final WorldId world;
   final v.Vector2 gravity;
 
-  FPhysicsSystem({v.Vector2? gravity})
-    : gravity = gravity ?? FPhysics.standardGravity,
-      // Safety check for native initialization
-      world = _createWorldSafe(2048) {
+  /// What holds the moving bodies for broadphase queries.
+  final FBroadphase broadphase;
+
+  /// [solverThreading] picks how the contact solver uses the native thread
+  /// pool. See [solverThreading] for when each mode pays off, and
+  /// [solverMode] for the solvers themselves. [broadphase] is fixed for the
+  /// life of the world; see [FBroadphase].
+  FPhysicsSystem({
+    v.Vector2? gravity,
+    FSolverThreading solverThreading = FSolverThreading.serial,
+    FSolverMode solverMode = FSolverMode.ngs,
+    this.broadphase = FBroadphase.tree,
+  }) : gravity = gravity ?? FPhysics.standardGravity,
+       // Safety check for native initialization
+       world = _createWorldSafe(_capacity, broadphase) {
     // Set gravity on the world struct directly
     world.ref.gravityX = this.gravity.x;
     world.ref.gravityY = this.gravity.y;
 
-    // Stability tuning: 8x sub-stepping lets us run very stiff springs
-    // (120Hz) without the bodies sinking into a rigid floor.
-    world.ref.contactHertz = 120.0;
     world.ref.positionIterations = 4; // Sufficient with sub-stepping
     world.ref.velocityIterations = 4;
-    world.ref.contactDampingRatio = 0.5; // Standard damping
+    this.solverMode = solverMode;
+
+    if (solverThreading != FSolverThreading.serial) this.solverThreading = solverThreading;
+    _systems[world.address] = this;
+  }
+
+  /// Live systems by world address, so that a body created from a bare
+  /// [WorldId] can find the system that drains its contact events.
+  static final Map<int, FPhysicsSystem> _systems = {};
+
+  /// Bodies of this world by id, for routing contact events.
+  final Map<BodyId, FPhysicsBody> _bodies = {};
+
+  static void _registerBody(FPhysicsBody body) {
+    _systems[body._world.address]?._bodies[body.bodyId] = body;
+  }
+
+  static void _unregisterBody(FPhysicsBody body) {
+    final bodies = _systems[body._world.address]?._bodies;
+    if (bodies != null && identical(bodies[body.bodyId], body)) bodies.remove(body.bodyId);
+  }
+
+  /// Emitted for each contact event the native core raised since the last
+  /// [update]: two bodies starting or stopping touching, with where, along
+  /// which normal, and how fast they were closing.
+  final FSignal<FContactEvent> contactEvent = FSignal();
+
+  bool _persistContactEvents = false;
+
+  /// Whether [contactEvent] also reports [FContactEventType.persist] for every
+  /// touching pair on every step. Off by default, since that is one event per
+  /// pair per step rather than one per change.
+  bool get persistContactEvents => _persistContactEvents;
+  set persistContactEvents(bool value) {
+    _persistContactEvents = value;
+    var mask = (1 << ContactEventType.begin) | (1 << ContactEventType.end);
+    if (value) mask |= 1 << ContactEventType.persist;
+    native.setContactEventMask(world, mask);
+  }
+
+  /// Drain buffer for [native.getContactEvents]. A burst bigger than this
+  /// takes more than one call, not more than one frame.
+  static const int _eventCapacity = 256;
+  final Pointer<ContactEvent> _events = calloc<ContactEvent>(_eventCapacity);
+
+  FSolverThreading _solverThreading = FSolverThreading.serial;
+
+  /// How contacts and joints are spread across the thread pool.
+  ///
+  /// [FSolverThreading.islands] hands each group of touching bodies to its own
+  /// task. It matches the serial solver exactly, and scales with the number of
+  /// separate piles — one big pile is still one task.
+  ///
+  /// [FSolverThreading.graphColored] partitions constraints into colors that
+  /// share no dynamic body and spreads each color over the pool, so it also
+  /// splits a single pile. It visits constraints in a different order from
+  /// the serial solver, so the two agree within solver tolerance rather than
+  /// bit for bit. Under [FSolverMode.ngs] it also solves each color's
+  /// contacts four at a time with SSE or NEON. Every color costs a pool
+  /// dispatch per iteration, so small scenes are faster serial.
+  ///
+  /// No mode's result depends on the thread count.
+  FSolverThreading get solverThreading => _solverThreading;
+  set solverThreading(FSolverThreading value) {
+    _solverThreading = value;
+    native.setSolverThreading(world, value.index);
+  }
+
+  FSolverMode _solverMode = FSolverMode.ngs;
+  int _subStepCount = 4;
+
+  /// Which contact solver runs.
+  ///
+  /// [FSolverMode.ngs] runs the world's `velocityIterations` of sequential
+  /// impulses and then its `positionIterations` of position correction.
+  ///
+  /// [FSolverMode.softStep] is Box2D v3's solver: [subStepCount] small steps,
+  /// each solving soft contacts once and relaxing once, then a restitution
+  /// pass. Stacks hold with far fewer passes, and restitution is what the
+  /// bodies were given rather than whatever the iterations left of it.
+  ///
+  /// Each mode sets the contact spring it is tuned for: NGS 120 Hz at damping
+  /// ratio 0.5, stiff enough not to sink into a rigid floor at this world's
+  /// 120 Hz step; the soft step Box2D's 30 Hz at damping ratio 10, since its
+  /// substeps provide the stiffness.
+  FSolverMode get solverMode => _solverMode;
+  set solverMode(FSolverMode value) {
+    _solverMode = value;
+    switch (value) {
+      case FSolverMode.ngs:
+        world.ref.contactHertz = 120.0;
+        world.ref.contactDampingRatio = 0.5;
+      case FSolverMode.softStep:
+        world.ref.contactHertz = 30.0;
+        world.ref.contactDampingRatio = 10.0;
+    }
+    native.setSolverMode(world, value.index, _subStepCount);
+  }
+
+  /// Substeps per fixed step for [FSolverMode.softStep]; at least 1.
+  int get subStepCount => _subStepCount;
+  set subStepCount(int value) {
+    _subStepCount = value < 1 ? 1 : value;
+    native.setSolverMode(world, _solverMode.index, _subStepCount);
   }
 
-  static WorldId _createWorldSafe(int capacity) {
+  /// Body slots per world.
+  static const int _capacity = 2048;
+
+  static WorldId _createWorldSafe(int capacity, FBroadphase broadphase) {
     // Tier 2: physics cannot be faked. Fail loudly at construction rather than
     // silently not simulating.
     FlashNative.require('Physics');
-    return native.createPhysicsWorld(capacity);
+    return native.createPhysicsWorld(capacity, broadphase.index);
   }
 
-  double _accumulator = 0.0;
-  static const double _fixedDt = 1.0 / 120.0; // Run physics at 120Hz fixed
+  /// Length of one physics step, in seconds. [update] steps the world in
+  /// whole steps of this and carries the rest of the frame to the next one,
+  /// so frame-time jitter never reaches the solver.
+  double fixedTimeStep = 1.0 / 120.0;
 
-  void update(double dt) {
-    // Fixed Time Step Loop
-    // Accumulate time and step physics in fixed chunks.
-    // This prevents instability caused by variable frame times (dt).
+  /// Most steps one [update] takes. A frame longer than this many steps
+  /// drops the excess rather than owing it to later frames, which would only
+  /// make them slower too. The default covers a quarter second at 120 Hz.
+  int maxStepsPerUpdate = 30;
+
+  /// Whether bodies are drawn between their last two physics steps rather
+  /// than at the last one.
+  ///
+  /// Without it a body moves only on frames that step, so physics has to run
+  /// at least as fast as the display to look smooth. With it, physics can run
+  /// at 60 Hz under a 120 Hz display — half the solver work — and bodies
+  /// still move every frame, drawn up to one step behind the simulation.
+  /// Only the drawn transform is blended; everything read from the world,
+  /// velocities and positions alike, is the simulated state.
+  bool interpolation = false;
+
+  /// Native buffer of blended poses, indexed by body id.
+  late final Pointer<BodyPose> _poses = native.getInterpolatedPoses(world);
+
+  /// Broadphase work in the last physics step: how many awake bodies were
+  /// checked, how many had moved out of their enlarged bounds and were
+  /// reinserted into the tree, and how many candidate pairs it holds. Also
+  /// the height and area ratio of the trees as they are now; over a long
+  /// session those should stay flat, and query times with them.
+  BroadphaseStats get broadphaseStats => native.getBroadphaseStats(world);
+
+  FBroadphaseRebuild _broadphaseRebuild = FBroadphaseRebuild.reinsert;
+
+  /// How the broadphase tree follows a body that leaves its enlarged bounds.
+  ///
+  /// [FBroadphaseRebuild.reinsert] moves each such body in the tree at once.
+  /// [FBroadphaseRebuild.incremental] grows its place in the tree instead,
+  /// and rebuilds the part of the tree that grew once per step. Only
+  /// [FBroadphase.tree] has a tree to rebuild.
+  FBroadphaseRebuild get broadphaseRebuild => _broadphaseRebuild;
+  set broadphaseRebuild(FBroadphaseRebuild value) {
+    _broadphaseRebuild = value;
+    native.setBroadphaseRebuild(world, value.index);
+  }
+
+  /// Rebuilds the broadphase trees from scratch. Bodies added with
+  /// [createBodies] into an empty world already get this; call it after
+  /// adding a level one body at a time.
+  void rebuildBroadphase() => native.rebuildBroadphase(world);
 
-    // Clamp dt to avoid spiral of death
-    if (dt > 0.25) dt = 0.25;
+  void update(double dt) {
+    // The accumulator lives natively, which also keeps the pose at each end
+    // of the last step for [interpolation].
+    native.stepPhysicsFixed(world, dt, fixedTimeStep, maxStepsPerUpdate);
+    _drainContactEvents();
+    _exportBodyStates();
+  }
+
+  /// Export buffer for [native.getAwakeBodyTransforms], with flat views so
+  /// reading it makes no struct views.
+  final Pointer<BodyState> _states = calloc<BodyState>(_capacity);
+  static const int _stateStride = 8; // sizeOf<BodyState>() / 4
+  late final Float32List _stateFloats = _states.cast<Float>().asTypedList(_capacity * _stateStride);
+  late final Int32List _stateInts = _states.cast<Int32>().asTypedList(_capacity * _stateStride);
+
+  void _exportBodyStates() {
+    // Each FPhysicsBody used to read its own pose through a NativeBody view
+    // every frame, asleep or not. One call now copies out the bodies that
+    // can have moved, and the rest keep the pose they already have.
+    final count = native.getAwakeBodyTransforms(world, _states, _capacity);
+    for (int i = 0; i < count; i++) {
+      final base = i * _stateStride;
+      final body = _bodies[_stateInts[base]];
+      if (body == null) continue;
+      body._poseX = _stateFloats[base + 1];
+      body._poseY = _stateFloats[base + 2];
+      body._poseRotation = _stateFloats[base + 3];
+    }
+  }
 
-    _accumulator += dt;
+  void _drainContactEvents() {
+    // Bodies used to poll collision_count every frame and guess at begin and
+    // end from it going non-zero and back. The native core now reports the
+    // changes themselves, and all of them arrive in one crossing.
+    var resync = false;
+    int count;
+    do {
+      count = native.getContactEvents(world, _events, _eventCapacity);
+      for (int i = 0; i < count; i++) {
+        final e = (_events + i).ref;
+        final FContactEventType type;
+        switch (e.type) {
+          case ContactEventType.begin:
+            type = FContactEventType.begin;
+            if (!resync) {
+              _bodies[e.bodyA]?._contactBegan();
+              _bodies[e.bodyB]?._contactBegan();
+            }
+          case ContactEventType.end:
+            type = FContactEventType.end;
+            if (!resync) {
+              _bodies[e.bodyA]?._contactEnded();
+              _bodies[e.bodyB]?._contactEnded();
+            }
+          case ContactEventType.persist:
+            type = FContactEventType.persist;
+          default:
+            // The ring overflowed and some begin/end events are gone, so the
+            // running counts cannot be trusted. Recount from the bodies.
+            resync = true;
+            continue;
+        }
+        contactEvent.emit(
+          FContactEvent(
+            type: type,
+            bodyA: e.bodyA,
+            bodyB: e.bodyB,
+            point: Offset(e.x, e.y),
+            normal: Offset(e.normalX, e.normalY),
+            approachSpeed: e.approachSpeed,
+          ),
+        );
+      }
+    } while (count == _eventCapacity);
 
-    while (_accumulator >= _fixedDt) {
-      native.stepPhysics(world, _fixedDt);
-      _accumulator -= _fixedDt;
+    if (resync) {
+      for (final body in _bodies.values) {
+        body._contactCount = getCollisionCount(world, body.bodyId);
+      }
     }
   }
 
   void dispose() {
+    _systems.remove(world.address);
+    _bodies.clear();
+    calloc.free(_events);
+    calloc.free(_states);
     native.destroyPhysicsWorld(world);
   }
 
@@ -90,6 +322,116 @@ class FPhysicsSystem {
     );
   }
 
+  /// Creates a convex polygon body: the convex hull of [vertices], up to 8,
+  /// given relative to ([x], [y]). The body's position is the hull's centroid
+  /// rather than ([x], [y]), since that is what it rotates about. Returns -1
+  /// if the points do not span an area or there are more than 8.
+  static BodyId createPolygonBody(
+    WorldId world,
+    int type,
+    double x,
+    double y,
+    double rotation,
+    List<v.Vector2> vertices,
+    int categoryBits,
+    int maskBits,
+  ) {
+    final buffer = calloc<Float>(vertices.length * 2);
+    try {
+      for (int i = 0; i < vertices.length; i++) {
+        buffer[2 * i] = vertices[i].x;
+        buffer[2 * i + 1] = vertices[i].y;
+      }
+      return native.createPolygonBody(world, type, x, y, rotation, buffer, vertices.length, categoryBits, maskBits);
+    } finally {
+      calloc.free(buffer);
+    }
+  }
+
+  /// The hull of a polygon body in its local frame, counter-clockwise about
+  /// its position. Empty for other shapes.
+  static List<v.Vector2> getPolygonVertices(WorldId world, BodyId bodyId) {
+    final buffer = calloc<Float>(16);
+    try {
+      final count = native.getPolygonVertices(world, bodyId, buffer, 8);
+      return List<v.Vector2>.generate(count, (i) => v.Vector2(buffer[2 * i], buffer[2 * i + 1]));
+    } finally {
+      calloc.free(buffer);
+    }
+  }
+
+  /// Creates a static chain body for terrain: one-sided segments joining
+  /// [vertices], in world space. Segments collide from their right-hand side
+  /// only, so list a surface right to left to make its top solid, and wind a
+  /// [loop] counter-clockwise to make its outside solid. Bodies slide across
+  /// the joins without catching on them. Returns -1 for fewer than 2
+  /// distinct points (3 for a loop), or for more than 65536 segments.
+  static BodyId createChainBody(
+    WorldId world,
+    List<v.Vector2> vertices, {
+    bool loop = false,
+    int categoryBits = 0x0001,
+    int maskBits = 0xFFFF,
+  }) {
+    final buffer = calloc<Float>(vertices.length * 2);
+    try {
+      for (int i = 0; i < vertices.length; i++) {
+        buffer[2 * i] = vertices[i].x;
+        buffer[2 * i + 1] = vertices[i].y;
+      }
+      return native.createChainBody(world, buffer, vertices.length, loop ? 1 : 0, categoryBits, maskBits);
+    } finally {
+      calloc.free(buffer);
+    }
+  }
+
+  /// Creates [count] bodies in one native call. [define] fills in body `i`;
+  /// fields it leaves alone take [createBody]'s defaults. Returns the ids in
+  /// order, -1 for any the pool had no room for and for polygon or chain
+  /// shapes, which need [createPolygonBody] or [createChainBody].
+  ///
+  /// For level loads and bursts: besides saving a call per body, the batch
+  /// goes into the broadphase together, which for a batch larger than the
+  /// world so far is one balanced build rather than an insert per body.
+  static List<BodyId> createBodies(WorldId world, int count, void Function(int i, BodyDef def) define) {
+    if (count <= 0) return const [];
+    final defs = calloc<BodyDef>(count);
+    final ids = calloc<Int32>(count);
+    try {
+      for (int i = 0; i < count; i++) {
+        final def = (defs + i).ref
+          ..type = FPhysics.dynamicBody
+          ..shapeType = FPhysics.circle
+          ..width = 50
+          ..height = 50
+          ..restitution = 0.2
+          ..friction = 0.4
+          ..categoryBits = 0x0001
+          ..maskBits = 0xFFFF;
+        define(i, def);
+      }
+      native.createBodies(world, defs, count, ids);
+      return List<BodyId>.generate(count, (i) => ids[i]);
+    } finally {
+      calloc.free(defs);
+      calloc.free(ids);
+    }
+  }
+
+  /// Releases every body in [ids] in one native call. Ids that are not live
+  /// bodies are skipped. Bodies owned by an [FPhysicsBody] should be released
+  /// by disposing it instead.
+  static void destroyBodies(WorldId world, List<BodyId> ids) {
+    if (ids.isEmpty) return;
+    final buffer = calloc<Int32>(ids.length);
+    try {
+      buffer.asTypedList(ids.length).setAll(0, ids);
+      native.destroyBodies(world, buffer, ids.length);
+    } finally {
+      calloc.free(buffer);
+    }
+  }
+
   static void setBodyVelocity(WorldId world, BodyId bodyId, double vx, double vy) {
     native.setBodyVelocity(world, bodyId, vx, vy);
   }
@@ -142,8 +484,18 @@ class FPhysicsSystem {
     return _getBodyPtr(world, bodyId).ref.collisionCount;
   }
 
+  /// Whether the body is being simulated. Bodies sleep with their island —
+  /// everything they touch, transitively — once it has all been still for
+  /// half a second, and wake when anything awake touches it or the body is
+  /// pushed through the API.
+  static bool isAwake(WorldId world, BodyId bodyId) {
+    return _getBodyPtr(world, bodyId).ref.isAwake != 0;
+  }
+
+  /// Goes through the native side rather than the body struct: the
+  /// broadphase keeps its own copy of the filter to skip layers with.
   static void setCategoryBits(WorldId world, BodyId bodyId, int bits) {
-    _getBodyPtr(world, bodyId).ref.categoryBits = bits;
+    native.setBodyFilter(world, bodyId, bits, getMaskBits(world, bodyId));
   }
 
   static int getCategoryBits(WorldId world, BodyId bodyId) {
@@ -151,16 +503,34 @@ class FPhysicsSystem {
   }
 
   static void setMaskBits(WorldId world, BodyId bodyId, int bits) {
-    _getBodyPtr(world, bodyId).ref.maskBits = bits;
+    native.setBodyFilter(world, bodyId, getCategoryBits(world, bodyId), bits);
   }
 
   static int getMaskBits(WorldId world, BodyId bodyId) {
     return _getBodyPtr(world, bodyId).ref.maskBits;
   }
 
+  /// Marks a body as a bullet: fast enough to pass through thin geometry in
+  /// one step. After each step a bullet that moved more than half its size is
+  /// swept from where it started to where it ended, and pulled back to the
+  /// first thing it would have hit. Other bodies are not swept, so keep it to
+  /// the few that need it.
+  static void setBullet(WorldId world, BodyId bodyId, bool value) {
+    _getBodyPtr(world, bodyId).ref.isBullet = value ? 1 : 0;
+  }
+
+  static bool isBullet(WorldId world, BodyId bodyId) {
+    return _getBodyPtr(world, bodyId).ref.isBullet != 0;
+  }
+
   // --- RayCast ---
-  static RayCastHit? rayCast(WorldId world, double fromX, double fromY, double toX, double toY) {
-    final result = native.rayCast(world, fromX, fromY, toX, toY);
+
+  /// The nearest body the segment hits, or null. With [maskBits], only
+  /// bodies whose category bits share a bit with it are considered, and the
+  /// broadphase skips the rest without testing them.
+  static RayCastHit? rayCast(WorldId world, double fromX, double fromY, double toX, double toY,
+      {int maskBits = 0xFFFFFFFF}) {
+    final result = native.rayCast(world, fromX, fromY, toX, toY, maskBits);
     if (result.hit != 0) return result;
     return null;
   }
@@ -208,6 +578,71 @@ class FPhysicsSystem {
   }
 }
 
+/// What a [FContactEvent] reports.
+enum FContactEventType {
+  /// The two bodies started touching.
+  begin,
+
+  /// They stopped touching, or one of them was removed.
+  end,
+
+  /// They are still touching; only with [FPhysicsSystem.persistContactEvents].
+  persist,
+}
+
+/// A change in contact between two bodies, from [FPhysicsSystem.contactEvent].
+class FContactEvent {
+  const FContactEvent({
+    required this.type,
+    required this.bodyA,
+    required this.bodyB,
+    required this.point,
+    required this.normal,
+    required this.approachSpeed,
+  });
+
+  final FContactEventType type;
+
+  /// The pair, lower id first.
+  final BodyId bodyA;
+  final BodyId bodyB;
+
+  /// Centre of the contact, in world units. For [FContactEventType.end] it is
+  /// where the bodies last touched.
+  final Offset point;
+
+  /// Unit normal from [bodyA] towards [bodyB].
+  final Offset normal;
+
+  /// Closing speed along [normal] at [point] before the solver ran, in world
+  /// units per second; 0 when the bodies were separating. Always 0 for
+  /// [FContactEventType.end].
+  final double approachSpeed;
+}
+
+/// Which contact solver the native core runs; see [FPhysicsSystem.solverMode].
+/// Indices match the native `SolverMode` enum.
+enum FSolverMode { ngs, softStep }
+
+/// What holds the moving bodies for broadphase queries; see
+/// [FPhysicsSystem.broadphase]. Static bodies are always in a tree. Indices
+/// match the native `Broadphase` enum.
+///
+/// [tree] suits most scenes, and is the fastest for long raycasts.
+/// [grid] and [sortAndSweep] suit thousands of similar-sized bodies moving
+/// in a bounded arena, where they spend far less keeping up with the motion;
+/// [sortAndSweep] also answers box queries fastest.
+enum FBroadphase { tree, grid, sortAndSweep }
+
+/// How the broadphase tree follows moving bodies; see
+/// [FPhysicsSystem.broadphaseRebuild]. Indices match the native
+/// `BroadphaseRebuild` enum.
+enum FBroadphaseRebuild { reinsert, incremental }
+
+/// How the native contact solver uses the thread pool. Indices match the
+/// native `SolverThreading` enum.
+enum FSolverThreading { serial, graphColored, islands }
+
 class FPhysics {
   // Conversion constants
   static const double pixelsToMeters = 1.0 / 50.0;
@@ -224,6 +659,8 @@ class FPhysics {
   // Shapes
   static const int circle = 0;
   static const int box = 1;
+  static const int polygon = 2;
+  static const int chain = 3;
 }
 
 class FPhysicsBody extends FNode {
@@ -237,6 +674,11 @@ class FPhysicsBody extends FNode {
   final int shapeType; // Store the shape type for correct rendering
   final WorldId _world;
 
+  /// A polygon body's hull, local to its position; empty for other shapes.
+  late final List<v.Vector2> vertices = shapeType == FPhysics.polygon
+      ? FPhysicsSystem.getPolygonVertices(_world, bodyId)
+      : const [];
+
   // -- Signals --
 
   /// Emitted when this body collides
@@ -253,16 +695,43 @@ class FPhysicsBody extends FNode {
 
   bool _wasColliding = false;
 
+  /// Contacts begun and not yet ended, kept by [FPhysicsSystem] from the
+  /// native event stream.
+  int _contactCount = 0;
+
+  /// Whether a contact began since the last sync, so that one which begins
+  /// and ends between two frames is still seen.
+  bool _contactBeganSinceSync = false;
+
+  void _contactBegan() {
+    _contactCount++;
+    _contactBeganSinceSync = true;
+  }
+
+  void _contactEnded() {
+    // A slot reused before the drain can receive the END of its previous
+    // owner's contacts, ahead of any BEGIN of its own.
+    if (_contactCount > 0) _contactCount--;
+  }
+
   /// Whether the native solver reported contacts for this body last frame.
   bool get isColliding => _wasColliding;
 
+  /// Simulated pose as of the last [FPhysicsSystem.update], written by its
+  /// bulk export.
+  double _poseX, _poseY, _poseRotation;
+
   // Mutable debug flag
   bool debugDraw;
 
+  /// Passing [vertices] makes a convex polygon body (see
+  /// [FPhysicsSystem.createPolygonBody]) whatever [shapeType] says. Its
+  /// position is then the hull's centroid, not ([x], [y]).
   FPhysicsBody({
     required WorldId world,
     int type = 2, // DYNAMIC
-    this.shapeType = FPhysics.circle,
+    int shapeType = FPhysics.circle,
+    List<v.Vector2>? vertices,
     double x = 0,
     double y = 0,
     this.width = 50,
@@ -275,21 +744,36 @@ class FPhysicsBody extends FNode {
     double friction = 0.1,
     int categoryBits = 0x0001,
     int maskBits = 0xFFFF,
+    bool bullet = false,
   }) : _world = world,
-       bodyId = FPhysicsSystem.createBody(
-         world,
-         type,
-         shapeType,
-         x,
-         y,
-         width,
-         height,
-         rotation,
-         categoryBits,
-         maskBits,
-       ) {
+       shapeType = vertices == null ? shapeType : FPhysics.polygon,
+       _poseX = x,
+       _poseY = y,
+       _poseRotation = rotation,
+       bodyId = vertices == null
+           ? FPhysicsSystem.createBody(
+               world,
+               type,
+               shapeType,
+               x,
+               y,
+               width,
+               height,
+               rotation,
+               categoryBits,
+               maskBits,
+             )
+           : FPhysicsSystem.createPolygonBody(world, type, x, y, rotation, vertices, categoryBits, maskBits) {
+    if (vertices != null && bodyId >= 0) {
+      // Native recentred the body on the hull's centroid.
+      final centroid = FPhysicsSystem.getBodyPosition(world, bodyId);
+      _poseX = centroid.dx;
+      _poseY = centroid.dy;
+    }
     this.restitution = restitution;
     this.friction = friction;
+    isBullet = bullet;
+    FPhysicsSystem._registerBody(this);
     _syncFromPhysics();
   }
 
@@ -309,9 +793,16 @@ class FPhysicsBody extends FNode {
   double get friction => FPhysicsSystem.getFriction(_world, bodyId);
   set friction(double value) => FPhysicsSystem.setFriction(_world, bodyId, value);
 
+  /// Whether this body gets continuous collision; see [FPhysicsSystem.setBullet].
+  bool get isBullet => FPhysicsSystem.isBullet(_world, bodyId);
+  set isBullet(bool value) => FPhysicsSystem.setBullet(_world, bodyId, value);
+
   /// Get the native physics world pointer
   WorldId get world => _world;
 
+  /// Whether the body is awake; see [FPhysicsSystem.isAwake].
+  bool get isAwake => FPhysicsSystem.isAwake(_world, bodyId);
+
   bool _released = false;
 
   /// Whether this node still owns a native body.
@@ -329,6 +820,7 @@ class FPhysicsBody extends FNode {
   void _releaseNativeBody() {
     if (_released) return;
     _released = true;
+    FPhysicsSystem._unregisterBody(this);
     native.destroyBody(_world, bodyId);
   }
 
@@ -352,6 +844,13 @@ class FPhysicsBody extends FNode {
 
     if (shapeType == FPhysics.circle) {
       canvas.drawCircle(Offset.zero, width / 2, paint);
+    } else if (shapeType == FPhysics.polygon) {
+      if (vertices.isEmpty) return;
+      final path = Path()..moveTo(vertices.first.x, vertices.first.y);
+      for (final vertex in vertices.skip(1)) {
+        path.lineTo(vertex.x, vertex.y);
+      }
+      canvas.drawPath(path..close(), paint);
     } else {
       final visibleRect = Rect.fromCenter(center: Offset.zero, width: width, height: height);
       canvas.drawRect(visibleRect, paint);
@@ -377,8 +876,20 @@ class FPhysicsBody extends FNode {
   }
 
   void _syncFromPhysics() {
-    final pos = FPhysicsSystem.getBodyPosition(_world, bodyId);
-    final rot = FPhysicsSystem.getRotation(_world, bodyId);
+    final system = FPhysicsSystem._systems[_world.address];
+    final Offset pos;
+    final double rot;
+    if (system != null && system.interpolation) {
+      final pose = (system._poses + bodyId).ref;
+      pos = Offset(pose.x, pose.y);
+      rot = pose.rotation;
+    } else if (system != null) {
+      pos = Offset(_poseX, _poseY);
+      rot = _poseRotation;
+    } else {
+      pos = FPhysicsSystem.getBodyPosition(_world, bodyId);
+      rot = FPhysicsSystem.getRotation(_world, bodyId);
+    }
 
     if (pos.dx.isNaN || pos.dy.isNaN || rot.isNaN) {
       return;
@@ -387,10 +898,11 @@ class FPhysicsBody extends FNode {
     transform.position = v.Vector3(pos.dx, pos.dy, 0);
     transform.rotation = v.Vector3(0, 0, rot);
 
-    // Contact feedback from the native core. It reports a count, not the
-    // counterpart body, so enter/exit are derived from the count going
-    // non-zero and back.
-    final touching = FPhysicsSystem.getCollisionCount(_world, bodyId) > 0;
+    // Contact state comes from the world's event stream, already drained by
+    // FPhysicsSystem.update; reading collision_count here was a native read
+    // per body per frame.
+    final touching = _contactCount > 0 || _contactBeganSinceSync;
+    _contactBeganSinceSync = false;
     if (touching) {
       collision.emit(this);
       if (!_wasColliding) collisionEntered.emit(this);
@@ -28,6 +28,12 @@ enum FlashStructId {
     kStructNativeBody = 6,
     kStructRayCastHit = 7,
     kStructJointDef = 8,
+    kStructContactEvent = 9,
+    kStructBodyPose = 10,
+    kStructBodyState = 11,
+    kStructBodyDef = 12,
+    kStructBroadphaseStats = 13,
+    kStructManifoldPoint = 14,
 };
 
 FLASH_API int32_t get_struct_size(int32_t structId) {
@@ -41,6 +47,12 @@ FLASH_API int32_t get_struct_size(int32_t structId) {
         case kStructNativeBody:      return (int32_t)sizeof(NativeBody);
         case kStructRayCastHit:      return (int32_t)sizeof(RayCastHit);
         case kStructJointDef:        return (int32_t)sizeof(JointDef);
+        case kStructContactEvent:    return (int32_t)sizeof(ContactEvent);
+        case kStructBodyPose:        return (int32_t)sizeof(BodyPose);
+        case kStructBodyState:       return (int32_t)sizeof(BodyState);
+        case kStructBodyDef:         return (int32_t)sizeof(BodyDef);
+        case kStructBroadphaseStats: return (int32_t)sizeof(BroadphaseStats);
+        case kStructManifoldPoint:   return (int32_t)sizeof(ManifoldPoint);
         default:                     return -1;
     }
 }
@@ -66,6 +78,9 @@ enum FlashFieldId {
     kFieldEmitterActiveCount = 15,
     kFieldEmitterShapeType = 16,
     kFieldRayHit = 17,
+    kFieldContactEventApproachSpeed = 18,
+    kFieldBodyIsBullet = 19,
+    kFieldBodyQ = 20,
 };
 
 FLASH_API int32_t get_field_offset(int32_t fieldId) {
@@ -88,6 +103,9 @@ FLASH_API int32_t get_field_offset(int32_t fieldId) {
         case kFieldEmitterActiveCount: return (int32_t)offsetof(ParticleEmitter, activeCount);
         case kFieldEmitterShapeType:   return (int32_t)offsetof(ParticleEmitter, shapeType);
         case kFieldRayHit:             return (int32_t)offsetof(RayCastHit, hit);
+        case kFieldContactEventApproachSpeed: return (int32_t)offsetof(ContactEvent, approachSpeed);
+        case kFieldBodyIsBullet:       return (int32_t)offsetof(NativeBody, isBullet);
+        case kFieldBodyQ:              return (int32_t)offsetof(NativeBody, q);
         default:                       return -1;
     }
 }
@@ -1,5 +1,10 @@
 #include "broadphase.h"
 #include "physics.h"
+#include "polygon.h"
+#include "sort_and_sweep.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+#include "wide_tree.h"
 #include <cmath>
 #include <algorithm>
 
@@ -8,6 +13,14 @@ extern "C" {
 // --- Dynamic AABB Tree Implementation ---
 
 namespace {
+    // The tree changed shape: its wide copy must be rebuilt before it is
+    // used again.
+    void reshaped(DynamicTree* tree) {
+        if (!tree->wide) return;
+        tree->wide->stale = true;
+        tree->wide->work = 0;
+    }
+
     // Allocation helper
     int32_t allocate_node(DynamicTree* tree) {
         if (tree->freeList == -1) {
@@ -36,6 +49,8 @@ namespace {
         tree->nodes[nodeId].right = -1;
         tree->nodes[nodeId].height = 0;
         tree->nodes[nodeId].bodyId = 0xFFFFFFFF;
+        tree->nodes[nodeId].moved = false;
+        tree->nodes[nodeId].enlarged = false;
         tree->nodeCount++;
         return nodeId;
     }
@@ -171,14 +186,86 @@ namespace {
         
         return iA;
     }
+
+    AABB union_of(const AABB& a, const AABB& b) {
+        AABB c;
+        c.minX = std::min(a.minX, b.minX);
+        c.minY = std::min(a.minY, b.minY);
+        c.maxX = std::max(a.maxX, b.maxX);
+        c.maxY = std::max(a.maxY, b.maxY);
+        return c;
+    }
+
+    // Recomputes an internal node's AABB, height and filter bits from its
+    // children, and keeps it enlarged if either child is, so tree_rebuild can
+    // reach them.
+    void refit(DynamicTree* tree, int32_t index) {
+        TreeNode& node = tree->nodes[index];
+        const TreeNode& l = tree->nodes[node.left];
+        const TreeNode& r = tree->nodes[node.right];
+        node.aabb = union_of(l.aabb, r.aabb);
+        node.height = 1 + std::max(l.height, r.height);
+        node.enlarged = node.enlarged || l.enlarged || r.enlarged;
+        node.categoryBits = l.categoryBits | r.categoryBits;
+        node.maskBits = l.maskBits | r.maskBits;
+    }
+
+    // Box2D v3's b2RotateNodes. AVL balancing only compares heights, so a
+    // long session of churn leaves trees that are balanced but loose: wide
+    // internal boxes that every query has to open. This swaps one of A's
+    // children with a grandchild on the other side when that shrinks the
+    // perimeter of the node in between, and picks the best of the four
+    // swaps. A swap that would make A taller is skipped, so the height still
+    // follows AVL's: a query's cost grows with the levels it walks down.
+    void rotate_nodes(DynamicTree* tree, int32_t iA) {
+        TreeNode* nodes = tree->nodes;
+        if (nodes[iA].height < 2) return;
+
+        int32_t bestX = -1, bestO = -1, bestY = -1;
+        float bestGain = 0.0f;
+        const int32_t children[2] = {nodes[iA].left, nodes[iA].right};
+        for (int side = 0; side < 2; ++side) {
+            const int32_t x = children[side];
+            const int32_t o = children[1 - side];
+            if (nodes[o].isLeaf()) continue;
+            const float base = nodes[o].aabb.perimeter();
+            for (int k = 0; k < 2; ++k) {
+                const int32_t y = k == 0 ? nodes[o].left : nodes[o].right;
+                const int32_t z = k == 0 ? nodes[o].right : nodes[o].left;
+                const int32_t height = 1 + std::max(1 + std::max(nodes[x].height, nodes[z].height), nodes[y].height);
+                if (height > nodes[iA].height) continue;
+                const float gain = base - union_of(nodes[x].aabb, nodes[z].aabb).perimeter();
+                if (gain > bestGain) {
+                    bestGain = gain;
+                    bestX = x;
+                    bestO = o;
+                    bestY = y;
+                }
+            }
+        }
+        if (bestX == -1) return;
+
+        if (nodes[iA].left == bestX) nodes[iA].left = bestY;
+        else nodes[iA].right = bestY;
+        if (nodes[bestO].left == bestY) nodes[bestO].left = bestX;
+        else nodes[bestO].right = bestX;
+        nodes[bestX].parent = bestO;
+        nodes[bestY].parent = iA;
+        refit(tree, bestO);
+        refit(tree, iA);
+    }
 }
 
-DynamicTree* create_dynamic_tree(int initialCapacity) {
+DynamicTree* create_dynamic_tree(int initialCapacity, int32_t type) {
     DynamicTree* tree = new DynamicTree();
+    if (type == BROADPHASE_GRID) tree->grid = create_spatial_grid(initialCapacity, kGridDefaultCellSize);
+    if (type == BROADPHASE_SORT_AND_SWEEP) tree->sweep = create_sort_and_sweep();
+    if (!tree->grid && !tree->sweep) tree->wide = create_wide_tree();
     tree->nodeCapacity = initialCapacity;
     tree->nodes = new TreeNode[initialCapacity];
     tree->nodeCount = 0;
     tree->root = -1;
+    tree->parallelThreshold = kPairParallelThreshold;
     
     // Build free list
     for (int32_t i = 0; i < initialCapacity - 1; ++i) {
@@ -194,19 +281,23 @@ DynamicTree* create_dynamic_tree(int initialCapacity) {
 
 void destroy_dynamic_tree(DynamicTree* tree) {
     if (!tree) return;
+    destroy_spatial_grid(tree->grid);
+    destroy_sort_and_sweep(tree->sweep);
+    destroy_wide_tree(tree->wide);
     delete[] tree->nodes;
     delete tree;
 }
 
-int32_t tree_insert_leaf(DynamicTree* tree, uint32_t bodyId, const AABB& aabb) {
-    int32_t leafId = allocate_node(tree);
-    tree->nodes[leafId].aabb = aabb;
-    tree->nodes[leafId].bodyId = bodyId;
-    tree->nodes[leafId].height = 0;
+namespace {
+// Links an allocated leaf into the tree at its aabb.
+void insert_leaf(DynamicTree* tree, int32_t leafId) {
+    reshaped(tree);
+    const AABB aabb = tree->nodes[leafId].aabb;
     
     if (tree->root == -1) {
         tree->root = leafId;
-        return leafId;
+        tree->nodes[leafId].parent = -1;
+        return;
     }
     
     // Find best sibling (simple cost based on area increase)
@@ -302,30 +393,23 @@ int32_t tree_insert_leaf(DynamicTree* tree, uint32_t bodyId, const AABB& aabb) {
         tree->root = newParent;
     }
     
-    // Back-propagate height and AABB up and balance
+    // Back-propagate height and AABB up, balance, then rotate for area
     index = tree->nodes[leafId].parent;
     while (index != -1) {
+        const int32_t unbalanced = index;
         index = balance(tree, index);
-        
-        int32_t left = tree->nodes[index].left;
-        int32_t right = tree->nodes[index].right;
-        
-        tree->nodes[index].height = 1 + std::max(tree->nodes[left].height, tree->nodes[right].height);
-        tree->nodes[index].aabb.minX = std::min(tree->nodes[left].aabb.minX, tree->nodes[right].aabb.minX);
-        tree->nodes[index].aabb.minY = std::min(tree->nodes[left].aabb.minY, tree->nodes[right].aabb.minY);
-        tree->nodes[index].aabb.maxX = std::max(tree->nodes[left].aabb.maxX, tree->nodes[right].aabb.maxX);
-        tree->nodes[index].aabb.maxY = std::max(tree->nodes[left].aabb.maxY, tree->nodes[right].aabb.maxY);
-        
+        if (index != unbalanced) refit(tree, unbalanced);
+        refit(tree, index);
+        rotate_nodes(tree, index);
         index = tree->nodes[index].parent;
     }
-    
-    return leafId;
 }
 
-void tree_remove_leaf(DynamicTree* tree, int32_t leafId) {
+// Unlinks a leaf, freeing its parent but not the leaf itself.
+void remove_leaf(DynamicTree* tree, int32_t leafId) {
+    reshaped(tree);
     if (leafId == tree->root) {
         tree->root = -1;
-        free_node(tree, leafId);
         return;
     }
     
@@ -341,14 +425,10 @@ void tree_remove_leaf(DynamicTree* tree, int32_t leafId) {
         
         int32_t index = grandParent;
         while (index != -1) {
+            const int32_t unbalanced = index;
             index = balance(tree, index);
-            int32_t left = tree->nodes[index].left;
-            int32_t right = tree->nodes[index].right;
-            tree->nodes[index].aabb.minX = std::min(tree->nodes[left].aabb.minX, tree->nodes[right].aabb.minX);
-            tree->nodes[index].aabb.minY = std::min(tree->nodes[left].aabb.minY, tree->nodes[right].aabb.minY);
-            tree->nodes[index].aabb.maxX = std::max(tree->nodes[left].aabb.maxX, tree->nodes[right].aabb.maxX);
-            tree->nodes[index].aabb.maxY = std::max(tree->nodes[left].aabb.maxY, tree->nodes[right].aabb.maxY);
-            tree->nodes[index].height = 1 + std::max(tree->nodes[left].height, tree->nodes[right].height);
+            if (index != unbalanced) refit(tree, unbalanced);
+            refit(tree, index);
             index = tree->nodes[index].parent;
         }
     } else {
@@ -356,75 +436,637 @@ void tree_remove_leaf(DynamicTree* tree, int32_t leafId) {
         tree->nodes[sibling].parent = -1;
         free_node(tree, parent);
     }
-    
+}
+
+// Drops removed leaves from the move buffer, so a later leaf reusing the
+// node is not queried on their account.
+void unbuffer_moves(DynamicTree* tree, const int32_t* proxyIds, int count) {
+    if (tree->moveBuffer.empty()) return;
+    for (int i = 0; i < count; ++i) {
+        if (!tree->nodes[proxyIds[i]].moved) continue;
+        tree->nodes[proxyIds[i]].moved = false;
+        for (int32_t& entry : tree->moveBuffer) {
+            if (entry == proxyIds[i]) entry = -1;
+        }
+    }
+}
+
+// insert_leaf and remove_leaf, or their grid and sort-and-sweep equivalents.
+void link_leaf(DynamicTree* tree, int32_t leafId) {
+    if (tree->grid) grid_insert(tree->grid, leafId, tree->nodes[leafId].aabb);
+    else if (tree->sweep) sweep_insert(tree->sweep, leafId);
+    else insert_leaf(tree, leafId);
+}
+
+void unlink_leaf(DynamicTree* tree, int32_t leafId) {
+    if (tree->grid) grid_remove(tree->grid, leafId, tree->nodes[leafId].aabb);
+    else if (tree->sweep) sweep_remove(tree->sweep, leafId);
+    else remove_leaf(tree, leafId);
+}
+}
+
+int32_t tree_insert_leaf(DynamicTree* tree, uint32_t bodyId, const AABB& aabb, TreeFilter filter) {
+    int32_t leafId = allocate_node(tree);
+    tree->nodes[leafId].aabb = aabb;
+    tree->nodes[leafId].bodyId = bodyId;
+    tree->nodes[leafId].height = 0;
+    tree->nodes[leafId].categoryBits = filter.categoryBits;
+    tree->nodes[leafId].maskBits = filter.maskBits;
+    link_leaf(tree, leafId);
+    return leafId;
+}
+
+void tree_remove_leaf(DynamicTree* tree, int32_t leafId) {
+    unbuffer_moves(tree, &leafId, 1);
+    unlink_leaf(tree, leafId);
     free_node(tree, leafId);
 }
 
-int32_t tree_update_leaf(DynamicTree* tree, int32_t proxyId, const AABB& aabb) {
-    uint32_t bodyId = tree->nodes[proxyId].bodyId;
-    tree_remove_leaf(tree, proxyId);
-    return tree_insert_leaf(tree, bodyId, aabb);
+namespace {
+    void collect_leaves(const DynamicTree* tree, std::vector<int32_t>& leaves) {
+        if (tree->root == -1) return;
+        std::vector<int32_t> stack;
+        stack.push_back(tree->root);
+        while (!stack.empty()) {
+            const int32_t curr = stack.back();
+            stack.pop_back();
+            if (tree->nodes[curr].isLeaf()) leaves.push_back(curr);
+            else {
+                stack.push_back(tree->nodes[curr].left);
+                stack.push_back(tree->nodes[curr].right);
+            }
+        }
+    }
+
+    // Frees every internal node, leaving the leaves allocated but detached.
+    void free_internal_nodes(DynamicTree* tree) {
+        if (tree->root == -1) return;
+        std::vector<int32_t> stack;
+        stack.push_back(tree->root);
+        while (!stack.empty()) {
+            const int32_t curr = stack.back();
+            stack.pop_back();
+            if (tree->nodes[curr].isLeaf()) continue;
+            stack.push_back(tree->nodes[curr].left);
+            stack.push_back(tree->nodes[curr].right);
+            free_node(tree, curr);
+        }
+        tree->root = -1;
+    }
+
+    // Bins per SAH split, as in Box2D v3's b2PartitionSAH.
+    constexpr int kSahBins = 64;
+    // Past this depth the build splits at the median instead. SAH can peel
+    // one leaf off at a time (bodies spaced out geometrically, say), and a
+    // tree that deep costs every query a level per leaf peeled off. Walks
+    // that outgrow TreeStack spill to the heap, so depth is a matter of
+    // speed, not of losing subtrees.
+    constexpr int kMaxSahDepth = 32;
+
+    // Top-down build over `count` nodes, leaves or whole subtrees. Each
+    // split buckets the centres into kSahBins along the longer axis of their
+    // bounds and takes the plane with the least left-area * left-count +
+    // right-area * right-count, which keeps wide boxes out of the way of
+    // small ones where an even split in count would not. Returns the root.
+    int32_t build_subtree(DynamicTree* tree, int32_t* leaves, int count, int depth = 0) {
+        if (count == 1) return leaves[0];
+
+        float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+        for (int i = 0; i < count; ++i) {
+            const AABB& b = tree->nodes[leaves[i]].aabb;
+            const float cx = b.minX + b.maxX, cy = b.minY + b.maxY;
+            minX = std::min(minX, cx); maxX = std::max(maxX, cx);
+            minY = std::min(minY, cy); maxY = std::max(maxY, cy);
+        }
+        const bool splitX = maxX - minX >= maxY - minY;
+        const float lo = splitX ? minX : minY;
+        const float extent = splitX ? maxX - minX : maxY - minY;
+        const TreeNode* nodes = tree->nodes;
+        auto centre = [nodes, splitX](int32_t n) {
+            const AABB& b = nodes[n].aabb;
+            return splitX ? b.minX + b.maxX : b.minY + b.maxY;
+        };
+
+        int split = 0;
+        if (extent > 0.0f && depth < kMaxSahDepth) {
+            const float scale = kSahBins / extent;
+            auto bin_of = [&](int32_t n) { return std::min(kSahBins - 1, (int)((centre(n) - lo) * scale)); };
+
+            AABB binBox[kSahBins];
+            int binCount[kSahBins] = {};
+            for (int i = 0; i < count; ++i) {
+                const int b = bin_of(leaves[i]);
+                binBox[b] = binCount[b] == 0 ? nodes[leaves[i]].aabb : union_of(binBox[b], nodes[leaves[i]].aabb);
+                binCount[b]++;
+            }
+
+            // rightArea[p] is the area right of plane p, between bins p - 1
+            // and p.
+            float rightArea[kSahBins];
+            int rightCount[kSahBins];
+            AABB box{INFINITY, INFINITY, -INFINITY, -INFINITY};
+            int n = 0;
+            for (int p = kSahBins - 1; p > 0; --p) {
+                if (binCount[p] > 0) box = union_of(box, binBox[p]);
+                n += binCount[p];
+                rightArea[p] = n > 0 ? box.perimeter() : 0.0f;
+                rightCount[p] = n;
+            }
+
+            float bestCost = INFINITY;
+            int bestPlane = 0;
+            box = AABB{INFINITY, INFINITY, -INFINITY, -INFINITY};
+            n = 0;
+            for (int p = 1; p < kSahBins; ++p) {
+                if (binCount[p - 1] > 0) box = union_of(box, binBox[p - 1]);
+                n += binCount[p - 1];
+                if (n == 0 || rightCount[p] == 0) continue;
+                const float cost = box.perimeter() * n + rightArea[p] * rightCount[p];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestPlane = p;
+                }
+            }
+            if (bestPlane > 0) {
+                split = (int)(std::partition(leaves, leaves + count,
+                                             [&](int32_t leaf) { return bin_of(leaf) < bestPlane; }) -
+                              leaves);
+            }
+        }
+        if (split == 0 || split == count) {
+            // Every centre in one place, or past kMaxSahDepth.
+            split = count / 2;
+            std::nth_element(leaves, leaves + split, leaves + count,
+                             [&](int32_t a, int32_t b) { return centre(a) < centre(b); });
+        }
+
+        const int32_t left = build_subtree(tree, leaves, split, depth + 1);
+        const int32_t right = build_subtree(tree, leaves + split, count - split, depth + 1);
+        // allocate_node may grow (and move) the node array, so index afresh.
+        const int32_t parent = allocate_node(tree);
+        tree->nodes[parent].left = left;
+        tree->nodes[parent].right = right;
+        refit(tree, parent);
+        tree->nodes[left].parent = parent;
+        tree->nodes[right].parent = parent;
+        return parent;
+    }
+
+    void rebuild_from_leaves(DynamicTree* tree, std::vector<int32_t>& leaves) {
+        reshaped(tree);
+        free_internal_nodes(tree);
+        if (leaves.empty()) return;
+        tree->root = build_subtree(tree, leaves.data(), (int)leaves.size());
+        tree->nodes[tree->root].parent = -1;
+    }
 }
 
-int query_tree_pairs(DynamicTree* tree, BroadphasePair* outPairs, int maxPairs) {
+void tree_insert_leaves(DynamicTree* tree, const uint32_t* bodyIds, const AABB* aabbs,
+                        const TreeFilter* filters, int count, int32_t* outProxyIds) {
+    if (count <= 0) return;
+    auto filter_of = [filters](int i) { return filters ? filters[i] : kTreeFilterAll; };
+    if (tree->grid || tree->sweep) {
+        // Filing a leaf is already cheap; a batch that is most of the grid
+        // gets a cell size to fit it.
+        const bool most = count >= tree->nodeCount;
+        for (int i = 0; i < count; ++i) outProxyIds[i] = tree_insert_leaf(tree, bodyIds[i], aabbs[i], filter_of(i));
+        if (most && tree->grid) tree_rebuild(tree, true);
+        return;
+    }
+    std::vector<int32_t> leaves;
+    collect_leaves(tree, leaves);
+    if ((size_t)count < leaves.size()) {
+        for (int i = 0; i < count; ++i) outProxyIds[i] = tree_insert_leaf(tree, bodyIds[i], aabbs[i], filter_of(i));
+        return;
+    }
+
+    // Level loads land here: hundreds of bodies into an empty or small tree.
+    // Each incremental insert walks the tree and rebalances on the way up;
+    // one SAH build over all the leaves does neither, and sees every leaf
+    // before it places any.
+    for (int i = 0; i < count; ++i) {
+        const int32_t leaf = allocate_node(tree);
+        tree->nodes[leaf].aabb = aabbs[i];
+        tree->nodes[leaf].bodyId = bodyIds[i];
+        tree->nodes[leaf].categoryBits = filter_of(i).categoryBits;
+        tree->nodes[leaf].maskBits = filter_of(i).maskBits;
+        outProxyIds[i] = leaf;
+        leaves.push_back(leaf);
+    }
+    rebuild_from_leaves(tree, leaves);
+}
+
+void tree_remove_leaves(DynamicTree* tree, const int32_t* proxyIds, int count) {
+    if (count <= 0) return;
+    if (tree->grid || tree->sweep) {
+        for (int i = 0; i < count; ++i) tree_remove_leaf(tree, proxyIds[i]);
+        return;
+    }
+    std::vector<int32_t> leaves;
+    collect_leaves(tree, leaves);
+    if ((size_t)count * 2 < leaves.size()) {
+        for (int i = 0; i < count; ++i) tree_remove_leaf(tree, proxyIds[i]);
+        return;
+    }
+
+    // Most of the tree is going: rebuilding the rest beats unlinking and
+    // rebalancing leaf by leaf. Leaves being removed are marked through their
+    // bodyId, which nothing reads once they are freed.
+    unbuffer_moves(tree, proxyIds, count);
+    for (int i = 0; i < count; ++i) tree->nodes[proxyIds[i]].bodyId = 0xFFFFFFFF;
+    size_t kept = 0;
+    for (int32_t leaf : leaves) {
+        if (tree->nodes[leaf].bodyId != 0xFFFFFFFF) leaves[kept++] = leaf;
+    }
+    leaves.resize(kept);
+    free_internal_nodes(tree);
+    for (int i = 0; i < count; ++i) free_node(tree, proxyIds[i]);
+    rebuild_from_leaves(tree, leaves);
+}
+
+bool tree_update_leaf(DynamicTree* tree, int32_t proxyId, const AABB& aabb, float dx, float dy) {
+    // This used to remove and reinsert the leaf every time it was called —
+    // every awake body, every step — restructuring the tree and putting
+    // every one of them in the move buffer. A body that has not left its
+    // fat AABB has not changed its pairs.
+    AABB fat = aabb;
+    fat.fatten(kAabbMargin);
+    dx *= kAabbDisplacementMultiplier;
+    dy *= kAabbDisplacementMultiplier;
+    if (dx < 0.0f) fat.minX += dx; else fat.maxX += dx;
+    if (dy < 0.0f) fat.minY += dy; else fat.maxY += dy;
+
+    const AABB& stored = tree->nodes[proxyId].aabb;
+    if (stored.contains(aabb)) {
+        // Still inside, but a body that was fast and has slowed down would
+        // otherwise keep a box stretched for the old speed, and with it
+        // pairs it will not reach.
+        AABB huge = fat;
+        huge.fatten(4.0f * kAabbMargin);
+        if (huge.contains(stored)) return false;
+    }
+
+    if (tree->grid) {
+        grid_remove(tree->grid, proxyId, stored);
+        tree->nodes[proxyId].aabb = fat;
+        grid_insert(tree->grid, proxyId, fat);
+        return true;
+    }
+    if (tree->sweep) {
+        tree->nodes[proxyId].aabb = fat;
+        tree->sweep->dirty = true;
+        return true;
+    }
+
+    if (tree->incrementalRebuild) {
+        // b2DynamicTree_EnlargeProxy: grow the ancestors to fit and mark
+        // them for tree_rebuild. An ancestor already marked that already
+        // contains the box means every one above it does too.
+        tree->nodes[proxyId].aabb = fat;
+        if (tree->wide) tree->wide->refit = true;
+        for (int32_t index = tree->nodes[proxyId].parent; index != -1; index = tree->nodes[index].parent) {
+            TreeNode& node = tree->nodes[index];
+            if (node.enlarged && node.aabb.contains(fat)) break;
+            node.aabb = union_of(node.aabb, fat);
+            node.enlarged = true;
+        }
+        return true;
+    }
+
+    // The same node goes back in, as in b2DynamicTree::MoveProxy: a proxy ID
+    // is stable for the life of the leaf, which the persistent pair set
+    // relies on.
+    remove_leaf(tree, proxyId);
+    tree->nodes[proxyId].aabb = fat;
+    insert_leaf(tree, proxyId);
+    return true;
+}
+
+int tree_rebuild(DynamicTree* tree, bool full) {
+    if (tree->sweep) {
+        sweep_prepare(tree->sweep, tree->nodes);
+        return (int)tree->sweep->proxies.size();
+    }
+    if (tree->grid) {
+        if (!full) return 0;
+        // Cells kGridCellScale times the average leaf: most leaves then sit
+        // in one to four cells, and a cell holds a few leaves.
+        std::vector<int32_t>& leaves = tree->rebuildScratch;
+        leaves.clear();
+        float extent = 0.0f;
+        for (int32_t i = 0; i < tree->nodeCapacity; ++i) {
+            const TreeNode& node = tree->nodes[i];
+            if (node.height != 0) continue;
+            leaves.push_back(i);
+            extent += std::max(node.aabb.maxX - node.aabb.minX, node.aabb.maxY - node.aabb.minY);
+        }
+        if (leaves.empty()) return 0;
+        grid_rebuild(tree->grid, tree->nodes, leaves.data(), (int)leaves.size(),
+                     kGridCellScale * extent / (float)leaves.size());
+        return (int)leaves.size();
+    }
     if (tree->root == -1) return 0;
-    
-    int pairCount = 0;
+    if (!full && !tree->nodes[tree->root].enlarged) return 0;
+    reshaped(tree);
+
+    // Free the enlarged internal nodes, top down, and collect what hangs
+    // below them: leaves, and subtrees nothing moved in, which go into the
+    // build whole.
+    std::vector<int32_t>& subtrees = tree->rebuildScratch;
+    subtrees.clear();
     std::vector<int32_t> stack;
-    
-    // We traverse the tree to find all overlapping leaves.
-    // Algorithm: for each leaf, query the tree for overlaps.
-    // To avoid duplicates (A,B and B,A), we only query leaves with index > leaf.
-    
-    std::vector<int32_t> leaves;
     stack.push_back(tree->root);
-    while(!stack.empty()){
-        int32_t curr = stack.back();
+    while (!stack.empty()) {
+        const int32_t index = stack.back();
         stack.pop_back();
-        if(tree->nodes[curr].isLeaf()) leaves.push_back(curr);
-        else {
-            stack.push_back(tree->nodes[curr].left);
-            stack.push_back(tree->nodes[curr].right);
+        const TreeNode& node = tree->nodes[index];
+        if (node.isLeaf() || (!full && !node.enlarged)) {
+            subtrees.push_back(index);
+            continue;
         }
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+        free_node(tree, index);
     }
-    
-    for(size_t i = 0; i < leaves.size(); ++i){
-        int32_t leafA = leaves[i];
-        const AABB& aabbA = tree->nodes[leafA].aabb;
-        
-        // Query tree for overlaps with aabbA
-        stack.clear();
-        stack.push_back(tree->root);
-        
-        while(!stack.empty()){
-            int32_t curr = stack.back();
-            stack.pop_back();
-            
-            if(!tree->nodes[curr].aabb.overlaps(aabbA)) continue;
-            
-            if(tree->nodes[curr].isLeaf()){
-                int32_t leafB = curr;
-                // Only process pairs once (A < B)
-                if(leafB > leafA){
-                    if(pairCount >= maxPairs) return pairCount;
-                    outPairs[pairCount].bodyA = tree->nodes[leafA].bodyId;
-                    outPairs[pairCount].bodyB = tree->nodes[leafB].bodyId;
-                    pairCount++;
-                }
+
+    tree->root = build_subtree(tree, subtrees.data(), (int)subtrees.size());
+    tree->nodes[tree->root].parent = -1;
+    return (int)subtrees.size();
+}
+
+int32_t tree_height(const DynamicTree* tree) {
+    if (!tree || tree->root == -1) return 0;
+    return tree->nodes[tree->root].height;
+}
+
+float tree_area_ratio(const DynamicTree* tree) {
+    if (!tree || tree->root == -1) return 0.0f;
+    const float rootArea = tree->nodes[tree->root].aabb.perimeter();
+    if (rootArea <= 0.0f) return 0.0f;
+
+    // Every allocated internal node is in the tree, so a scan of the pool
+    // sees them all without a walk.
+    float totalArea = 0.0f;
+    for (int32_t i = 0; i < tree->nodeCapacity; ++i) {
+        const TreeNode& node = tree->nodes[i];
+        if (node.height > 0) totalArea += node.aabb.perimeter();
+    }
+    return totalArea / rootArea;
+}
+
+bool tree_set_leaf_filter(DynamicTree* tree, int32_t proxyId, TreeFilter filter) {
+    TreeNode& leaf = tree->nodes[proxyId];
+    if (leaf.categoryBits == filter.categoryBits && leaf.maskBits == filter.maskBits) return false;
+    leaf.categoryBits = filter.categoryBits;
+    leaf.maskBits = filter.maskBits;
+    if (tree->wide) tree->wide->refit = true;
+
+    // The ORs above can grow or shrink; stop at the first that does not
+    // change, since nothing above it can either.
+    for (int32_t index = leaf.parent; index != -1; index = tree->nodes[index].parent) {
+        TreeNode& node = tree->nodes[index];
+        const TreeNode& l = tree->nodes[node.left];
+        const TreeNode& r = tree->nodes[node.right];
+        const uint32_t categoryBits = l.categoryBits | r.categoryBits;
+        const uint32_t maskBits = l.maskBits | r.maskBits;
+        if (node.categoryBits == categoryBits && node.maskBits == maskBits) break;
+        node.categoryBits = categoryBits;
+        node.maskBits = maskBits;
+    }
+    return true;
+}
+
+void tree_buffer_move(DynamicTree* tree, int32_t proxyId) {
+    if (tree->nodes[proxyId].moved) return;
+    tree->nodes[proxyId].moved = true;
+    tree->moveBuffer.push_back(proxyId);
+}
+
+// query_leaves is a template, which C linkage does not allow.
+extern "C++" {
+namespace {
+    // A pair of proxies as one sortable key: the lower `tree` proxy in the
+    // high word, the other in the low word with the top bit set when it is a
+    // `staticTree` proxy.
+    constexpr uint64_t kStaticProxyBit = 0x80000000u;
+
+    inline uint64_t pair_key(int32_t a, int32_t b) {
+        return a < b ? ((uint64_t)a << 32) | (uint32_t)b : ((uint64_t)b << 32) | (uint32_t)a;
+    }
+
+    inline uint64_t static_pair_key(int32_t proxy, int32_t staticProxy) {
+        return ((uint64_t)proxy << 32) | kStaticProxyBit | (uint32_t)staticProxy;
+    }
+
+    // Whether anything under `node`, or the leaf itself, can pair with a
+    // body filtered by `filter`: collide_pair's test, made on the ORs. It
+    // can pass on bits from two different leaves, so a subtree it lets
+    // through may still hold nothing; one it stops holds nothing for sure.
+    inline bool pairs_with(const TreeNode& node, TreeFilter filter) {
+        return (node.categoryBits & filter.maskBits) != 0 && (node.maskBits & filter.categoryBits) != 0;
+    }
+
+    // Leaves of `tree` overlapping `box` that `accept` passes, passed to
+    // `visit`. In a tree, an internal node `accept` fails is not opened.
+    template <typename Accept, typename Visit>
+    void query_leaves(const DynamicTree* tree, const AABB& box, Accept accept, Visit visit) {
+        if (!tree) return;
+        auto visitAccepted = [&](const TreeNode& node) {
+            if (accept(node)) visit(node);
+        };
+        if (tree->grid) {
+            grid_query(tree->grid, tree->nodes, box, visitAccepted);
+            return;
+        }
+        if (tree->sweep) {
+            sweep_query(tree->sweep, tree->nodes, box, visitAccepted);
+            return;
+        }
+        if (tree->root == -1) return;
+        TreeStack stack;
+        stack.push(tree->root);
+        while (!stack.empty()) {
+            const TreeNode& node = tree->nodes[stack.pop()];
+            if (!accept(node) || !node.aabb.overlaps(box)) continue;
+            if (node.isLeaf()) {
+                visit(node);
             } else {
-                stack.push_back(tree->nodes[curr].left);
-                stack.push_back(tree->nodes[curr].right);
+                stack.push(node.left);
+                stack.push(node.right);
             }
         }
     }
-    
+
+    inline bool is_live_leaf(const DynamicTree* tree, int32_t proxy) {
+        const TreeNode& node = tree->nodes[proxy];
+        return node.height == 0 && node.isLeaf();
+    }
+}
+}
+
+int query_tree_pairs(DynamicTree* tree, DynamicTree* staticTree, BroadphasePair* outPairs, int maxPairs) {
+    // This used to collect every leaf into a fresh vector and query the whole
+    // tree with each, every step: O(n log n) and an allocation even when
+    // nothing had moved. Box2D's move buffer instead queries only the proxies
+    // that were created or moved, and a pair found once is kept until the
+    // proxies stop overlapping.
+    //
+    // Each query only opens the subtrees holding a layer the proxy collides
+    // with, so a scene of layers that ignore each other — decoration,
+    // pickups — does not pay for one layer's leaves in another's queries.
+    auto queryMover = [tree, staticTree](int32_t proxy, std::vector<uint64_t>& found) {
+        if (proxy < 0) return;
+        const TreeNode& mover = tree->nodes[proxy];
+        const TreeFilter filter{mover.categoryBits, mover.maskBits};
+        auto accept = [filter](const TreeNode& node) { return pairs_with(node, filter); };
+        query_leaves(tree, mover.aabb, accept, [&](const TreeNode& other) {
+            const int32_t otherProxy = (int32_t)(&other - tree->nodes);
+            // Two movers find each other twice; let the lower one report it.
+            if (otherProxy == proxy || (other.moved && otherProxy < proxy)) return;
+            found.push_back(pair_key(proxy, otherProxy));
+        });
+        query_leaves(staticTree, mover.aabb, accept, [&](const TreeNode& other) {
+            found.push_back(static_pair_key(proxy, (int32_t)(&other - staticTree->nodes)));
+        });
+    };
+    // New static proxies look for the moving ones; a moving proxy that also
+    // moved has already found them.
+    auto queryStatic = [tree, staticTree](int32_t staticProxy, std::vector<uint64_t>& found) {
+        if (staticProxy < 0) return;
+        const TreeNode& mover = staticTree->nodes[staticProxy];
+        const TreeFilter filter{mover.categoryBits, mover.maskBits};
+        auto accept = [filter](const TreeNode& node) { return pairs_with(node, filter); };
+        query_leaves(tree, mover.aabb, accept, [&](const TreeNode& other) {
+            if (other.moved) return;
+            found.push_back(static_pair_key((int32_t)(&other - tree->nodes), staticProxy));
+        });
+    };
+
+    const std::vector<int32_t>& movers = tree->moveBuffer;
+    const std::vector<int32_t> noMoves;
+    const std::vector<int32_t>& staticMovers = staticTree ? staticTree->moveBuffer : noMoves;
+    std::vector<uint64_t>& found = tree->pairScratch;
+    found.clear();
+
+    if ((int)(movers.size() + staticMovers.size()) < tree->parallelThreshold) {
+        for (const int32_t proxy : movers) queryMover(proxy, found);
+        for (const int32_t proxy : staticMovers) queryStatic(proxy, found);
+        std::sort(found.begin(), found.end());
+    } else {
+        // A query of sort and sweep sorts it first if it is stale; do that
+        // here, once, rather than from every thread at once.
+        if (tree->sweep) sweep_prepare(tree->sweep, tree->nodes);
+        if (staticTree && staticTree->sweep) sweep_prepare(staticTree->sweep, staticTree->nodes);
+
+        const int moverBlocks = ((int)movers.size() + kPairBlockSize - 1) / kPairBlockSize;
+        const int staticBlocks = ((int)staticMovers.size() + kPairBlockSize - 1) / kPairBlockSize;
+        const int blocks = moverBlocks + staticBlocks;
+        std::vector<std::vector<uint64_t>>& buffers = tree->pairBlocks;
+        if ((int)buffers.size() < blocks) buffers.resize(blocks);
+        flash::ThreadPool::instance().parallel_for(blocks, [&](int block) {
+            std::vector<uint64_t>& out = buffers[block];
+            out.clear();
+            const bool isStatic = block >= moverBlocks;
+            const std::vector<int32_t>& proxies = isStatic ? staticMovers : movers;
+            const size_t begin = (size_t)(isStatic ? block - moverBlocks : block) * kPairBlockSize;
+            const size_t end = std::min(begin + kPairBlockSize, proxies.size());
+            for (size_t k = begin; k < end; ++k) {
+                if (isStatic) queryStatic(proxies[k], out);
+                else queryMover(proxies[k], out);
+            }
+            std::sort(out.begin(), out.end());
+        });
+
+        // Merge the sorted blocks pairwise, in block order. Keys are unique
+        // across blocks, so the result is the one sort of everything the
+        // serial path makes, however the blocks were scheduled.
+        std::vector<size_t>& runs = tree->pairRuns;
+        runs.clear();
+        for (int block = 0; block < blocks; ++block) {
+            runs.push_back(found.size());
+            found.insert(found.end(), buffers[block].begin(), buffers[block].end());
+        }
+        runs.push_back(found.size());
+        for (size_t width = 1; width + 1 < runs.size(); width *= 2) {
+            for (size_t r = 0; r + width + 1 < runs.size(); r += 2 * width) {
+                const size_t last = std::min(r + 2 * width, runs.size() - 1);
+                std::inplace_merge(found.begin() + runs[r], found.begin() + runs[r + width],
+                                   found.begin() + runs[last]);
+            }
+        }
+    }
+
+    // Drop the pairs that no longer hold. Only a moved proxy can have stopped
+    // overlapping, or had its filter changed; a removed one is no longer a
+    // leaf, or is one of a body created since, in which case it moved.
+    size_t kept = 0;
+    for (const uint64_t key : tree->pairs) {
+        const int32_t a = (int32_t)(key >> 32);
+        const bool isStatic = (key & kStaticProxyBit) != 0;
+        const int32_t b = (int32_t)(key & ~kStaticProxyBit & 0xFFFFFFFFu);
+        const DynamicTree* treeB = isStatic ? staticTree : tree;
+        if (!is_live_leaf(tree, a) || !is_live_leaf(treeB, b)) continue;
+        const TreeNode& nodeA = tree->nodes[a];
+        const TreeNode& nodeB = treeB->nodes[b];
+        if ((nodeA.moved || nodeB.moved) &&
+            (!nodeA.aabb.overlaps(nodeB.aabb) || !pairs_with(nodeA, TreeFilter{nodeB.categoryBits, nodeB.maskBits}))) {
+            continue;
+        }
+        tree->pairs[kept++] = key;
+    }
+    tree->pairs.resize(kept);
+
+    // Merge the new pairs in from the back, in place, then drop the ones
+    // that were already there.
+    std::vector<uint64_t>& pairs = tree->pairs;
+    pairs.resize(kept + found.size());
+    size_t i = kept, j = found.size(), out = pairs.size();
+    while (j > 0) {
+        if (i > 0 && pairs[i - 1] > found[j - 1]) pairs[--out] = pairs[--i];
+        else pairs[--out] = found[--j];
+    }
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    for (const int32_t proxy : tree->moveBuffer) {
+        if (proxy >= 0) tree->nodes[proxy].moved = false;
+    }
+    tree->moveBuffer.clear();
+    if (staticTree) {
+        for (const int32_t proxy : staticTree->moveBuffer) {
+            if (proxy >= 0) staticTree->nodes[proxy].moved = false;
+        }
+        staticTree->moveBuffer.clear();
+    }
+
+    int pairCount = 0;
+    for (const uint64_t key : pairs) {
+        if (pairCount >= maxPairs) break;
+        const bool isStatic = (key & kStaticProxyBit) != 0;
+        const int32_t b = (int32_t)(key & ~kStaticProxyBit & 0xFFFFFFFFu);
+        outPairs[pairCount].bodyA = tree->nodes[key >> 32].bodyId;
+        outPairs[pairCount].bodyB = (isStatic ? staticTree : tree)->nodes[b].bodyId;
+        pairCount++;
+    }
     return pairCount;
 }
 
-AABB calculate_body_aabb(const NativeBody& body) {
+AABB calculate_body_aabb(const NativeBody& body, const PolygonShape* polygon) {
     AABB aabb;
     
-    if (body.shapeType == SHAPE_CIRCLE) {
+    if (body.shapeType == SHAPE_POLYGON && polygon) {
+        const float c = body.q.c;
+        const float s = body.q.s;
+        aabb.minX = aabb.minY = INFINITY;
+        aabb.maxX = aabb.maxY = -INFINITY;
+        for (int i = 0; i < polygon->count; ++i) {
+            const float x = body.x + c * polygon->x[i] - s * polygon->y[i];
+            const float y = body.y + s * polygon->x[i] + c * polygon->y[i];
+            aabb.minX = std::min(aabb.minX, x);
+            aabb.minY = std::min(aabb.minY, y);
+            aabb.maxX = std::max(aabb.maxX, x);
+            aabb.maxY = std::max(aabb.maxY, y);
+        }
+    } else if (body.shapeType == SHAPE_CIRCLE) {
         aabb.minX = body.x - body.radius;
         aabb.minY = body.y - body.radius;
         aabb.maxX = body.x + body.radius;
@@ -433,8 +1075,8 @@ AABB calculate_body_aabb(const NativeBody& body) {
         // Box - need to account for rotation
         float hw = body.width * 0.5f;
         float hh = body.height * 0.5f;
-        float c = std::cos(body.rotation);
-        float s = std::sin(body.rotation);
+        float c = body.q.c;
+        float s = body.q.s;
         
         // Calculate rotated corners
         float corners[4][2] = {
@@ -464,79 +1106,4 @@ AABB calculate_body_aabb(const NativeBody& body) {
     return aabb;
 }
 
-int tree_query_aabb(DynamicTree* tree, const AABB& box, uint32_t* outBodyIds, int maxResults) {
-    if (!tree || !outBodyIds || maxResults <= 0 || tree->root == -1) return 0;
-
-    int count = 0;
-    // Depth is O(log n) after AVL balancing; 64 covers far more nodes than the
-    // pool can hold, and a fixed stack keeps this allocation-free so it can be
-    // called per soft-body point without churning the heap.
-    int32_t stack[64];
-    int top = 0;
-    stack[top++] = tree->root;
-
-    while (top > 0) {
-        const int32_t curr = stack[--top];
-        const TreeNode& node = tree->nodes[curr];
-        if (!node.aabb.overlaps(box)) continue;
-
-        if (node.isLeaf()) {
-            outBodyIds[count++] = node.bodyId;
-            if (count >= maxResults) return count;
-        } else if (top + 2 <= (int)(sizeof(stack) / sizeof(stack[0]))) {
-            stack[top++] = node.left;
-            stack[top++] = node.right;
-        }
-    }
-    return count;
-}
-
-int tree_query_ray(DynamicTree* tree, float x0, float y0, float x1, float y1,
-                   uint32_t* outBodyIds, int maxResults) {
-    if (!tree || !outBodyIds || maxResults <= 0 || tree->root == -1) return 0;
-
-    const float dx = x1 - x0;
-    const float dy = y1 - y0;
-
-    // Slab test, reciprocal precomputed. A zero component gives an infinite
-    // reciprocal, and the IEEE comparisons below then behave correctly for a
-    // ray running exactly parallel to that axis — except when the origin sits
-    // on the slab boundary, where 0 * inf is NaN. Nudging the reciprocal to a
-    // very large finite value avoids that without a branch in the loop.
-    const float invDx = (dx != 0.0f) ? 1.0f / dx : 1e30f;
-    const float invDy = (dy != 0.0f) ? 1.0f / dy : 1e30f;
-
-    int count = 0;
-    int32_t stack[64];
-    int top = 0;
-    stack[top++] = tree->root;
-
-    while (top > 0) {
-        const int32_t curr = stack[--top];
-        const TreeNode& node = tree->nodes[curr];
-        const AABB& b = node.aabb;
-
-        const float tx1 = (b.minX - x0) * invDx;
-        const float tx2 = (b.maxX - x0) * invDx;
-        const float ty1 = (b.minY - y0) * invDy;
-        const float ty2 = (b.maxY - y0) * invDy;
-
-        float tMin = std::max(std::min(tx1, tx2), std::min(ty1, ty2));
-        float tMax = std::min(std::max(tx1, tx2), std::max(ty1, ty2));
-
-        // The segment is bounded: reject anything the ray only reaches past
-        // its end point, or entirely behind its start.
-        if (tMax < 0.0f || tMin > tMax || tMin > 1.0f) continue;
-
-        if (node.isLeaf()) {
-            outBodyIds[count++] = node.bodyId;
-            if (count >= maxResults) return count;
-        } else if (top + 2 <= (int)(sizeof(stack) / sizeof(stack[0]))) {
-            stack[top++] = node.left;
-            stack[top++] = node.right;
-        }
-    }
-    return count;
-}
-
 }
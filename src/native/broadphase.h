@@ -1,6 +1,7 @@
 #ifndef FLASH_BROADPHASE_H
 #define FLASH_BROADPHASE_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <vector>
 
@@ -16,12 +17,22 @@ struct AABB {
                  maxY < other.minY || minY > other.maxY);
     }
     
+    bool contains(const AABB& other) const {
+        return minX <= other.minX && minY <= other.minY &&
+               maxX >= other.maxX && maxY >= other.maxY;
+    }
+    
     void fatten(float amount) {
         minX -= amount;
         minY -= amount;
         maxX += amount;
         maxY += amount;
     }
+
+    // The 2D surface area Box2D v3's tree cost is measured in.
+    float perimeter() const {
+        return 2.0f * ((maxX - minX) + (maxY - minY));
+    }
 };
 
 // Node for the dynamic AABB tree
@@ -33,6 +44,14 @@ struct TreeNode {
     int32_t right;
     int32_t height; // For AVL balancing
     int32_t next;   // For free list
+    bool moved;     // in the move buffer since the last query_tree_pairs
+    bool enlarged;  // internal node grown in place since the last tree_rebuild
+
+    // A leaf's body's collision filter; an internal node's is the OR of its
+    // children's, so a query that wants none of a subtree's layers can skip
+    // it from the top.
+    uint32_t categoryBits;
+    uint32_t maskBits;
     
     bool isLeaf() const { return right == -1; }
 };
@@ -45,8 +64,91 @@ struct DynamicTree {
     int32_t nodeCapacity;
     int32_t freeList;
     
-    // Pair cache to avoid duplicate collision checks
+    // Box2D's move buffer: leaves created or moved since the last
+    // query_tree_pairs, the only ones it queries. -1 marks a leaf removed
+    // while buffered.
+    std::vector<int32_t> moveBuffer;
+
+    // The persistent pair set, kept on the tree whose leaves are queried:
+    // every pair of proxies whose fat AABBs overlap, sorted by pair_key (see
+    // broadphase.cpp). query_tree_pairs merges the new pairs of the movers
+    // in and drops the ones that stopped overlapping.
     std::vector<uint64_t> pairs;
+    std::vector<uint64_t> pairScratch;
+
+    // Moved proxies at or above which query_tree_pairs runs its queries on
+    // the thread pool (kPairParallelThreshold by default), the buffer of new
+    // pairs each block of kPairBlockSize of them collects, and where each
+    // block's pairs start in pairScratch for the merge.
+    int32_t parallelThreshold;
+    std::vector<std::vector<uint64_t>> pairBlocks;
+    std::vector<size_t> pairRuns;
+
+    // Box2D v3's partial rebuild. When set, tree_update_leaf grows a moved
+    // leaf and its ancestors in place and marks them enlarged instead of
+    // reinserting it, and tree_rebuild rebuilds just the enlarged top of the
+    // tree. Off by default.
+    bool incrementalRebuild;
+    std::vector<int32_t> rebuildScratch;
+
+    // The BROADPHASE_GRID and BROADPHASE_SORT_AND_SWEEP backends; both null
+    // for a tree. With either, every allocated node is a leaf, filed there
+    // instead of linked into a hierarchy, and `root` stays -1. See
+    // spatial_grid.h and sort_and_sweep.h.
+    struct SpatialGrid* grid;
+    struct SortAndSweep* sweep;
+
+    // A tree's 4-ary SIMD copy for tree_query and tree_raycast,
+    // rebuilt or refit when they next need it after the tree changes; null
+    // for the other backends. See wide_tree.h.
+    struct WideTree* wide;
+};
+
+// A leaf's collision filter: NativeBody's categoryBits and maskBits.
+struct TreeFilter {
+    uint32_t categoryBits;
+    uint32_t maskBits;
+};
+
+// The filter of a leaf that is not a body's, such as a chain segment: in
+// every layer, seeing every layer.
+constexpr TreeFilter kTreeFilterAll{0xFFFFFFFFu, 0xFFFFFFFFu};
+
+// The maskBits that makes tree_query and tree_raycast (tree_query.h) report
+// every leaf, category 0 included.
+constexpr uint32_t kQueryAllCategories = 0xFFFFFFFFu;
+
+// Entries a query's TreeStack holds in place. A walk needs one more than
+// the tree's height. Incremental inserts keep that at AVL's 1.44 log2 n; a
+// rebuild can be taller, since SAH splits unevenly for up to kMaxSahDepth
+// levels and a partial rebuild stacks kept subtrees under them. 256 covers
+// both with room to spare, and a walk that does not fit spills rather than
+// losing subtrees.
+constexpr int kQueryStackSize = 256;
+
+// The stack a query walks a tree with: node indices, kQueryStackSize of them
+// on the C stack and any more on the heap, so a walk allocates nothing
+// unless the tree is far deeper than it should be.
+struct TreeStack {
+    int32_t local[kQueryStackSize];
+    std::vector<int32_t> spill;
+    int count = 0;
+
+    bool empty() const { return count == 0; }
+
+    void push(int32_t index) {
+        if (count < kQueryStackSize) local[count] = index;
+        else spill.push_back(index);
+        count++;
+    }
+
+    int32_t pop() {
+        count--;
+        if (count < kQueryStackSize) return local[count];
+        const int32_t index = spill.back();
+        spill.pop_back();
+        return index;
+    }
 };
 
 // Broadphase pair (two bodies that might be colliding)
@@ -55,38 +157,107 @@ struct BroadphasePair {
     uint32_t bodyB;
 };
 
-// Create dynamic tree
-DynamicTree* create_dynamic_tree(int initialCapacity);
+// Creates a broadphase of `type`, a Broadphase value from physics.h; anything
+// else makes a tree. Every function below works on all three, and one that
+// is about the hierarchy (tree_height, tree_area_ratio, incrementalRebuild)
+// sees an empty tree in the other two.
+DynamicTree* create_dynamic_tree(int initialCapacity, int32_t type);
 
 // Destroy dynamic tree
 void destroy_dynamic_tree(DynamicTree* tree);
 
 // Insert a body into the tree and return a proxy ID
-int32_t tree_insert_leaf(DynamicTree* tree, uint32_t bodyId, const AABB& aabb);
+int32_t tree_insert_leaf(DynamicTree* tree, uint32_t bodyId, const AABB& aabb, TreeFilter filter);
 
 // Remove a leaf from the tree
 void tree_remove_leaf(DynamicTree* tree, int32_t proxyId);
 
-// Update a leaf (move/resize)
-int32_t tree_update_leaf(DynamicTree* tree, int32_t proxyId, const AABB& aabb);
+// Inserts `count` leaves at once, writing each one's proxy ID. A batch at
+// least as large as the tree rebuilds the whole tree top-down, which is both
+// cheaper and better balanced than inserting the leaves one rotation at a
+// time; a smaller batch is inserted leaf by leaf. Existing proxy IDs survive.
+// `filters` may be null for leaves that all take kTreeFilterAll.
+void tree_insert_leaves(DynamicTree* tree, const uint32_t* bodyIds, const AABB* aabbs,
+                        const TreeFilter* filters, int count, int32_t* outProxyIds);
+
+// Removes `count` leaves at once, rebuilding what is left when that is most
+// of the tree. Surviving proxy IDs are unchanged.
+void tree_remove_leaves(DynamicTree* tree, const int32_t* proxyIds, int count);
+
+// Margin a moved leaf's stored AABB gets around the body's own, and how many
+// steps of the body's displacement it is stretched by on top: Box2D's
+// b2_aabbExtension (0.1 m at 100 pixels per metre) and b2_aabbMultiplier.
+constexpr float kAabbMargin = 10.0f;
+constexpr float kAabbDisplacementMultiplier = 4.0f;
 
-// Query tree for potential collision pairs against all bodies
-int query_tree_pairs(DynamicTree* tree, BroadphasePair* outPairs, int maxPairs);
+// Moves a leaf to `aabb` (b2DynamicTree::MoveProxy). While `aabb` stays inside
+// the leaf's stored fat AABB, and that is not grossly larger than it needs to
+// be, nothing changes and this returns false. Otherwise the leaf is
+// reinserted in place — its proxy ID does not change — with `aabb` grown by
+// kAabbMargin and stretched along the displacement (dx, dy) the body is
+// expected to make next, and this returns true: the caller should buffer the
+// move. Under incrementalRebuild the leaf is enlarged in place instead and
+// the next tree_rebuild restructures it.
+bool tree_update_leaf(DynamicTree* tree, int32_t proxyId, const AABB& aabb, float dx, float dy);
 
-// Bodies whose fat AABB overlaps `box`. Returns how many ids were written,
-// clamped to maxResults.
+// Changes a leaf's filter and the ORs above it. Returns whether it changed,
+// in which case the caller should buffer the move: pairs the old filter kept
+// out are only found, and ones it let in only dropped, by a query.
+bool tree_set_leaf_filter(DynamicTree* tree, int32_t proxyId, TreeFilter filter);
+
+// Queues a leaf for the next query_tree_pairs: one just inserted, or one
+// whose AABB changed.
+void tree_buffer_move(DynamicTree* tree, int32_t proxyId);
+
+// Rebuilds the tree top-down with a binned SAH split; proxy IDs survive.
+// With `full` every internal node is rebuilt. Otherwise only the enlarged
+// ones are, keeping every other subtree whole, which is the per-step half of
+// incrementalRebuild and costs nothing when no leaf grew. Returns how many
+// leaves and kept subtrees the new top was built over.
 //
-// The tree existed only to build the pair list; everything else that needed a
-// spatial lookup — raycasts, soft body contacts — walked all bodies instead.
-int tree_query_aabb(DynamicTree* tree, const AABB& box, uint32_t* outBodyIds, int maxResults);
+// A grid refiles its leaves at a cell size fitted to them when `full`, and
+// sort and sweep re-sorts if anything moved; both return their leaf count.
+int tree_rebuild(DynamicTree* tree, bool full);
+
+// Height of the root; 0 for a single leaf or an empty tree.
+int32_t tree_height(const DynamicTree* tree);
+
+// Box2D v3's b2DynamicTree_GetAreaRatio: the summed perimeters of the
+// internal nodes over the root's. Proportional to the cost of a query, so a
+// tree that degrades under churn shows it here first. 0 for an empty tree.
+float tree_area_ratio(const DynamicTree* tree);
 
-// Bodies whose fat AABB the segment (x0,y0)->(x1,y1) passes through. Broad
-// phase only: the caller still runs the exact shape test on each candidate.
-int tree_query_ray(DynamicTree* tree, float x0, float y0, float x1, float y1,
-                   uint32_t* outBodyIds, int maxResults);
+// Moved proxies one pool task of query_tree_pairs queries. A fixed count, not
+// a share of the threads, so the blocks are the same on every device.
+constexpr int kPairBlockSize = 64;
+
+// Default DynamicTree::parallelThreshold. A pool dispatch costs about
+// 0.03 ms (see particles.cpp) and a query of the tree about 0.2 us, so below
+// a few hundred movers the dispatch is most of the work; this leaves room
+// for the merge on top.
+constexpr int32_t kPairParallelThreshold = 1024;
+
+// Potential collision pairs: every pair of `tree` leaves, and every `tree`
+// leaf with a `staticTree` leaf, whose fat AABBs overlap and whose filters
+// accept each other (each one's maskBits has a bit of the other's
+// categoryBits). `staticTree` may be null.
+//
+// Only the move buffers are queried — `tree`'s against both trees, and
+// `staticTree`'s against `tree` — and what they find is merged into the
+// persistent pair set, so the cost follows the number of proxies that moved.
+// Pairs are written in a fixed order: by the lower proxy, then the other.
+//
+// With at least parallelThreshold moved proxies the queries are split into
+// blocks across flash::ThreadPool, each block collecting into its own buffer.
+// The buffers are sorted and merged before the pair set is, so the result is
+// the same, in the same order, whatever the thread count. A sort and sweep
+// tree is sorted up front, before its queries are shared between threads.
+int query_tree_pairs(DynamicTree* tree, DynamicTree* staticTree, BroadphasePair* outPairs, int maxPairs);
 
-// Helper: Calculate AABB for a body
-AABB calculate_body_aabb(const struct NativeBody& body);
+// Helper: Calculate AABB for a body. A SHAPE_POLYGON body needs its
+// polygon (body_polygon) for exact bounds; without it the width/height box
+// that encloses the hull is used.
+AABB calculate_body_aabb(const struct NativeBody& body, const struct PolygonShape* polygon = nullptr);
 
 }
 
@@ -0,0 +1,144 @@
+#include "chain.h"
+#include "physics.h"
+#include "broadphase.h"
+#include "tree_query.h"
+#include <algorithm>
+#include <cmath>
+
+ChainSet* create_chain_set(int maxBodies) {
+    ChainSet* set = new ChainSet();
+    set->byBody.assign(maxBodies > 0 ? maxBodies : 1, nullptr);
+    return set;
+}
+
+void destroy_chain_set(ChainSet* set) {
+    if (!set) return;
+    for (size_t i = 0; i < set->byBody.size(); ++i) release_chain(set, (int32_t)i);
+    delete set;
+}
+
+bool make_chain(ChainSet* set, int32_t bodyId, const float* xy, int count, bool loop) {
+    if (!set || !xy || bodyId < 0 || bodyId >= (int32_t)set->byBody.size()) return false;
+
+    ChainShape* chain = new ChainShape();
+    chain->loop = loop;
+    // Weld each point within kLinearSlop of the one before it.
+    for (int i = 0; i < count; ++i) {
+        const float px = xy[2 * i], py = xy[2 * i + 1];
+        if (!chain->x.empty()) {
+            const float dx = px - chain->x.back(), dy = py - chain->y.back();
+            if (dx * dx + dy * dy <= kLinearSlop * kLinearSlop) continue;
+        }
+        chain->x.push_back(px);
+        chain->y.push_back(py);
+    }
+    if (loop && chain->x.size() > 1) {
+        const float dx = chain->x.front() - chain->x.back(), dy = chain->y.front() - chain->y.back();
+        if (dx * dx + dy * dy <= kLinearSlop * kLinearSlop) {
+            chain->x.pop_back();
+            chain->y.pop_back();
+        }
+    }
+    if (chain->x.size() < (loop ? 3u : 2u)) {
+        delete chain;
+        return false;
+    }
+    if (loop) {
+        chain->x.push_back(chain->x.front());
+        chain->y.push_back(chain->y.front());
+    }
+
+    const int segmentCount = (int)chain->x.size() - 1;
+    if (segmentCount > kMaxChainSegments) {
+        delete chain;
+        return false;
+    }
+    std::vector<uint32_t> ids(segmentCount);
+    std::vector<AABB> aabbs(segmentCount);
+    std::vector<int32_t> proxies(segmentCount);
+    for (int i = 0; i < segmentCount; ++i) {
+        const float ex = chain->x[i + 1] - chain->x[i], ey = chain->y[i + 1] - chain->y[i];
+        const float len = std::sqrt(ex * ex + ey * ey);
+        chain->nx.push_back(ey / len);
+        chain->ny.push_back(-ex / len);
+
+        ids[i] = (uint32_t)i;
+        aabbs[i].minX = std::min(chain->x[i], chain->x[i + 1]);
+        aabbs[i].minY = std::min(chain->y[i], chain->y[i + 1]);
+        aabbs[i].maxX = std::max(chain->x[i], chain->x[i + 1]);
+        aabbs[i].maxY = std::max(chain->y[i], chain->y[i + 1]);
+    }
+    // Built once, top-down, and never updated: the chain is static.
+    chain->segments = create_dynamic_tree(segmentCount * 2, BROADPHASE_TREE);
+    tree_insert_leaves(chain->segments, ids.data(), aabbs.data(), nullptr, segmentCount, proxies.data());
+
+    release_chain(set, bodyId);
+    set->byBody[bodyId] = chain;
+    return true;
+}
+
+void release_chain(ChainSet* set, int32_t bodyId) {
+    if (!set || bodyId < 0 || bodyId >= (int32_t)set->byBody.size()) return;
+    ChainShape* chain = set->byBody[bodyId];
+    if (!chain) return;
+    destroy_dynamic_tree(chain->segments);
+    delete chain;
+    set->byBody[bodyId] = nullptr;
+}
+
+const ChainShape* body_chain(const PhysicsWorld* world, int32_t bodyId) {
+    if (!world || world->bodies[bodyId].shapeType != SHAPE_CHAIN) return nullptr;
+    return world->chains->byBody[bodyId];
+}
+
+void chain_ghosts(const ChainShape& chain, int i, float& prevX, float& prevY, float& nextX, float& nextY) {
+    const int n = chain.segmentCount();
+    if (i > 0 || chain.loop) {
+        const int p = i > 0 ? i - 1 : n - 1;
+        prevX = chain.x[p];
+        prevY = chain.y[p];
+    } else {
+        prevX = 2.0f * chain.x[0] - chain.x[1];
+        prevY = 2.0f * chain.y[0] - chain.y[1];
+    }
+    if (i + 1 < n || chain.loop) {
+        const int q = i + 1 < n ? i + 2 : 1;
+        nextX = chain.x[q];
+        nextY = chain.y[q];
+    } else {
+        nextX = 2.0f * chain.x[n] - chain.x[n - 1];
+        nextY = 2.0f * chain.y[n] - chain.y[n - 1];
+    }
+}
+
+bool ray_cast_chain(const ChainShape& chain, float startX, float startY, float dx, float dy,
+                    float& outFraction, float& outNx, float& outNy) {
+    // The ray is clipped to the nearest hit so far, so the segment tree does
+    // not open what lies beyond it.
+    bool hit = false;
+    outFraction = 1.0f;
+    tree_raycast(chain.segments, TreeRay{startX, startY, startX + dx, startY + dy, 1.0f}, [&](uint32_t segment) {
+        const int i = (int)segment;
+        const float nx = chain.nx[i], ny = chain.ny[i];
+        // One-sided: a ray from behind, or along, the segment passes through.
+        const float denominator = nx * dx + ny * dy;
+        if (denominator >= 0.0f) return outFraction;
+
+        const float ax = chain.x[i], ay = chain.y[i];
+        const float t = (nx * (ax - startX) + ny * (ay - startY)) / denominator;
+        if (t < 0.0f || t > outFraction) return outFraction;
+
+        // Where along the segment, 0 at its start and 1 at its end.
+        const float ex = chain.x[i + 1] - ax, ey = chain.y[i + 1] - ay;
+        const float px = startX + dx * t - ax, py = startY + dy * t - ay;
+        const float s = (px * ex + py * ey) / (ex * ex + ey * ey);
+        if (s < 0.0f || s > 1.0f) return outFraction;
+
+        hit = true;
+        outFraction = t;
+        outNx = nx;
+        outNy = ny;
+        return outFraction;
+    });
+    return hit;
+}
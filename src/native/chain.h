@@ -0,0 +1,80 @@
+#ifndef FLASH_CHAIN_H
+#define FLASH_CHAIN_H
+
+// Chain shapes for static terrain (Box2D's b2ChainShape / b2ChainSegment).
+//
+// Terrain and tilemap collision used to be a static box per tile or span:
+// every one a leaf in the world tree and a broadphase pair with every dynamic
+// body near it, and every seam between two of them a ledge for a sliding box
+// to snag on. A chain is one static body holding a polyline. The world tree
+// sees a single leaf covering all of it; the segments have a tree of their
+// own, and the narrow phase asks that tree only for the segments under the
+// other body's AABB. Terrain cost then follows the segments a body is near,
+// not the number of bodies the level was built from.
+//
+// Segments are one-sided, as in Box2D: they collide only with what is on
+// their right, the side their normal (e.y, -e.x) points to — the solid is on
+// the left. That is the outside of a counter-clockwise loop, and the top of
+// a surface listed right to left. Each segment knows the vertices either side
+// of it (Box2D's ghost vertices), so a body crossing from one segment to the
+// next is not caught on the shared vertex.
+//
+// Each segment is a contact child: a body touching two segments has two
+// contacts with the chain, one per segment, each with its own normal.
+
+#include <stdint.h>
+#include <vector>
+
+// Most segments one chain may have. The contact table keys a contact on its
+// segment index in 16 bits (see contact_table.cpp), so a longer chain would
+// give two segments the same contact.
+constexpr int kMaxChainSegments = 1 << 16;
+
+struct PhysicsWorld;
+struct DynamicTree;
+
+struct ChainShape {
+    // World space. segmentCount + 1 points; a loop repeats its first point
+    // at the end. Segment i runs from point i to point i + 1, and its
+    // outward normal is (nx[i], ny[i]).
+    std::vector<float> x, y;
+    std::vector<float> nx, ny;
+    bool loop;
+    DynamicTree* segments;     // leaf per segment, bodyId = segment index
+
+    int segmentCount() const { return (int)nx.size(); }
+};
+
+// Every chain of one world, indexed by body id; nullptr for other bodies.
+struct ChainSet {
+    std::vector<ChainShape*> byBody;
+};
+
+ChainSet* create_chain_set(int maxBodies);
+void destroy_chain_set(ChainSet* set);
+
+// Builds a chain from `count` points (interleaved x, y, world space) into
+// set->byBody[bodyId], replacing whatever was there. Points closer than half
+// a pixel to the previous one are dropped. Returns false, storing nothing,
+// if fewer than 2 points remain (3 for a loop), or if they make more than
+// kMaxChainSegments segments.
+bool make_chain(ChainSet* set, int32_t bodyId, const float* xy, int count, bool loop);
+
+// Releases the chain of `bodyId`, if it has one.
+void release_chain(ChainSet* set, int32_t bodyId);
+
+// The chain of a SHAPE_CHAIN body, or nullptr for any other shape.
+const ChainShape* body_chain(const PhysicsWorld* world, int32_t bodyId);
+
+// The points before and after segment `i`. At the open ends of a chain these
+// continue the segment in a straight line, so the ends behave like the
+// middle of a flat run.
+void chain_ghosts(const ChainShape& chain, int i, float& prevX, float& prevY, float& nextX, float& nextY);
+
+// Exact ray test against the segments of `chain`. Only hits on a segment's
+// front side count. On a hit writes the fraction along (dx, dy) and the
+// segment's normal.
+bool ray_cast_chain(const ChainShape& chain, float startX, float startY, float dx, float dy,
+                    float& outFraction, float& outNx, float& outNy);
+
+#endif // FLASH_CHAIN_H
@@ -0,0 +1,96 @@
+#include "constraint_graph.h"
+#include "physics.h"
+#include "joints.h"
+#include <cstddef>
+
+namespace {
+
+inline bool test_bit(const std::vector<uint64_t>& set, uint32_t index) {
+    return (set[index >> 6] >> (index & 63)) & 1u;
+}
+
+inline void set_bit(std::vector<uint64_t>& set, uint32_t index) {
+    set[index >> 6] |= (uint64_t)1 << (index & 63);
+}
+
+// A body the solver writes to. Static bodies are read-only, and dead slots and
+// sleeping islands are skipped by every solver path, so none of them needs to
+// reserve a color.
+inline bool occupies_color(const PhysicsWorld* world, uint32_t bodyId) {
+    if (bodyId >= (uint32_t)world->activeCount) return false;
+    const NativeBody& b = world->bodies[bodyId];
+    return b.alive && b.type != STATIC && b.isAwake;
+}
+
+constexpr int kNotSolved = -2;
+
+// First color in which neither body is taken, -1 for overflow, or kNotSolved
+// when the solver would write to neither body.
+int assign_color(ConstraintGraph* graph, const PhysicsWorld* world, uint32_t bodyA, uint32_t bodyB) {
+    const bool useA = occupies_color(world, bodyA);
+    const bool useB = occupies_color(world, bodyB);
+
+    // Two static bodies never make a contact, but a joint between sleeping or
+    // dead bodies is still in the list.
+    if (!useA && !useB) return kNotSolved;
+
+    for (int c = 0; c < kGraphColorCount; ++c) {
+        std::vector<uint64_t>& set = graph->colors[c].bodySet;
+        if ((useA && test_bit(set, bodyA)) || (useB && test_bit(set, bodyB))) continue;
+        if (useA) set_bit(set, bodyA);
+        if (useB) set_bit(set, bodyB);
+        return c;
+    }
+    return -1;
+}
+
+} // namespace
+
+ConstraintGraph* create_constraint_graph() {
+    ConstraintGraph* graph = new ConstraintGraph();
+    graph->activeColorCount = 0;
+    return graph;
+}
+
+void destroy_constraint_graph(ConstraintGraph* graph) {
+    delete graph;
+}
+
+void color_constraints(ConstraintGraph* graph, const PhysicsWorld* world) {
+    const size_t words = ((size_t)world->activeCount + 63) / 64;
+    for (int c = 0; c < kGraphColorCount; ++c) {
+        GraphColor& color = graph->colors[c];
+        color.contacts.clear();
+        color.joints.clear();
+        color.bodySet.assign(words, 0);
+    }
+    graph->overflow.contacts.clear();
+    graph->overflow.joints.clear();
+
+    int highest = -1;
+    for (int i = 0; i < world->activeConstraints; ++i) {
+        const ContactConstraint& c = world->constraints[i];
+        const int color = assign_color(graph, world, c.bodyA, c.bodyB);
+        if (color == kNotSolved) continue;
+        if (color < 0) {
+            graph->overflow.contacts.push_back(i);
+            continue;
+        }
+        graph->colors[color].contacts.push_back(i);
+        if (color > highest) highest = color;
+    }
+
+    for (int i = 0; i < world->activeBoxJoints; ++i) {
+        const Joint& j = world->boxJoints[i];
+        const int color = assign_color(graph, world, j.bodyA, j.bodyB);
+        if (color == kNotSolved) continue;
+        if (color < 0) {
+            graph->overflow.joints.push_back(i);
+            continue;
+        }
+        graph->colors[color].joints.push_back(i);
+        if (color > highest) highest = color;
+    }
+
+    graph->activeColorCount = highest + 1;
+}
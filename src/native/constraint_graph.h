@@ -0,0 +1,50 @@
+#ifndef FLASH_CONSTRAINT_GRAPH_H
+#define FLASH_CONSTRAINT_GRAPH_H
+
+// Graph coloring of the step's constraints (Box2D v3's constraint_graph.c).
+//
+// Two constraints that share a body cannot be solved at the same time: both
+// read and write that body's velocity. Coloring assigns every contact and
+// joint a color such that no two constraints in one color touch the same
+// non-static body. A color can then be split across the thread pool with no
+// locks, and solving colors one after another inside each iteration keeps the
+// Gauss-Seidel character of the serial solver.
+//
+// Static bodies are never written by the solver, so they do not occupy a
+// color — otherwise every contact against the ground would land in its own
+// color and the graph would degenerate to the serial path.
+//
+// Constraints that find no free color go to the overflow set, which is solved
+// serially after the colors. In practice that is a body with more contacts
+// than there are colors, e.g. the bottom box of a wide pile.
+
+#include <stdint.h>
+#include <vector>
+
+struct PhysicsWorld;
+
+// Box2D uses 24. Beyond a dozen or so the colors are mostly empty for 2D
+// piles, but the bitsets are cheap and a deep stack needs the headroom.
+constexpr int kGraphColorCount = 24;
+
+struct GraphColor {
+    std::vector<int32_t> contacts;  // indices into world->constraints
+    std::vector<int32_t> joints;    // indices into world->boxJoints
+    std::vector<uint64_t> bodySet;  // one bit per body slot using this color
+};
+
+struct ConstraintGraph {
+    GraphColor colors[kGraphColorCount];
+    GraphColor overflow;
+    int activeColorCount;  // colors [0, activeColorCount) hold constraints
+};
+
+ConstraintGraph* create_constraint_graph();
+void destroy_constraint_graph(ConstraintGraph* graph);
+
+// Rebuilds the coloring from world->constraints and world->boxJoints. Called
+// once per step, after the narrow phase. Deterministic: the same constraint
+// list always produces the same colors, whatever the thread count.
+void color_constraints(ConstraintGraph* graph, const PhysicsWorld* world);
+
+#endif // FLASH_CONSTRAINT_GRAPH_H
@@ -0,0 +1,299 @@
+#include "contact_solver.h"
+#include "physics.h"
+#include "simd.h"
+#include <cstddef>
+
+// Lane for lane the arithmetic of physics.cpp's scalar solver, which is
+// compiled with contraction off for the same reason.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+
+namespace {
+
+// Four floats and the few operations the solver needs on them. max_w and
+// min_w are std::max and std::min lane for lane, down to which operand
+// comes back for equal zeros or a NaN, so a lane rounds as the scalar path
+// does.
+#if defined(FLASH_SIMD_SSE2)
+typedef __m128 FloatW;
+typedef __m128 MaskW;
+inline FloatW load_w(const float* p) { return _mm_load_ps(p); }
+inline FloatW loadu_w(const float* p) { return _mm_loadu_ps(p); }
+inline void store_w(float* p, FloatW a) { _mm_store_ps(p, a); }
+inline void storeu_w(float* p, FloatW a) { _mm_storeu_ps(p, a); }
+inline FloatW splat_w(float s) { return _mm_set1_ps(s); }
+inline FloatW add_w(FloatW a, FloatW b) { return _mm_add_ps(a, b); }
+inline FloatW sub_w(FloatW a, FloatW b) { return _mm_sub_ps(a, b); }
+inline FloatW mul_w(FloatW a, FloatW b) { return _mm_mul_ps(a, b); }
+inline FloatW neg_w(FloatW a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+inline FloatW max_w(FloatW a, FloatW b) { return _mm_max_ps(b, a); }
+inline FloatW min_w(FloatW a, FloatW b) { return _mm_min_ps(b, a); }
+inline MaskW greater_w(FloatW a, FloatW b) { return _mm_cmpgt_ps(a, b); }
+inline MaskW load_mask(const uint32_t* p) { return _mm_castsi128_ps(_mm_load_si128((const __m128i*)p)); }
+inline FloatW select_w(MaskW m, FloatW a, FloatW b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+inline void transpose_w(FloatW& a, FloatW& b, FloatW& c, FloatW& d) { _MM_TRANSPOSE4_PS(a, b, c, d); }
+#elif defined(FLASH_SIMD_NEON)
+typedef float32x4_t FloatW;
+typedef uint32x4_t MaskW;
+inline FloatW load_w(const float* p) { return vld1q_f32(p); }
+inline FloatW loadu_w(const float* p) { return vld1q_f32(p); }
+inline void store_w(float* p, FloatW a) { vst1q_f32(p, a); }
+inline void storeu_w(float* p, FloatW a) { vst1q_f32(p, a); }
+inline FloatW splat_w(float s) { return vdupq_n_f32(s); }
+inline FloatW add_w(FloatW a, FloatW b) { return vaddq_f32(a, b); }
+inline FloatW sub_w(FloatW a, FloatW b) { return vsubq_f32(a, b); }
+inline FloatW mul_w(FloatW a, FloatW b) { return vmulq_f32(a, b); }
+inline FloatW neg_w(FloatW a) { return vnegq_f32(a); }
+// vmaxq_f32 and vminq_f32 pick +0 over -0 and propagate NaNs; std::max and
+// std::min do neither.
+inline FloatW max_w(FloatW a, FloatW b) { return vbslq_f32(vcltq_f32(a, b), b, a); }
+inline FloatW min_w(FloatW a, FloatW b) { return vbslq_f32(vcltq_f32(b, a), b, a); }
+inline MaskW greater_w(FloatW a, FloatW b) { return vcgtq_f32(a, b); }
+inline MaskW load_mask(const uint32_t* p) { return vld1q_u32(p); }
+inline FloatW select_w(MaskW m, FloatW a, FloatW b) { return vbslq_f32(m, a, b); }
+inline void transpose_w(FloatW& a, FloatW& b, FloatW& c, FloatW& d) {
+    const float32x4x2_t ab = vtrnq_f32(a, b);
+    const float32x4x2_t cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+#else
+struct FloatW { float v[4]; };
+struct MaskW { bool v[4]; };
+template <typename Op>
+inline FloatW map_w(FloatW a, FloatW b, Op op) {
+    FloatW r;
+    for (int k = 0; k < 4; ++k) r.v[k] = op(a.v[k], b.v[k]);
+    return r;
+}
+inline FloatW load_w(const float* p) { return FloatW{{p[0], p[1], p[2], p[3]}}; }
+inline FloatW loadu_w(const float* p) { return load_w(p); }
+inline void store_w(float* p, FloatW a) { for (int k = 0; k < 4; ++k) p[k] = a.v[k]; }
+inline void storeu_w(float* p, FloatW a) { store_w(p, a); }
+inline FloatW splat_w(float s) { return FloatW{{s, s, s, s}}; }
+inline FloatW add_w(FloatW a, FloatW b) { return map_w(a, b, [](float x, float y) { return x + y; }); }
+inline FloatW sub_w(FloatW a, FloatW b) { return map_w(a, b, [](float x, float y) { return x - y; }); }
+inline FloatW mul_w(FloatW a, FloatW b) { return map_w(a, b, [](float x, float y) { return x * y; }); }
+inline FloatW neg_w(FloatW a) { return FloatW{{-a.v[0], -a.v[1], -a.v[2], -a.v[3]}}; }
+inline FloatW max_w(FloatW a, FloatW b) { return map_w(a, b, [](float x, float y) { return x < y ? y : x; }); }
+inline FloatW min_w(FloatW a, FloatW b) { return map_w(a, b, [](float x, float y) { return y < x ? y : x; }); }
+inline MaskW greater_w(FloatW a, FloatW b) {
+    return MaskW{{a.v[0] > b.v[0], a.v[1] > b.v[1], a.v[2] > b.v[2], a.v[3] > b.v[3]}};
+}
+inline MaskW load_mask(const uint32_t* p) { return MaskW{{p[0] != 0, p[1] != 0, p[2] != 0, p[3] != 0}}; }
+inline FloatW select_w(MaskW m, FloatW a, FloatW b) {
+    FloatW r;
+    for (int k = 0; k < 4; ++k) r.v[k] = m.v[k] ? a.v[k] : b.v[k];
+    return r;
+}
+inline void transpose_w(FloatW& a, FloatW& b, FloatW& c, FloatW& d) {
+    FloatW* rows[4] = {&a, &b, &c, &d};
+    for (int i = 0; i < 4; ++i) {
+        for (int j = i + 1; j < 4; ++j) {
+            const float t = rows[i]->v[j];
+            rows[i]->v[j] = rows[j]->v[i];
+            rows[j]->v[i] = t;
+        }
+    }
+}
+#endif
+
+// A body's velocity and the float after it, read and written as one row of
+// four; the spare float (inverseMass) goes back as it came.
+static_assert(offsetof(SolverBody, vy) == offsetof(SolverBody, vx) + sizeof(float) &&
+                  offsetof(SolverBody, angularVelocity) == offsetof(SolverBody, vx) + 2 * sizeof(float) &&
+                  offsetof(SolverBody, inverseMass) == offsetof(SolverBody, vx) + 3 * sizeof(float),
+              "gather_bodies reads vx, vy, angularVelocity and inverseMass as one row");
+
+// What a static body's lane reads: at rest, as the solver never moves one.
+alignas(16) const float kAtRest[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+// Four bodies' velocities, body k in lane k.
+struct BodyW {
+    FloatW vx, vy, w, spare;
+};
+
+inline BodyW gather_bodies(const SolverBody* bodies, const int32_t* index) {
+    auto row = [&](int k) { return loadu_w(index[k] < 0 ? kAtRest : &bodies[index[k]].vx); };
+    BodyW b{row(0), row(1), row(2), row(3)};
+    transpose_w(b.vx, b.vy, b.w, b.spare);
+    return b;
+}
+
+inline void scatter_bodies(SolverBody* bodies, const int32_t* index, BodyW b) {
+    transpose_w(b.vx, b.vy, b.w, b.spare);
+    const FloatW rows[4] = {b.vx, b.vy, b.w, b.spare};
+    for (int k = 0; k < kContactLanes; ++k) {
+        if (index[k] >= 0) storeu_w(&bodies[index[k]].vx, rows[k]);
+    }
+}
+
+// The masses of the four contacts' bodies.
+struct MassW {
+    FloatW inverseMassA, inverseInertiaA, inverseMassB, inverseInertiaB;
+};
+
+// apply_contact_impulse, to the lanes in `active` only: a lane whose contact
+// lacks the point keeps its velocities bit for bit.
+inline void apply_impulse(BodyW& a, BodyW& b, const MassW& m, MaskW active,
+                          FloatW rax, FloatW ray, FloatW rbx, FloatW rby, FloatW px, FloatW py) {
+    a.vx = select_w(active, sub_w(a.vx, mul_w(px, m.inverseMassA)), a.vx);
+    a.vy = select_w(active, sub_w(a.vy, mul_w(py, m.inverseMassA)), a.vy);
+    a.w = select_w(active, sub_w(a.w, mul_w(sub_w(mul_w(rax, py), mul_w(ray, px)), m.inverseInertiaA)), a.w);
+    b.vx = select_w(active, add_w(b.vx, mul_w(px, m.inverseMassB)), b.vx);
+    b.vy = select_w(active, add_w(b.vy, mul_w(py, m.inverseMassB)), b.vy);
+    b.w = select_w(active, add_w(b.w, mul_w(sub_w(mul_w(rbx, py), mul_w(rby, px)), m.inverseInertiaB)), b.w);
+}
+
+inline MassW load_masses(const WideContact& c) {
+    return MassW{load_w(c.inverseMassA), load_w(c.inverseInertiaA), load_w(c.inverseMassB),
+                 load_w(c.inverseInertiaB)};
+}
+
+} // namespace
+
+WideContactSet* create_wide_contact_set() {
+    WideContactSet* set = new WideContactSet();
+    for (int32_t& start : set->colorStart) start = 0;
+    return set;
+}
+
+void destroy_wide_contact_set(WideContactSet* set) {
+    delete set;
+}
+
+void prepare_wide_contacts(WideContactSet* set, const PhysicsWorld* world, const ConstraintGraph* graph) {
+    int32_t total = 0;
+    for (int color = 0; color < kGraphColorCount; ++color) {
+        set->colorStart[color] = total;
+        if (color < graph->activeColorCount) total += (int32_t)(graph->colors[color].contacts.size() / kContactLanes);
+    }
+    set->colorStart[kGraphColorCount] = total;
+    // Zeroed, so a point a contact lacks is inactive.
+    set->contacts.clear();
+    set->contacts.resize(total);
+
+    for (int color = 0; color < graph->activeColorCount; ++color) {
+        const std::vector<int32_t>& contacts = graph->colors[color].contacts;
+        const int32_t groups = set->colorStart[color + 1] - set->colorStart[color];
+        for (int32_t g = 0; g < groups; ++g) {
+            WideContact& w = set->contacts[set->colorStart[color] + g];
+            for (int k = 0; k < kContactLanes; ++k) {
+                const int32_t index = contacts[g * kContactLanes + k];
+                const ContactConstraint& c = world->constraints[index];
+                const SolverBody& a = world->solverBodies[c.bodyA];
+                const SolverBody& b = world->solverBodies[c.bodyB];
+                w.constraints[k] = index;
+                w.bodyA[k] = a.type == STATIC ? -1 : (int32_t)c.bodyA;
+                w.bodyB[k] = b.type == STATIC ? -1 : (int32_t)c.bodyB;
+                w.inverseMassA[k] = a.inverseMass;
+                w.inverseInertiaA[k] = a.inverseInertia;
+                w.inverseMassB[k] = b.inverseMass;
+                w.inverseInertiaB[k] = b.inverseInertia;
+                w.normalX[k] = c.normalX;
+                w.normalY[k] = c.normalY;
+                w.friction[k] = c.friction;
+                w.restitution[k] = c.restitution;
+                w.massScale[k] = c.softness.massScale;
+                w.impulseScale[k] = c.softness.impulseScale;
+                for (int j = 0; j < 2; ++j) {
+                    WidePoint& p = w.points[j];
+                    if (j >= c.pointCount) continue;
+                    const ContactConstraintPoint& cp = c.points[j];
+                    p.anchorAx[k] = cp.anchorAx;
+                    p.anchorAy[k] = cp.anchorAy;
+                    p.anchorBx[k] = cp.anchorBx;
+                    p.anchorBy[k] = cp.anchorBy;
+                    p.bias[k] = c.softness.massScale * c.softness.biasRate * cp.baseSeparation;
+                    p.normalMass[k] = cp.normalMass;
+                    p.tangentMass[k] = cp.tangentMass;
+                    p.normalImpulse[k] = cp.normalImpulse;
+                    p.tangentImpulse[k] = cp.tangentImpulse;
+                    p.active[k] = 0xFFFFFFFFu;
+                }
+            }
+        }
+    }
+}
+
+void warm_start_wide_contact(SolverBody* bodies, WideContact& c) {
+    BodyW a = gather_bodies(bodies, c.bodyA);
+    BodyW b = gather_bodies(bodies, c.bodyB);
+    const MassW m = load_masses(c);
+    const FloatW nx = load_w(c.normalX), ny = load_w(c.normalY);
+    const FloatW tx = neg_w(ny), ty = nx;
+
+    for (const WidePoint& p : c.points) {
+        const FloatW normalImpulse = load_w(p.normalImpulse), tangentImpulse = load_w(p.tangentImpulse);
+        const FloatW px = add_w(mul_w(nx, normalImpulse), mul_w(tx, tangentImpulse));
+        const FloatW py = add_w(mul_w(ny, normalImpulse), mul_w(ty, tangentImpulse));
+        apply_impulse(a, b, m, load_mask(p.active), load_w(p.anchorAx), load_w(p.anchorAy),
+                      load_w(p.anchorBx), load_w(p.anchorBy), px, py);
+    }
+
+    scatter_bodies(bodies, c.bodyA, a);
+    scatter_bodies(bodies, c.bodyB, b);
+}
+
+void solve_wide_contact_velocity(SolverBody* bodies, WideContact& c) {
+    BodyW a = gather_bodies(bodies, c.bodyA);
+    BodyW b = gather_bodies(bodies, c.bodyB);
+    const MassW m = load_masses(c);
+    const FloatW nx = load_w(c.normalX), ny = load_w(c.normalY);
+    const FloatW tx = neg_w(ny), ty = nx;
+    const FloatW friction = load_w(c.friction), restitution = load_w(c.restitution);
+    const FloatW massScale = load_w(c.massScale), impulseScale = load_w(c.impulseScale);
+    const FloatW zero = splat_w(0.0f);
+    const MaskW bounce = greater_w(restitution, zero);
+
+    for (WidePoint& p : c.points) {
+        const MaskW active = load_mask(p.active);
+        const FloatW rax = load_w(p.anchorAx), ray = load_w(p.anchorAy);
+        const FloatW rbx = load_w(p.anchorBx), rby = load_w(p.anchorBy);
+
+        // Normal impulse with restitution bias.
+        FloatW dvx = sub_w(sub_w(b.vx, mul_w(b.w, rby)), sub_w(a.vx, mul_w(a.w, ray)));
+        FloatW dvy = sub_w(add_w(b.vy, mul_w(b.w, rbx)), add_w(a.vy, mul_w(a.w, rax)));
+        const FloatW vn = add_w(mul_w(dvx, nx), mul_w(dvy, ny));
+        FloatW bias = load_w(p.bias);
+        bias = select_w(bounce, sub_w(bias, mul_w(restitution, vn)), bias);
+
+        const FloatW normalImpulse = load_w(p.normalImpulse);
+        FloatW lambda = sub_w(mul_w(neg_w(load_w(p.normalMass)), add_w(mul_w(massScale, vn), bias)),
+                              mul_w(impulseScale, normalImpulse));
+        const FloatW newNormal = max_w(add_w(normalImpulse, lambda), zero);
+        lambda = sub_w(newNormal, normalImpulse);
+        store_w(p.normalImpulse, select_w(active, newNormal, normalImpulse));
+        apply_impulse(a, b, m, active, rax, ray, rbx, rby, mul_w(nx, lambda), mul_w(ny, lambda));
+
+        // Friction impulse.
+        dvx = sub_w(sub_w(b.vx, mul_w(b.w, rby)), sub_w(a.vx, mul_w(a.w, ray)));
+        dvy = sub_w(add_w(b.vy, mul_w(b.w, rbx)), add_w(a.vy, mul_w(a.w, rax)));
+        const FloatW vt = add_w(mul_w(dvx, tx), mul_w(dvy, ty));
+        const FloatW lambdaT = mul_w(neg_w(load_w(p.tangentMass)), vt);
+        const FloatW maxFriction = mul_w(friction, newNormal);
+        const FloatW tangentImpulse = load_w(p.tangentImpulse);
+        const FloatW newTangent = max_w(neg_w(maxFriction), min_w(add_w(tangentImpulse, lambdaT), maxFriction));
+        const FloatW appliedT = sub_w(newTangent, tangentImpulse);
+        store_w(p.tangentImpulse, select_w(active, newTangent, tangentImpulse));
+        apply_impulse(a, b, m, active, rax, ray, rbx, rby, mul_w(tx, appliedT), mul_w(ty, appliedT));
+    }
+
+    scatter_bodies(bodies, c.bodyA, a);
+    scatter_bodies(bodies, c.bodyB, b);
+}
+
+void store_wide_impulses(const WideContactSet* set, PhysicsWorld* world) {
+    for (const WideContact& w : set->contacts) {
+        for (int k = 0; k < kContactLanes; ++k) {
+            ContactConstraint& c = world->constraints[w.constraints[k]];
+            for (int j = 0; j < c.pointCount && j < 2; ++j) {
+                c.points[j].normalImpulse = w.points[j].normalImpulse[k];
+                c.points[j].tangentImpulse = w.points[j].tangentImpulse[k];
+            }
+        }
+    }
+}
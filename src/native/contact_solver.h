@@ -0,0 +1,79 @@
+#ifndef FLASH_CONTACT_SOLVER_H
+#define FLASH_CONTACT_SOLVER_H
+
+// The NGS contact solver, four contacts at a time (Box2D v3's
+// contact_solver.c).
+//
+// The scalar solver in physics.cpp works through one ContactConstraintPoint
+// at a time, and most of each step is spent there. The contacts of one graph
+// color share no body the solver writes, so any four of them can be solved
+// side by side: a WideContact holds four contacts one array per field, the
+// four pairs of body velocities are gathered into lanes, solved with SSE or
+// NEON, and scattered back.
+//
+// Each lane does the scalar solver's arithmetic in the scalar solver's
+// order, and a color's contacts do not depend on the order they are solved
+// in, so the colored solver gives the same bodies, bit for bit, with the
+// wide path on or off. That holds only while neither side is compiled into
+// fused multiply-adds; see the pragma at the top of physics.cpp.
+//
+// A color's contacts are packed four to a WideContact, and what is left over
+// (fewer than four) stays with the scalar path. The impulses live in the
+// WideContact between the warm start and the last velocity iteration, and
+// are stored back to the constraints after it.
+
+#include "constraint_graph.h"
+#include <stdint.h>
+#include <vector>
+
+struct PhysicsWorld;
+struct SolverBody;
+
+constexpr int kContactLanes = 4;
+
+// One of the two manifold points of four contacts.
+struct alignas(16) WidePoint {
+    float anchorAx[kContactLanes], anchorAy[kContactLanes];
+    float anchorBx[kContactLanes], anchorBy[kContactLanes];
+    float bias[kContactLanes];  // massScale * biasRate * baseSeparation, as the scalar path has it
+    float normalMass[kContactLanes], tangentMass[kContactLanes];
+    float normalImpulse[kContactLanes], tangentImpulse[kContactLanes];
+    uint32_t active[kContactLanes];  // all ones where the contact has this point
+};
+
+struct alignas(16) WideContact {
+    // Solver body index, or -1 for a static body, which the lanes read as
+    // at rest and never write.
+    int32_t bodyA[kContactLanes], bodyB[kContactLanes];
+    float inverseMassA[kContactLanes], inverseInertiaA[kContactLanes];
+    float inverseMassB[kContactLanes], inverseInertiaB[kContactLanes];
+    float normalX[kContactLanes], normalY[kContactLanes];
+    float friction[kContactLanes], restitution[kContactLanes];
+    float massScale[kContactLanes], impulseScale[kContactLanes];
+    WidePoint points[2];
+    int32_t constraints[kContactLanes];  // indices into world->constraints
+};
+
+struct WideContactSet {
+    std::vector<WideContact> contacts;  // color by color
+    // Color c's are [colorStart[c], colorStart[c + 1]), holding its first
+    // kContactLanes * (colorStart[c + 1] - colorStart[c]) contacts in order.
+    int32_t colorStart[kGraphColorCount + 1];
+};
+
+WideContactSet* create_wide_contact_set();
+void destroy_wide_contact_set(WideContactSet* set);
+
+// Packs every color of `graph` into `set`, from constraints whose manifolds,
+// softness and impulses are this step's. Call after color_constraints.
+void prepare_wide_contacts(WideContactSet* set, const PhysicsWorld* world, const ConstraintGraph* graph);
+
+// warm_start_contact and solve_contact_velocity for the four lanes.
+void warm_start_wide_contact(SolverBody* bodies, WideContact& contact);
+void solve_wide_contact_velocity(SolverBody* bodies, WideContact& contact);
+
+// Copies the accumulated impulses back to world->constraints, for the next
+// step's warm start and for contact events.
+void store_wide_impulses(const WideContactSet* set, PhysicsWorld* world);
+
+#endif // FLASH_CONTACT_SOLVER_H
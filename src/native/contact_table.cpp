@@ -0,0 +1,236 @@
+#include "contact_table.h"
+#include "physics.h"
+#include "chain.h"
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t kEmptyContactKey = ~(uint64_t)0;
+
+// 24 bits per body id and 16 for the chain segment. A key that two contacts
+// shared would hand one the other's slot, so those are hard limits:
+// create_physics_world caps bodies at kMaxContactBodies, and make_chain
+// segments at kMaxChainSegments.
+static_assert(kMaxContactBodies <= 1 << 24 && kMaxChainSegments <= 1 << 16, "pair_key packs ids into 24 + 24 + 16 bits");
+inline uint64_t pair_key(uint32_t bodyA, uint32_t bodyB, int32_t child) {
+    const uint64_t lo = bodyA < bodyB ? bodyA : bodyB;
+    const uint64_t hi = bodyA < bodyB ? bodyB : bodyA;
+    return (lo << 40) | (hi << 16) | ((uint64_t)child & 0xFFFF);
+}
+
+// splitmix64's finaliser. Body ids are small and dense, so the raw key would
+// cluster badly under linear probing.
+inline uint64_t hash_key(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return key;
+}
+
+// Probe position of `key`: its own slot if present, else the empty slot where
+// it would go.
+uint64_t probe(const ContactTable* table, uint64_t key) {
+    uint64_t i = hash_key(key) & table->mask;
+    while (table->keys[i] != key && table->keys[i] != kEmptyContactKey) {
+        i = (i + 1) & table->mask;
+    }
+    return i;
+}
+
+// Linear-probing delete without tombstones: walk the cluster after the hole
+// and pull back any entry whose home slot is at or before it.
+void erase_key(ContactTable* table, uint64_t key) {
+    uint64_t hole = probe(table, key);
+    if (table->keys[hole] != key) return;
+    uint64_t i = hole;
+    for (;;) {
+        i = (i + 1) & table->mask;
+        if (table->keys[i] == kEmptyContactKey) break;
+        const uint64_t home = hash_key(table->keys[i]) & table->mask;
+        // Does `home` lie cyclically in (hole, i]? Then the entry is still
+        // reachable and stays put.
+        const bool reachable = hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (reachable) continue;
+        table->keys[hole] = table->keys[i];
+        table->slots[hole] = table->slots[i];
+        hole = i;
+    }
+    table->keys[hole] = kEmptyContactKey;
+}
+
+inline ContactEdge& edge(ContactTable* table, int32_t key) {
+    return table->edges[key];
+}
+
+void link_edge(ContactTable* table, uint32_t body, int32_t key) {
+    ContactEdge& e = edge(table, key);
+    e.prev = -1;
+    e.next = table->bodyHead[body];
+    if (e.next >= 0) edge(table, e.next).prev = key;
+    table->bodyHead[body] = key;
+}
+
+void unlink_edge(ContactTable* table, uint32_t body, int32_t key) {
+    const ContactEdge e = edge(table, key);
+    if (e.prev >= 0) edge(table, e.prev).next = e.next;
+    else table->bodyHead[body] = e.next;
+    if (e.next >= 0) edge(table, e.next).prev = e.prev;
+}
+
+inline bool awake_body(const PhysicsWorld* world, uint32_t id) {
+    const NativeBody& b = world->bodies[id];
+    return b.type != STATIC && b.isAwake;
+}
+
+} // namespace
+
+ContactTable* create_contact_table(int maxBodies, int maxContacts) {
+    ContactTable* table = new ContactTable();
+    uint64_t capacity = 16;
+    while (capacity < (uint64_t)maxContacts * 2) capacity <<= 1;
+    table->keys.assign(capacity, kEmptyContactKey);
+    table->slots.assign(capacity, -1);
+    table->mask = capacity - 1;
+    table->edges.assign((size_t)maxContacts * 2, ContactEdge{-1, -1});
+    table->touchedStep.assign(maxContacts, 0);
+    table->bodyHead.assign(maxBodies, -1);
+    table->step = 0;
+    table->events.resize(maxContacts > 0 ? maxContacts : 1);
+    table->eventHead = 0;
+    table->eventCount = 0;
+    table->eventsDropped = 0;
+    table->eventMask = (1u << CONTACT_BEGIN) | (1u << CONTACT_END);
+    return table;
+}
+
+void destroy_contact_table(ContactTable* table) {
+    delete table;
+}
+
+int32_t find_contact(const ContactTable* table, uint32_t bodyA, uint32_t bodyB, int32_t child) {
+    const uint64_t key = pair_key(bodyA, bodyB, child);
+    const uint64_t i = probe(table, key);
+    return table->keys[i] == key ? table->slots[i] : -1;
+}
+
+int32_t create_contact(ContactTable* table, PhysicsWorld* world, uint32_t bodyA, uint32_t bodyB, int32_t child) {
+    if (world->activeConstraints >= world->maxConstraints) return -1;
+
+    const int32_t slot = world->activeConstraints++;
+    ContactConstraint& c = world->constraints[slot];
+    memset(&c, 0, sizeof(c));
+    c.bodyA = bodyA;
+    c.bodyB = bodyB;
+    c.childIndex = child;
+
+    const uint64_t key = pair_key(bodyA, bodyB, child);
+    const uint64_t i = probe(table, key);
+    table->keys[i] = key;
+    table->slots[i] = slot;
+
+    link_edge(table, bodyA, slot << 1);
+    link_edge(table, bodyB, (slot << 1) | 1);
+    table->touchedStep[slot] = table->step;
+    return slot;
+}
+
+void destroy_contact(ContactTable* table, PhysicsWorld* world, int32_t slot) {
+    push_contact_event(table, world, slot, CONTACT_END, 0.0f);
+
+    ContactConstraint& c = world->constraints[slot];
+    unlink_edge(table, c.bodyA, slot << 1);
+    unlink_edge(table, c.bodyB, (slot << 1) | 1);
+    erase_key(table, pair_key(c.bodyA, c.bodyB, c.childIndex));
+
+    const int32_t last = --world->activeConstraints;
+    if (slot == last) return;
+
+    // Move the last contact down. Re-linking it is simpler than patching its
+    // neighbours in place, and list order carries no meaning.
+    const ContactConstraint& moved = world->constraints[last];
+    unlink_edge(table, moved.bodyA, last << 1);
+    unlink_edge(table, moved.bodyB, (last << 1) | 1);
+    c = moved;
+    table->touchedStep[slot] = table->touchedStep[last];
+    link_edge(table, c.bodyA, slot << 1);
+    link_edge(table, c.bodyB, (slot << 1) | 1);
+    table->slots[probe(table, pair_key(c.bodyA, c.bodyB, c.childIndex))] = slot;
+}
+
+void destroy_body_contacts(ContactTable* table, PhysicsWorld* world, uint32_t bodyId) {
+    // Removing a contact can move another into its slot, so restart from the
+    // head each time rather than following links that may have gone stale.
+    while (table->bodyHead[bodyId] >= 0) {
+        destroy_contact(table, world, table->bodyHead[bodyId] >> 1);
+    }
+}
+
+void sweep_contacts(ContactTable* table, PhysicsWorld* world) {
+    // Backwards, so the contact moved into a freed slot has already been seen.
+    for (int32_t slot = world->activeConstraints - 1; slot >= 0; --slot) {
+        if (table->touchedStep[slot] == table->step) continue;
+        const ContactConstraint& c = world->constraints[slot];
+        if (!awake_body(world, c.bodyA) && !awake_body(world, c.bodyB)) continue;
+        destroy_contact(table, world, slot);
+    }
+}
+
+void push_contact_event(ContactTable* table, const PhysicsWorld* world, int32_t slot, int32_t type, float approachSpeed) {
+    if (!(table->eventMask & (1u << type))) return;
+
+    const ContactConstraint& c = world->constraints[slot];
+    const NativeBody& a = world->bodies[c.bodyA];
+    ContactEvent e;
+    e.type = type;
+    e.bodyA = (int32_t)c.bodyA;
+    e.bodyB = (int32_t)c.bodyB;
+    // Centre of the manifold. Anchors are relative to A's position when the
+    // manifold was built; for an END event A may have moved since, which is
+    // close enough for a point that no longer exists.
+    e.x = a.x;
+    e.y = a.y;
+    if (c.pointCount > 0) {
+        float ax = 0.0f, ay = 0.0f;
+        for (int k = 0; k < c.pointCount; ++k) {
+            ax += c.points[k].anchorAx;
+            ay += c.points[k].anchorAy;
+        }
+        e.x += ax / c.pointCount;
+        e.y += ay / c.pointCount;
+    }
+    e.normalX = c.normalX;
+    e.normalY = c.normalY;
+    e.approachSpeed = approachSpeed;
+
+    const uint32_t capacity = (uint32_t)table->events.size();
+    if (table->eventCount == capacity) {
+        table->eventHead = (table->eventHead + 1) % capacity;
+        --table->eventCount;
+        ++table->eventsDropped;
+    }
+    table->events[(table->eventHead + table->eventCount) % capacity] = e;
+    ++table->eventCount;
+}
+
+int32_t drain_contact_events(ContactTable* table, ContactEvent* out, int32_t max) {
+    if (!out || max <= 0) return 0;
+
+    int32_t written = 0;
+    if (table->eventsDropped > 0) {
+        ContactEvent& e = out[written++];
+        memset(&e, 0, sizeof(e));
+        e.type = CONTACT_EVENTS_DROPPED;
+        e.bodyA = e.bodyB = -1;
+        table->eventsDropped = 0;
+    }
+
+    const uint32_t capacity = (uint32_t)table->events.size();
+    while (written < max && table->eventCount > 0) {
+        out[written++] = table->events[table->eventHead];
+        table->eventHead = (table->eventHead + 1) % capacity;
+        --table->eventCount;
+    }
+    return written;
+}
@@ -0,0 +1,105 @@
+#ifndef FLASH_CONTACT_TABLE_H
+#define FLASH_CONTACT_TABLE_H
+
+// Persistent contacts (Box2D's contact.c / table.c).
+//
+// world->constraints used to be rebuilt from nothing every step, with the
+// accumulated impulses parked in a std::map keyed by body pair and point
+// index: cleared and refilled every step, an O(log n) lookup per contact
+// point, and destroy_body scanning every entry to purge one body's pairs.
+//
+// Now world->constraints *is* the contact store. A contact lives in its slot
+// for as long as its pair keeps touching, and the narrow phase updates its
+// manifold in place, so the impulses from the last step are simply still
+// there. The table adds what that needs:
+//
+//   - an open-addressing hash from body pair to slot, for the narrow phase to
+//     find last step's contact;
+//   - a per-body list of contacts, threaded through the slots, so removing a
+//     body touches that body's contacts and nothing else;
+//   - the step each contact was last found touching, so the ones that stopped
+//     can be swept out.
+//
+// The table also owns the contact event stream. A contact's lifetime is
+// exactly the span between its BEGIN and END events, so they are raised where
+// contacts are created and destroyed, and Dart no longer has to infer them
+// from collision_count flipping between zero and non-zero.
+//
+// Slots are dense: removing a contact moves the last one into its place. Any
+// index into world->constraints is therefore only good until the next
+// removal, which happens in the narrow phase and in destroy_body — never
+// while the solver runs.
+
+#include <stdint.h>
+#include <vector>
+#include "physics.h"
+
+// Most bodies a world may have. The table keys a contact on its two body ids
+// in 24 bits each (see contact_table.cpp); create_physics_world refuses a
+// larger world rather than let two pairs share a key.
+constexpr int kMaxContactBodies = 1 << 24;
+
+// One end of a contact, in the list of the body at that end. Links are edge
+// keys, (slot << 1) | side with side 0 for bodyA and 1 for bodyB, or -1.
+struct ContactEdge {
+    int32_t prev;
+    int32_t next;
+};
+
+struct ContactTable {
+    // Linear probing, power-of-two capacity, at most half full.
+    std::vector<uint64_t> keys;    // kEmptyContactKey when free
+    std::vector<int32_t> slots;    // index into world->constraints
+    uint64_t mask;
+
+    // Parallel to world->constraints.
+    std::vector<ContactEdge> edges;    // 2 per slot: [slot * 2 + side]
+    std::vector<uint32_t> touchedStep;
+
+    std::vector<int32_t> bodyHead;     // per body slot: first edge key, or -1
+    uint32_t step;                     // bumped at the start of every narrow phase
+
+    // Events not yet drained, a ring of `events.size()` starting at
+    // eventHead. Once full the oldest is overwritten and counted in
+    // eventsDropped until the next drain.
+    std::vector<ContactEvent> events;
+    uint32_t eventHead;
+    uint32_t eventCount;
+    uint32_t eventsDropped;
+    uint32_t eventMask;                // 1 << ContactEventType
+};
+
+ContactTable* create_contact_table(int maxBodies, int maxContacts);
+void destroy_contact_table(ContactTable* table);
+
+// Slot of the contact between the two bodies, in either order, or -1.
+// `child` tells apart the contacts of one pair: the chain segment when one
+// body is a chain (see chain.h), else 0.
+int32_t find_contact(const ContactTable* table, uint32_t bodyA, uint32_t bodyB, int32_t child = 0);
+
+// Appends a zeroed contact for the pair and returns its slot, or -1 when
+// world->constraints is full. bodyA must be the lower id.
+int32_t create_contact(ContactTable* table, PhysicsWorld* world, uint32_t bodyA, uint32_t bodyB, int32_t child = 0);
+
+// Removes the contact in `slot`, raising its END event; the last contact
+// moves into it.
+void destroy_contact(ContactTable* table, PhysicsWorld* world, int32_t slot);
+
+// Removes every contact of one body.
+void destroy_body_contacts(ContactTable* table, PhysicsWorld* world, uint32_t bodyId);
+
+// Removes contacts the narrow phase looked at this step and did not find
+// touching. A contact with no awake body on either side was not looked at —
+// it belongs to a sleeping island — and keeps its impulses for when the
+// island wakes.
+void sweep_contacts(ContactTable* table, PhysicsWorld* world);
+
+// Queues an event of `type` for the contact in `slot`, if the mask lets it
+// through. The point and normal come from its current manifold.
+void push_contact_event(ContactTable* table, const PhysicsWorld* world, int32_t slot, int32_t type, float approachSpeed);
+
+// Moves up to `max` queued events into `out`, oldest first. See
+// get_contact_events.
+int32_t drain_contact_events(ContactTable* table, ContactEvent* out, int32_t max);
+
+#endif // FLASH_CONTACT_TABLE_H
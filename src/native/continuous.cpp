@@ -0,0 +1,301 @@
+#include "continuous.h"
+#include "physics.h"
+#include "broadphase.h"
+#include "tree_query.h"
+#include "polygon.h"
+#include "chain.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Conservative advancement stops kLinearSlop short of touching, and the
+// bullet is then placed that far into the surface so the next narrow phase
+// sees it.
+constexpr float kToiTolerance = 0.25f * kLinearSlop;
+constexpr int kMaxToiIterations = 30;
+
+// A shape at one pose, enough for the separation tests below. Boxes and
+// polygons are both a vertex loop: counter-clockwise, world space, with
+// outward edge normals.
+struct Shape {
+    bool circle;
+    float x, y;
+    float radius;    // circle radius
+    int count;
+    float vx[kMaxPolygonVertices], vy[kMaxPolygonVertices];
+    float nx[kMaxPolygonVertices], ny[kMaxPolygonVertices];
+};
+
+Shape make_shape(const NativeBody& b, const PolygonShape* polygon, float x, float y, Rot q) {
+    Shape shape;
+    shape.circle = b.shapeType == SHAPE_CIRCLE;
+    shape.x = x;
+    shape.y = y;
+    shape.radius = b.radius;
+    shape.count = 0;
+    if (shape.circle) return shape;
+
+    const float c = q.c, s = q.s;
+    if (polygon) {
+        shape.count = polygon->count;
+        for (int i = 0; i < polygon->count; ++i) {
+            shape.vx[i] = x + c * polygon->x[i] - s * polygon->y[i];
+            shape.vy[i] = y + s * polygon->x[i] + c * polygon->y[i];
+            shape.nx[i] = c * polygon->nx[i] - s * polygon->ny[i];
+            shape.ny[i] = s * polygon->nx[i] + c * polygon->ny[i];
+        }
+    } else {
+        const float hw = b.width * 0.5f, hh = b.height * 0.5f;
+        const float lx[4] = {-hw, hw, hw, -hw};
+        const float ly[4] = {-hh, -hh, hh, hh};
+        const float lnx[4] = {0.0f, 1.0f, 0.0f, -1.0f};
+        const float lny[4] = {-1.0f, 0.0f, 1.0f, 0.0f};
+        shape.count = 4;
+        for (int i = 0; i < 4; ++i) {
+            shape.vx[i] = x + c * lx[i] - s * ly[i];
+            shape.vy[i] = y + s * lx[i] + c * ly[i];
+            shape.nx[i] = c * lnx[i] - s * lny[i];
+            shape.ny[i] = s * lnx[i] + c * lny[i];
+        }
+    }
+    return shape;
+}
+
+// Segment i of a chain, as a two-vertex polygon. The sweep treats it as
+// two-sided; a bullet reaching one from behind has passed through something
+// already.
+Shape segment_shape(const ChainShape& chain, int i) {
+    Shape shape;
+    shape.circle = false;
+    shape.x = 0.5f * (chain.x[i] + chain.x[i + 1]);
+    shape.y = 0.5f * (chain.y[i] + chain.y[i + 1]);
+    shape.radius = 0.0f;
+    shape.count = 2;
+    for (int k = 0; k < 2; ++k) {
+        shape.vx[k] = chain.x[i + k];
+        shape.vy[k] = chain.y[i + k];
+        shape.nx[k] = k == 0 ? chain.nx[i] : -chain.nx[i];
+        shape.ny[k] = k == 0 ? chain.ny[i] : -chain.ny[i];
+    }
+    return shape;
+}
+
+// Closest point to (px, py) on the segment a-b.
+void closest_on_segment(float px, float py, float ax, float ay, float bx, float by, float& qx, float& qy) {
+    const float ex = bx - ax, ey = by - ay;
+    const float lenSq = ex * ex + ey * ey;
+    float t = lenSq > 0.0f ? ((px - ax) * ex + (py - ay) * ey) / lenSq : 0.0f;
+    t = std::max(0.0f, std::min(t, 1.0f));
+    qx = ax + ex * t;
+    qy = ay + ey * t;
+}
+
+// Circle against a polygon. Normal from the polygon towards the circle.
+float separation_circle_polygon(const Shape& circle, const Shape& polygon, float& nx, float& ny) {
+    bool inside = true;
+    for (int i = 0; i < polygon.count && inside; ++i) {
+        inside = polygon.nx[i] * (circle.x - polygon.vx[i]) + polygon.ny[i] * (circle.y - polygon.vy[i]) <= 0.0f;
+    }
+    if (inside) return -1.0f;  // centre inside
+
+    float best = INFINITY;
+    for (int i = 0; i < polygon.count; ++i) {
+        const int j = i + 1 < polygon.count ? i + 1 : 0;
+        float qx, qy;
+        closest_on_segment(circle.x, circle.y, polygon.vx[i], polygon.vy[i], polygon.vx[j], polygon.vy[j], qx, qy);
+        const float dx = circle.x - qx, dy = circle.y - qy;
+        const float d = std::sqrt(dx * dx + dy * dy);
+        if (d < best && d > 0.0f) { best = d; nx = dx / d; ny = dy / d; }
+    }
+    return best - circle.radius;
+}
+
+// Whether some edge normal of `a` has all of `b` in front of it.
+bool has_separating_edge(const Shape& a, const Shape& b) {
+    for (int i = 0; i < a.count; ++i) {
+        float nearest = INFINITY;
+        for (int j = 0; j < b.count; ++j) {
+            nearest = std::min(nearest, a.nx[i] * (b.vx[j] - a.vx[i]) + a.ny[i] * (b.vy[j] - a.vy[i]));
+        }
+        if (nearest > 0.0f) return true;
+    }
+    return false;
+}
+
+// Polygon against polygon. Normal from `other` towards `self`.
+float separation_polygons(const Shape& self, const Shape& other, float& nx, float& ny) {
+    // Overlapping convex polygons have no separating axis among the edge
+    // normals.
+    if (!has_separating_edge(self, other) && !has_separating_edge(other, self)) return -1.0f;
+
+    // Separated convex polygons are closest at a vertex of one and an edge of
+    // the other.
+    float best = INFINITY;
+    for (int e = 0; e < other.count; ++e) {
+        const int f = e + 1 < other.count ? e + 1 : 0;
+        for (int i = 0; i < self.count; ++i) {
+            float qx, qy;
+            closest_on_segment(self.vx[i], self.vy[i], other.vx[e], other.vy[e], other.vx[f], other.vy[f], qx, qy);
+            const float dx = self.vx[i] - qx, dy = self.vy[i] - qy;
+            const float d = std::sqrt(dx * dx + dy * dy);
+            if (d < best && d > 0.0f) { best = d; nx = dx / d; ny = dy / d; }
+        }
+    }
+    for (int e = 0; e < self.count; ++e) {
+        const int f = e + 1 < self.count ? e + 1 : 0;
+        for (int i = 0; i < other.count; ++i) {
+            float qx, qy;
+            closest_on_segment(other.vx[i], other.vy[i], self.vx[e], self.vy[e], self.vx[f], self.vy[f], qx, qy);
+            const float dx = qx - other.vx[i], dy = qy - other.vy[i];
+            const float d = std::sqrt(dx * dx + dy * dy);
+            if (d < best && d > 0.0f) { best = d; nx = dx / d; ny = dy / d; }
+        }
+    }
+    return best;
+}
+
+// Distance between the shapes, or a negative number if they overlap. The
+// normal points from `other` towards `self`.
+float separation(const Shape& self, const Shape& other, float& nx, float& ny) {
+    if (self.circle && other.circle) {
+        const float dx = self.x - other.x, dy = self.y - other.y;
+        const float len = std::sqrt(dx * dx + dy * dy);
+        if (len > 0.0f) { nx = dx / len; ny = dy / len; } else { nx = 0.0f; ny = 1.0f; }
+        return len - self.radius - other.radius;
+    }
+    if (self.circle) return separation_circle_polygon(self, other, nx, ny);
+    if (other.circle) {
+        const float d = separation_circle_polygon(other, self, nx, ny);
+        nx = -nx; ny = -ny;
+        return d;
+    }
+    return separation_polygons(self, other, nx, ny);
+}
+
+// Conservative advancement of `bullet` along its sweep towards `other`, held
+// at its end pose. Returns the fraction of the sweep at which they come
+// within kLinearSlop, or 1 if not before `tMax`. A pair already that close at
+// the start is left to the discrete contact.
+float time_of_impact(const NativeBody& bullet, const PolygonShape* polygon, const BulletSweep& sweep,
+                     const Shape& other, float tMax, float& nx, float& ny) {
+    const float dx = bullet.x - sweep.x0, dy = bullet.y - sweep.y0;
+    const float dr = bullet.rotation - sweep.rotation0;
+    // Upper bound on how far any point of the bullet moves over the sweep. A
+    // polygon's width and height enclose its hull, so this holds for it too.
+    const float extent = bullet.shapeType == SHAPE_CIRCLE ? 0.0f : std::sqrt(bullet.width * bullet.width + bullet.height * bullet.height) * 0.5f;
+    const float motion = std::sqrt(dx * dx + dy * dy) + std::abs(dr) * extent;
+    if (motion <= 0.0f) return 1.0f;
+
+    float t = 0.0f;
+    for (int iter = 0; iter < kMaxToiIterations; ++iter) {
+        const Shape self = make_shape(bullet, polygon, sweep.x0 + dx * t, sweep.y0 + dy * t, make_rot(sweep.rotation0 + dr * t));
+        const float d = separation(self, other, nx, ny);
+        if (d <= kLinearSlop + kToiTolerance) return t > 0.0f ? t : 1.0f;
+        t += (d - kLinearSlop) / motion;
+        if (t >= tMax) return 1.0f;
+    }
+    return t;
+}
+
+inline bool should_collide(const NativeBody& a, const NativeBody& b) {
+    return (a.maskBits & b.categoryBits) != 0 && (b.maskBits & a.categoryBits) != 0;
+}
+
+} // namespace
+
+ContinuousSet* create_continuous_set(int maxBodies) {
+    ContinuousSet* set = new ContinuousSet();
+    set->candidates.resize(maxBodies > 0 ? maxBodies : 1);
+    return set;
+}
+
+void destroy_continuous_set(ContinuousSet* set) {
+    delete set;
+}
+
+void begin_continuous(ContinuousSet* set, const PhysicsWorld* world) {
+    set->sweeps.clear();
+    for (int i = 0; i < world->activeCount; ++i) {
+        const NativeBody& b = world->bodies[i];
+        if (!b.alive || !b.isBullet || b.type == STATIC || !b.isAwake) continue;
+        set->sweeps.push_back({i, b.x, b.y, b.rotation, b.q});
+    }
+}
+
+int solve_continuous(ContinuousSet* set, PhysicsWorld* world) {
+    int moved = 0;
+    for (const BulletSweep& sweep : set->sweeps) {
+        NativeBody& bullet = world->bodies[sweep.body];
+        if (!bullet.alive) continue;
+
+        // Box2D's test for a fast body: it moved further than half its
+        // thinnest dimension, so the discrete step could have missed a hit.
+        const float dx = bullet.x - sweep.x0, dy = bullet.y - sweep.y0;
+        const float minExtent = bullet.shapeType == SHAPE_CIRCLE ? bullet.radius : 0.5f * std::min(bullet.width, bullet.height);
+        if (dx * dx + dy * dy <= 0.25f * minExtent * minExtent) continue;
+
+        NativeBody start = bullet;
+        start.x = sweep.x0;
+        start.y = sweep.y0;
+        start.rotation = sweep.rotation0;
+        start.q = sweep.q0;
+        const PolygonShape* polygon = body_polygon(world, sweep.body);
+        AABB swept = calculate_body_aabb(start, polygon);
+        const AABB end = calculate_body_aabb(bullet, polygon);
+        swept.minX = std::min(swept.minX, end.minX);
+        swept.minY = std::min(swept.minY, end.minY);
+        swept.maxX = std::max(swept.maxX, end.maxX);
+        swept.maxY = std::max(swept.maxY, end.maxY);
+
+        // Only the bullet's layers: should_collide below makes the other half
+        // of the test.
+        int count = 0;
+        auto collect = [&](uint32_t id) {
+            set->candidates[count++] = id;
+            return true;
+        };
+        tree_query(world->tree, swept, collect, bullet.maskBits);
+        tree_query(world->staticTree, swept, collect, bullet.maskBits);
+        float toi = 1.0f, nx = 0.0f, ny = 0.0f;
+        for (int k = 0; k < count; ++k) {
+            const uint32_t id = set->candidates[k];
+            if ((int32_t)id == sweep.body || id >= (uint32_t)world->activeCount) continue;
+            const NativeBody& other = world->bodies[id];
+            if (!other.alive || (other.isBullet && other.type != STATIC)) continue;
+            if (!should_collide(bullet, other)) continue;
+
+            float hitNx, hitNy;
+            if (const ChainShape* chain = body_chain(world, (int32_t)id)) {
+                tree_query(chain->segments, swept, [&](uint32_t segment) {
+                    const float t = time_of_impact(bullet, polygon, sweep, segment_shape(*chain, (int)segment), toi, hitNx, hitNy);
+                    if (t < toi) {
+                        toi = t;
+                        nx = hitNx;
+                        ny = hitNy;
+                    }
+                    return true;
+                });
+                continue;
+            }
+            const Shape shape = make_shape(other, body_polygon(world, id), other.x, other.y, other.q);
+            const float t = time_of_impact(bullet, polygon, sweep, shape, toi, hitNx, hitNy);
+            if (t < toi) {
+                toi = t;
+                nx = hitNx;
+                ny = hitNy;
+            }
+        }
+        if (toi >= 1.0f) continue;
+
+        // Back to the time of impact, then on into the surface by one slop so
+        // the next narrow phase has an overlap to build the contact from.
+        const float push = kLinearSlop + kToiTolerance + kLinearSlop;
+        bullet.x = sweep.x0 + dx * toi - nx * push;
+        bullet.y = sweep.y0 + dy * toi - ny * push;
+        bullet.rotation = sweep.rotation0 + (bullet.rotation - sweep.rotation0) * toi;
+        bullet.q = make_rot(bullet.rotation);
+        ++moved;
+    }
+    return moved;
+}
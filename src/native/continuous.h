@@ -0,0 +1,52 @@
+#ifndef FLASH_CONTINUOUS_H
+#define FLASH_CONTINUOUS_H
+
+// Continuous collision for bullet bodies (Box2D's solver.c b2SolveContinuous).
+//
+// The narrow phase only sees where bodies are at the start of a step. A body
+// that covers more than its own size in one step can pass clean through thin
+// geometry without ever overlapping it, which is why maxLinearVelocity exists
+// and why projectile-heavy scenes had to raise the step rate for the whole
+// world.
+//
+// A body flagged isBullet is swept instead: after the solver, if it moved
+// more than half its smallest extent, the segment from its start pose to its
+// end pose is checked against everything its swept AABB touches in the tree,
+// with conservative advancement for the time of impact. Only those bodies pay
+// for it. On a hit the bullet is moved back along its sweep to the time of
+// impact, just into contact, and keeps its velocity. The next step's narrow
+// phase then finds a real contact and the solver resolves the impact as it
+// would any other, restitution included. The rest of the step's motion is
+// dropped, as in Box2D.
+//
+// Other bodies are taken at their end-of-step pose. Bullets do not sweep
+// against other bullets.
+
+#include "physics.h"
+#include <stdint.h>
+#include <vector>
+
+struct BulletSweep {
+    int32_t body;
+    float x0, y0, rotation0;   // pose at the start of the step
+    Rot q0;                    // and rotation0's cos and sin
+};
+
+struct ContinuousSet {
+    std::vector<BulletSweep> sweeps;      // awake bullets this step
+    std::vector<uint32_t> candidates;     // tree query scratch, maxBodies long
+};
+
+ContinuousSet* create_continuous_set(int maxBodies);
+void destroy_continuous_set(ContinuousSet* set);
+
+// Records the pose of every awake bullet. Called before the solver moves
+// anything.
+void begin_continuous(ContinuousSet* set, const PhysicsWorld* world);
+
+// Sweeps the bullets recorded by begin_continuous to their current pose and
+// pulls back any that would have passed through something. Returns how many
+// were moved.
+int solve_continuous(ContinuousSet* set, PhysicsWorld* world);
+
+#endif // FLASH_CONTINUOUS_H
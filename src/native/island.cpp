@@ -0,0 +1,177 @@
+#include "island.h"
+#include "physics.h"
+#include "joints.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Box2D's b2_linearSleepTolerance (0.05 m/s) and b2_angularSleepTolerance
+// (2 degrees/s), in this world's pixels at 100 per metre. The previous
+// per-body test used 0.2 on the squared speed — under half a pixel a second,
+// which a stack resting on soft contacts never gets below.
+constexpr float kLinearSleepTolerance = 0.05f * 100.0f;
+constexpr float kAngularSleepTolerance = 2.0f / 180.0f * 3.14159265359f;
+
+// A body islands are built from: one the solver moves this step.
+inline bool is_island_body(const PhysicsWorld* world, uint32_t id) {
+    if (id >= (uint32_t)world->activeCount) return false;
+    const NativeBody& b = world->bodies[id];
+    return b.alive && b.type != STATIC && b.isAwake;
+}
+
+int32_t find_root(std::vector<int32_t>& parent, int32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];  // path halving
+        i = parent[i];
+    }
+    return i;
+}
+
+// The lower slot becomes the root, so island numbering depends only on the
+// constraint list and not on the order pairs were linked.
+void link(std::vector<int32_t>& parent, int32_t a, int32_t b) {
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if (a == b) return;
+    if (a < b) parent[b] = a;
+    else parent[a] = b;
+}
+
+// Island a constraint between bodyA and bodyB belongs to, or -1 when neither
+// body is being solved (two static bodies, or a joint on dead slots).
+inline int32_t constraint_island(const IslandSet* set, const PhysicsWorld* world, uint32_t bodyA, uint32_t bodyB) {
+    if (is_island_body(world, bodyA)) return set->islandOf[bodyA];
+    if (is_island_body(world, bodyB)) return set->islandOf[bodyB];
+    return -1;
+}
+
+} // namespace
+
+IslandSet* create_island_set(int maxBodies) {
+    IslandSet* set = new IslandSet();
+    set->parent.assign(maxBodies, 0);
+    set->islandOf.assign(maxBodies, -1);
+    set->sleepNext.assign(maxBodies, -1);
+    set->islandCount = 0;
+    set->solveCount = 0;
+    return set;
+}
+
+void destroy_island_set(IslandSet* set) {
+    delete set;
+}
+
+bool wake_island(PhysicsWorld* world, int32_t bodyId) {
+    if (bodyId < 0 || bodyId >= world->activeCount) return false;
+    const NativeBody& seed = world->bodies[bodyId];
+    if (!seed.alive || seed.type == STATIC || seed.isAwake) return false;
+
+    std::vector<int32_t>& next = world->islands->sleepNext;
+    int32_t id = bodyId;
+    do {
+        NativeBody& b = world->bodies[id];
+        b.isAwake = 1;
+        b.sleepTime = 0.0f;
+        const int32_t following = next[id];
+        next[id] = -1;
+        id = following;
+    } while (id >= 0 && id != bodyId);
+    return true;
+}
+
+void build_islands(IslandSet* set, const PhysicsWorld* world) {
+    const int count = world->activeCount;
+    std::vector<int32_t>& parent = set->parent;
+    for (int i = 0; i < count; ++i) parent[i] = i;
+
+    for (int i = 0; i < world->activeConstraints; ++i) {
+        const ContactConstraint& c = world->constraints[i];
+        if (is_island_body(world, c.bodyA) && is_island_body(world, c.bodyB)) link(parent, c.bodyA, c.bodyB);
+    }
+    for (int i = 0; i < world->activeBoxJoints; ++i) {
+        const Joint& j = world->boxJoints[i];
+        if (is_island_body(world, j.bodyA) && is_island_body(world, j.bodyB)) link(parent, j.bodyA, j.bodyB);
+    }
+
+    // Number the islands in slot order of their roots, and drop bodies in.
+    int islandCount = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!is_island_body(world, i)) {
+            set->islandOf[i] = -1;
+            continue;
+        }
+        const int32_t root = find_root(parent, i);
+        int32_t index;
+        if (root == i) {
+            index = islandCount++;
+            if ((int)set->islands.size() < islandCount) set->islands.emplace_back();
+            Island& island = set->islands[index];
+            island.bodies.clear();
+            island.contacts.clear();
+            island.joints.clear();
+        } else {
+            index = set->islandOf[root];  // root < i, so already numbered
+        }
+        set->islandOf[i] = index;
+        set->islands[index].bodies.push_back(i);
+    }
+    set->islandCount = islandCount;
+
+    for (int i = 0; i < world->activeConstraints; ++i) {
+        const ContactConstraint& c = world->constraints[i];
+        const int32_t island = constraint_island(set, world, c.bodyA, c.bodyB);
+        if (island >= 0) set->islands[island].contacts.push_back(i);
+    }
+    for (int i = 0; i < world->activeBoxJoints; ++i) {
+        const Joint& j = world->boxJoints[i];
+        const int32_t island = constraint_island(set, world, j.bodyA, j.bodyB);
+        if (island >= 0) set->islands[island].joints.push_back(i);
+    }
+
+    set->solveOrder.resize(islandCount);
+    for (int i = 0; i < islandCount; ++i) set->solveOrder[i] = i;
+    std::stable_sort(set->solveOrder.begin(), set->solveOrder.end(), [set](int32_t a, int32_t b) {
+        const Island& ia = set->islands[a];
+        const Island& ib = set->islands[b];
+        return ia.contacts.size() + ia.joints.size() > ib.contacts.size() + ib.joints.size();
+    });
+    int solveCount = 0;
+    while (solveCount < islandCount) {
+        const Island& island = set->islands[set->solveOrder[solveCount]];
+        if (island.contacts.empty() && island.joints.empty()) break;
+        ++solveCount;
+    }
+    set->solveCount = solveCount;
+}
+
+void sleep_islands(IslandSet* set, PhysicsWorld* world, float dt) {
+    const float linTolSq = kLinearSleepTolerance * kLinearSleepTolerance;
+    set->fellAsleep.clear();
+    for (int i = 0; i < set->islandCount; ++i) {
+        const Island& island = set->islands[i];
+        float minSleepTime = kTimeToSleep;
+        for (int32_t id : island.bodies) {
+            NativeBody& b = world->bodies[id];
+            if (b.vx * b.vx + b.vy * b.vy > linTolSq ||
+                std::abs(b.angularVelocity) > kAngularSleepTolerance) {
+                b.sleepTime = 0.0f;
+            } else {
+                b.sleepTime += dt;
+            }
+            minSleepTime = std::min(minSleepTime, b.sleepTime);
+        }
+        if (minSleepTime < kTimeToSleep) continue;
+
+        // Link the bodies into a ring so that touching any one of them later
+        // wakes all of them.
+        const size_t n = island.bodies.size();
+        for (size_t k = 0; k < n; ++k) {
+            NativeBody& b = world->bodies[island.bodies[k]];
+            b.isAwake = 0;
+            b.vx = b.vy = b.angularVelocity = 0.0f;
+            set->sleepNext[island.bodies[k]] = island.bodies[(k + 1) % n];
+        }
+        set->fellAsleep.insert(set->fellAsleep.end(), island.bodies.begin(), island.bodies.end());
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef FLASH_ISLAND_H
+#define FLASH_ISLAND_H
+
+// Simulation islands (Box2D's island.c, rebuilt every step with union-find).
+//
+// An island is a set of non-static bodies connected through touching contacts
+// and joints. Static bodies never join one: everything resting on the ground
+// would otherwise be a single island, and the ground is never going to stop
+// being touched.
+//
+// Islands are what sleep. Sleep used to be decided per body, so a box at rest
+// in a pile was put to sleep while its neighbour was still settling, and the
+// neighbour's contact woke it again on the next iteration — and since the
+// static ground counted as awake, nothing that touched it ever slept at all.
+// Here an island sleeps only once every body in it has been still for
+// kTimeToSleep, and wakes as a whole when anything awake touches any of it.
+//
+// While awake, islands share no writable body, so each one can be solved as an
+// independent task — see SOLVER_THREADING_ISLANDS.
+//
+// A sleeping island keeps its contacts, impulses included, in the contact
+// table: sweep_contacts only drops a contact that has an awake body and was
+// not touched this step, and the narrow phase skips pairs with no awake body.
+// Waking picks the same contacts up again, so the island restarts warm. Its
+// bodies are also linked into a circular list, which is all waking needs to
+// find them: walk the ring from whichever body was touched.
+
+#include <stdint.h>
+#include <vector>
+
+struct PhysicsWorld;
+
+// Seconds an island must stay below the sleep tolerances before it sleeps.
+constexpr float kTimeToSleep = 0.5f;
+
+struct Island {
+    std::vector<int32_t> bodies;    // body slots
+    std::vector<int32_t> contacts;  // indices into world->constraints
+    std::vector<int32_t> joints;    // indices into world->boxJoints
+};
+
+struct IslandSet {
+    std::vector<int32_t> parent;     // union-find over body slots, per step
+    std::vector<int32_t> islandOf;   // body slot -> index into islands, or -1
+    std::vector<int32_t> sleepNext;  // ring of a sleeping island, -1 if awake
+
+    // Islands of the current step, [0, islandCount). Kept across steps so
+    // their vectors keep their capacity.
+    std::vector<Island> islands;
+    int islandCount;
+
+    // Island indices largest first: the order tasks are handed to the pool,
+    // so one big pile does not start last and hold up the whole dispatch.
+    // The first solveCount have constraints; the rest are lone bodies.
+    std::vector<int32_t> solveOrder;
+    int solveCount;
+
+    // Broadphase pairs the narrow phase skipped because neither body was
+    // awake, kept in case a contact later in the same pass wakes one of them.
+    std::vector<int32_t> deferredPairs;
+
+    // Bodies put to sleep by the last sleep_islands, for
+    // get_awake_body_transforms.
+    std::vector<int32_t> fellAsleep;
+};
+
+IslandSet* create_island_set(int maxBodies);
+void destroy_island_set(IslandSet* set);
+
+// Wakes every body in the sleeping island that holds bodyId. Returns false if
+// there was nothing to wake: the body is static, dead, or already awake.
+bool wake_island(PhysicsWorld* world, int32_t bodyId);
+
+// Groups the awake, non-static bodies by the contacts and joints between them.
+// Called once per step, after the narrow phase.
+void build_islands(IslandSet* set, const PhysicsWorld* world);
+
+// Advances each awake body's sleep timer and puts to sleep every island whose
+// bodies have all been still for kTimeToSleep. Called at the end of the step.
+void sleep_islands(IslandSet* set, PhysicsWorld* world, float dt);
+
+#endif // FLASH_ISLAND_H
@@ -1,17 +1,18 @@
 #include "joints.h"
 #include "physics.h"
+#include "island.h"
 #include <cmath>
 #include <algorithm>
 
 extern "C" {
 
-// Helper: Get body from world
-static inline NativeBody* get_body(PhysicsWorld* world, uint32_t id) {
+// Helper: Get body from world. The solvers work on its SolverBody, which
+// step_physics loads before them and stores back after.
+static inline SolverBody* get_body(PhysicsWorld* world, uint32_t id) {
     if (id >= (uint32_t)world->activeCount) return nullptr;
-    NativeBody* b = &world->bodies[id];
     // A destroyed body keeps its slot until it is recycled. Solving a joint
     // against one would apply impulses to a body that no longer exists.
-    return b->alive ? b : nullptr;
+    return world->bodies[id].alive ? &world->solverBodies[id] : nullptr;
 }
 
 // Create joint
@@ -20,6 +21,11 @@ FLASH_API int create_joint(PhysicsWorld* world, JointDef* def) {
         return -1;
     }
     
+    // A joint to a sleeping island pulls it into whatever the other body is
+    // doing, so it has to be awake to respond.
+    wake_island(world, (int32_t)def->bodyA);
+    wake_island(world, (int32_t)def->bodyB);
+
     int jointId = world->activeBoxJoints++;
     Joint* joint = &world->boxJoints[jointId];
     
@@ -82,6 +88,10 @@ FLASH_API int create_joint(PhysicsWorld* world, JointDef* def) {
 
 FLASH_API void destroy_joint(PhysicsWorld* world, int jointId) {
     if (!world || jointId < 0 || jointId >= world->activeBoxJoints) return;
+
+    // A sleeping island may have been held in place by this joint.
+    wake_island(world, (int32_t)world->boxJoints[jointId].bodyA);
+    wake_island(world, (int32_t)world->boxJoints[jointId].bodyB);
     
     // Swap with last joint and decrease count
     if (jointId < world->activeBoxJoints - 1) {
@@ -94,8 +104,8 @@ FLASH_API void destroy_joint(PhysicsWorld* world, int jointId) {
 void init_joint_velocity_constraints(PhysicsWorld* world, float dt) {
     for (int i = 0; i < world->activeBoxJoints; ++i) {
         Joint* joint = &world->boxJoints[i];
-        NativeBody* bodyA = get_body(world, joint->bodyA);
-        NativeBody* bodyB = get_body(world, joint->bodyB);
+        SolverBody* bodyA = get_body(world, joint->bodyA);
+        SolverBody* bodyB = get_body(world, joint->bodyB);
         
         if (!bodyA || !bodyB) continue;
         
@@ -125,8 +135,8 @@ void init_joint_velocity_constraints(PhysicsWorld* world, float dt) {
 
 // Distance joint velocity solver
 void solve_distance_joint_velocity(Joint* joint, PhysicsWorld* world) {
-    NativeBody* bodyA = get_body(world, joint->bodyA);
-    NativeBody* bodyB = get_body(world, joint->bodyB);
+    SolverBody* bodyA = get_body(world, joint->bodyA);
+    SolverBody* bodyB = get_body(world, joint->bodyB);
     
     if (!bodyA || !bodyB) return;
     
@@ -202,32 +212,35 @@ void solve_distance_joint_velocity(Joint* joint, PhysicsWorld* world) {
     }
 }
 
+// Solve one joint's velocity constraint
+void solve_joint_velocity(Joint* joint, PhysicsWorld* world) {
+    switch (joint->type) {
+        case DISTANCE_JOINT:
+            solve_distance_joint_velocity(joint, world);
+            break;
+        case REVOLUTE_JOINT:
+            solve_revolute_joint_velocity(joint, world);
+            break;
+        case PRISMATIC_JOINT:
+            solve_prismatic_joint_velocity(joint, world);
+            break;
+        case WELD_JOINT:
+            solve_weld_joint_velocity(joint, world);
+            break;
+    }
+}
+
 // Solve all joint velocity constraints
 void solve_joint_velocity_constraints(PhysicsWorld* world) {
     for (int i = 0; i < world->activeBoxJoints; ++i) {
-        Joint* joint = &world->boxJoints[i];
-        
-        switch (joint->type) {
-            case DISTANCE_JOINT:
-                solve_distance_joint_velocity(joint, world);
-                break;
-            case REVOLUTE_JOINT:
-                solve_revolute_joint_velocity(joint, world);
-                break;
-            case PRISMATIC_JOINT:
-                solve_prismatic_joint_velocity(joint, world);
-                break;
-            case WELD_JOINT:
-                solve_weld_joint_velocity(joint, world);
-                break;
-        }
+        solve_joint_velocity(&world->boxJoints[i], world);
     }
 }
 
 // Distance joint position solver
 void solve_distance_joint_position(Joint* joint, PhysicsWorld* world) {
-    NativeBody* bodyA = get_body(world, joint->bodyA);
-    NativeBody* bodyB = get_body(world, joint->bodyB);
+    SolverBody* bodyA = get_body(world, joint->bodyA);
+    SolverBody* bodyB = get_body(world, joint->bodyB);
     
     if (!bodyA || !bodyB) return;
     if (joint->distance.frequency > 0.0f) return; // Soft constraint, skip position solve
@@ -286,32 +299,35 @@ void solve_distance_joint_position(Joint* joint, PhysicsWorld* world) {
     }
 }
 
+// Solve one joint's position constraint
+void solve_joint_position(Joint* joint, PhysicsWorld* world) {
+    switch (joint->type) {
+        case DISTANCE_JOINT:
+            solve_distance_joint_position(joint, world);
+            break;
+        case REVOLUTE_JOINT:
+            solve_revolute_joint_position(joint, world);
+            break;
+        case PRISMATIC_JOINT:
+            solve_prismatic_joint_position(joint, world);
+            break;
+        case WELD_JOINT:
+            solve_weld_joint_position(joint, world);
+            break;
+    }
+}
+
 // Solve all joint position constraints
 void solve_joint_position_constraints(PhysicsWorld* world) {
     for (int i = 0; i < world->activeBoxJoints; ++i) {
-        Joint* joint = &world->boxJoints[i];
-        
-        switch (joint->type) {
-            case DISTANCE_JOINT:
-                solve_distance_joint_position(joint, world);
-                break;
-            case REVOLUTE_JOINT:
-                solve_revolute_joint_position(joint, world);
-                break;
-            case PRISMATIC_JOINT:
-                solve_prismatic_joint_position(joint, world);
-                break;
-            case WELD_JOINT:
-                solve_weld_joint_position(joint, world);
-                break;
-        }
+        solve_joint_position(&world->boxJoints[i], world);
     }
 }
 
 // Revolute joint velocity solver
 void solve_revolute_joint_velocity(Joint* joint, PhysicsWorld* world) {
-    NativeBody* bodyA = get_body(world, joint->bodyA);
-    NativeBody* bodyB = get_body(world, joint->bodyB);
+    SolverBody* bodyA = get_body(world, joint->bodyA);
+    SolverBody* bodyB = get_body(world, joint->bodyB);
     
     if (!bodyA || !bodyB) return;
     
@@ -409,8 +425,8 @@ void solve_revolute_joint_velocity(Joint* joint, PhysicsWorld* world) {
 }
 
 void solve_revolute_joint_position(Joint* joint, PhysicsWorld* world) {
-    NativeBody* bodyA = get_body(world, joint->bodyA);
-    NativeBody* bodyB = get_body(world, joint->bodyB);
+    SolverBody* bodyA = get_body(world, joint->bodyA);
+    SolverBody* bodyB = get_body(world, joint->bodyB);
     
     if (!bodyA || !bodyB) return;
     
@@ -462,8 +478,8 @@ void solve_revolute_joint_position(Joint* joint, PhysicsWorld* world) {
 
 // Prismatic joint velocity solver
 void solve_prismatic_joint_velocity(Joint* joint, PhysicsWorld* world) {
-    NativeBody* bodyA = get_body(world, joint->bodyA);
-    NativeBody* bodyB = get_body(world, joint->bodyB);
+    SolverBody* bodyA = get_body(world, joint->bodyA);
+    SolverBody* bodyB = get_body(world, joint->bodyB);
     
     if (!bodyA || !bodyB) return;
     
@@ -572,8 +588,8 @@ void solve_prismatic_joint_velocity(Joint* joint, PhysicsWorld* world) {
 }
 
 void solve_prismatic_joint_position(Joint* joint, PhysicsWorld* world) {
-    NativeBody* bodyA = get_body(world, joint->bodyA);
-    NativeBody* bodyB = get_body(world, joint->bodyB);
+    SolverBody* bodyA = get_body(world, joint->bodyA);
+    SolverBody* bodyB = get_body(world, joint->bodyB);
     
     if (!bodyA || !bodyB) return;
     
@@ -628,8 +644,8 @@ void solve_prismatic_joint_position(Joint* joint, PhysicsWorld* world) {
 
 // Weld joint velocity solver
 void solve_weld_joint_velocity(Joint* joint, PhysicsWorld* world) {
-    NativeBody* bodyA = get_body(world, joint->bodyA);
-    NativeBody* bodyB = get_body(world, joint->bodyB);
+    SolverBody* bodyA = get_body(world, joint->bodyA);
+    SolverBody* bodyB = get_body(world, joint->bodyB);
     
     if (!bodyA || !bodyB) return;
     
@@ -699,8 +715,8 @@ void solve_weld_joint_velocity(Joint* joint, PhysicsWorld* world) {
 }
 
 void solve_weld_joint_position(Joint* joint, PhysicsWorld* world) {
-    NativeBody* bodyA = get_body(world, joint->bodyA);
-    NativeBody* bodyB = get_body(world, joint->bodyB);
+    SolverBody* bodyA = get_body(world, joint->bodyA);
+    SolverBody* bodyB = get_body(world, joint->bodyB);
     
     if (!bodyA || !bodyB) return;
     
@@ -115,6 +115,11 @@ void init_joint_velocity_constraints(struct PhysicsWorld* world, float dt);
 void solve_joint_velocity_constraints(struct PhysicsWorld* world);
 void solve_joint_position_constraints(struct PhysicsWorld* world);
 
+// Single-joint entry points, dispatching on type. The constraint graph solves
+// joints one at a time, interleaved with contacts of the same color.
+void solve_joint_velocity(Joint* joint, struct PhysicsWorld* world);
+void solve_joint_position(Joint* joint, struct PhysicsWorld* world);
+
 // Individual joint solvers
 void solve_distance_joint_velocity(Joint* joint, struct PhysicsWorld* world);
 void solve_revolute_joint_velocity(Joint* joint, struct PhysicsWorld* world);
@@ -1,14 +1,31 @@
 #include "physics.h"
 #include "broadphase.h"
+#include "tree_query.h"
 #include "joints.h"
+#include "constraint_graph.h"
+#include "contact_solver.h"
+#include "island.h"
+#include "contact_table.h"
+#include "continuous.h"
+#include "polygon.h"
+#include "chain.h"
+#include "thread_pool.h"
 #include <cmath>
 #include <cstdlib>
 #include <algorithm>
-#include <map>
+#include <functional>
 #include <vector>
 
 #define PI 3.14159265359f
 
+// The wide contact solver (contact_solver.h) must agree with the scalar one
+// here bit for bit, and it cannot if the compiler turns a * b + c into a
+// fused multiply-add on one side and not the other. Clang does that within an
+// expression wherever the target has FMA, which is every ARM64 target.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+
 struct Vec2 {
     float x, y;
     Vec2 operator+(const Vec2& v) const { return {x + v.x, y + v.y}; }
@@ -22,34 +39,338 @@ struct Vec2 {
 
 inline Vec2 cross(Vec2 v, float s) { return {s * v.y, -s * v.x}; }
 inline Vec2 cross(float s, Vec2 v) { return {-s * v.y, s * v.x}; }
-inline Vec2 rotate(Vec2 v, float angle) {
-    float c = std::cos(angle);
-    float s = std::sin(angle);
-    return { v.x * c - v.y * s, v.x * s + v.y * c };
-}
-
-// Internal cache for warm starting
-// Key: (minId << 32) | maxId
-// Value: Stored impulses for the contact point
-struct CachedImpulse {
-    float normalImpulse;
-    float tangentImpulse;
-};
-using ImpulseCache = std::map<uint64_t, CachedImpulse>;
+inline Vec2 rotate(Vec2 v, Rot q) { return { v.x * q.c - v.y * q.s, v.x * q.s + v.y * q.c }; }
+inline Vec2 inv_rotate(Vec2 v, Rot q) { return { v.x * q.c + v.y * q.s, v.y * q.c - v.x * q.s }; }
+
+// --- Contact solver ---
+//
+// Each pass below works on one constraint at a time, so the serial loop and
+// the colored parallel one run exactly the same code. Static bodies are only
+// ever read, which is what makes sharing them across colors safe.
+
+static inline void apply_contact_impulse(SolverBody& a, SolverBody& b, Vec2 ra, Vec2 rb, Vec2 P) {
+    if (a.type != STATIC) { a.vx -= P.x * a.inverseMass; a.vy -= P.y * a.inverseMass; a.angularVelocity -= ra.cross(P) * a.inverseInertia; }
+    if (b.type != STATIC) { b.vx += P.x * b.inverseMass; b.vy += P.y * b.inverseMass; b.angularVelocity += rb.cross(P) * b.inverseInertia; }
+}
 
-// Key layout: [minId:24][maxId:24][pointIndex:8], order-independent in the
-// body pair. The previous packing was (minId<<32)|(maxId<<4)|j, whose maxId
-// field overlapped minId's bits once maxId reached 2^28 — a silent collision
-// that would hand a contact the wrong cached impulse.
-static inline uint64_t contact_cache_key(uint32_t bodyA, uint32_t bodyB, int pointIndex) {
-    uint64_t lo = std::min(bodyA, bodyB);
-    uint64_t hi = std::max(bodyA, bodyB);
-    return (lo << 40) | (hi << 8) | (uint64_t)(pointIndex & 0xFF);
+// Applies the impulses the constraint was seeded with from last step.
+static void warm_start_contact(PhysicsWorld* world, ContactConstraint& c) {
+    SolverBody& a = world->solverBodies[c.bodyA];
+    SolverBody& b = world->solverBodies[c.bodyB];
+    const Vec2 normal = {c.normalX, c.normalY}, tangent = {-c.normalY, c.normalX};
+    for (int j = 0; j < c.pointCount; j++) {
+        const ContactConstraintPoint& cp = c.points[j];
+        const Vec2 ra = {cp.anchorAx, cp.anchorAy}, rb = {cp.anchorBx, cp.anchorBy};
+        apply_contact_impulse(a, b, ra, rb, normal * cp.normalImpulse + tangent * cp.tangentImpulse);
+    }
+}
+
+static void solve_contact_velocity(PhysicsWorld* world, ContactConstraint& c) {
+    SolverBody& a = world->solverBodies[c.bodyA], &b = world->solverBodies[c.bodyB];
+    if (!a.isAwake && !b.isAwake) return;
+
+    Vec2 normal = {c.normalX, c.normalY}, tangent = {-c.normalY, c.normalX};
+    for (int j = 0; j < c.pointCount; ++j) {
+        ContactConstraintPoint& cp = c.points[j];
+        Vec2 ra = {cp.anchorAx, cp.anchorAy}, rb = {cp.anchorBx, cp.anchorBy};
+        Vec2 dv = (Vec2{b.vx, b.vy} + cross(b.angularVelocity, rb)) - (Vec2{a.vx, a.vy} + cross(a.angularVelocity, ra));
+
+        // Normal Impulse with Restitution Bias
+        float vn = dv.dot(normal);
+        float bias = c.softness.massScale * c.softness.biasRate * cp.baseSeparation;
+        if (c.restitution > 0) bias -= c.restitution * vn; // Add bounce
+
+        float lambda = -cp.normalMass * (c.softness.massScale * vn + bias) - c.softness.impulseScale * cp.normalImpulse;
+        float oldImpulse = cp.normalImpulse;
+        cp.normalImpulse = std::max(oldImpulse + lambda, 0.0f);
+        lambda = cp.normalImpulse - oldImpulse;
+        apply_contact_impulse(a, b, ra, rb, normal * lambda);
+
+        // Friction Impulse
+        dv = (Vec2{b.vx, b.vy} + cross(b.angularVelocity, rb)) - (Vec2{a.vx, a.vy} + cross(a.angularVelocity, ra));
+        float lambdaT = -cp.tangentMass * dv.dot(tangent);
+        float maxF = c.friction * cp.normalImpulse;
+        oldImpulse = cp.tangentImpulse;
+        cp.tangentImpulse = std::max(-maxF, std::min(oldImpulse + lambdaT, maxF));
+        lambdaT = cp.tangentImpulse - oldImpulse;
+        apply_contact_impulse(a, b, ra, rb, tangent * lambdaT);
+    }
+}
+
+// Position correction (pseudo-impulse for rotation stability).
+//
+// This used to re-run the entire narrow phase — SAT and all — inside every
+// position iteration. With 4 iterations and 2 sub-steps that meant the same
+// box pair went through the box SAT eight times per frame, purely to
+// re-derive a penetration depth.
+//
+// The constraint already carries what is needed: the contact anchors
+// relative to each body centre, and baseSeparation from manifold time. At
+// that moment the two anchor points coincide in world space, so the current
+// separation is baseSeparation plus however far the anchors have drifted
+// apart along the normal. That is a dot product, and it shrinks as the
+// solver pushes the bodies apart — which is exactly the feedback the
+// re-detection was providing.
+//
+// This is how Box2D's position solver works, and it is why those fields
+// exist on ContactConstraintPoint.
+static void solve_contact_position(PhysicsWorld* world, ContactConstraint& c) {
+    const float slop = 0.01f, baumgarte = 0.2f;
+    SolverBody& a = world->solverBodies[c.bodyA], &b = world->solverBodies[c.bodyB];
+    if (!a.isAwake && !b.isAwake) return;
+    if (c.pointCount == 0) return;
+
+    const Vec2 normal = { c.normalX, c.normalY };
+    const Vec2 posA = { a.x, a.y };
+    const Vec2 posB = { b.x, b.y };
+
+    for (int j = 0; j < c.pointCount; ++j) {
+        ContactConstraintPoint& cp = c.points[j];
+        const Vec2 ra = { cp.anchorAx, cp.anchorAy };
+        const Vec2 rb = { cp.anchorBx, cp.anchorBy };
+
+        // Anchors coincided when the manifold was built, so the drift
+        // along the normal is the separation gained since then.
+        const float drift = ((posB + rb) - (posA + ra)).dot(normal);
+        const float separation = cp.baseSeparation + drift;
+
+        const float C = std::max(-separation - slop, 0.0f) * baumgarte;
+        if (C <= 0.0f) continue;
+
+        const float raN = ra.cross(normal), rbN = rb.cross(normal);
+        const float k = a.inverseMass + b.inverseMass +
+                        raN * raN * a.inverseInertia + rbN * rbN * b.inverseInertia;
+        if (k <= 1e-6f) continue;
+
+        const Vec2 P = normal * (C / k);
+        if (a.type != STATIC) { a.x -= P.x * a.inverseMass; a.y -= P.y * a.inverseMass; a.rotation -= ra.cross(P) * a.inverseInertia; }
+        if (b.type != STATIC) { b.x += P.x * b.inverseMass; b.y += P.y * b.inverseMass; b.rotation += rb.cross(P) * b.inverseInertia; }
+    }
+}
+
+// --- Soft step (Box2D v3's solver) ---
+//
+// The NGS path above solves velocities with a Baumgarte-free soft bias and
+// then corrects positions in a separate pseudo-impulse pass that knows
+// nothing about Softness. The soft step folds position error into the
+// velocity solve instead, and gets its stiffness from taking several small
+// substeps rather than many iterations of one big one:
+//
+//   prepare; per substep { integrate velocities, warm start, solve (biased),
+//   integrate positions, relax (unbiased) }; restitution.
+//
+// Relaxing removes the velocity the bias added, so position correction does
+// not turn into bounce. Anchors stay fixed for the whole step; the current
+// separation is rebuilt from how far the bodies have moved since the
+// manifold, which is what solve_contact_position already does.
+
+// Box2D's contactPushMaxVelocity (3 m/s) in pixels: how fast overlap is
+// pushed out, however deep.
+constexpr float kContactPushMaxVelocity = 3.0f * 100.0f;
+
+// Per step, before the first substep: softness for the substep length, pure
+// effective masses (collide_pair folds the NGS mass scale into them) and the
+// approach velocity the restitution pass will bounce back.
+static void prepare_contact_soft(PhysicsWorld* world, ContactConstraint& c,
+                                 const Softness& contactSoftness, const Softness& staticSoftness) {
+    const SolverBody& a = world->solverBodies[c.bodyA];
+    const SolverBody& b = world->solverBodies[c.bodyB];
+    // Against something immovable the contact can be twice as stiff; Box2D's
+    // staticSoftness.
+    c.softness = (a.inverseMass == 0.0f || b.inverseMass == 0.0f) ? staticSoftness : contactSoftness;
+
+    const Vec2 normal = {c.normalX, c.normalY};
+    for (int j = 0; j < c.pointCount; ++j) {
+        ContactConstraintPoint& cp = c.points[j];
+        const Vec2 ra = {cp.anchorAx, cp.anchorAy}, rb = {cp.anchorBx, cp.anchorBy};
+        const float raN = ra.cross(normal), rbN = rb.cross(normal);
+        const float kN = a.inverseMass + b.inverseMass + raN * raN * a.inverseInertia + rbN * rbN * b.inverseInertia;
+        cp.normalMass = kN > 0.0f ? 1.0f / kN : 0.0f;
+
+        const Vec2 dv = (Vec2{b.vx, b.vy} + cross(b.angularVelocity, rb)) - (Vec2{a.vx, a.vy} + cross(a.angularVelocity, ra));
+        cp.relativeVelocity = dv.dot(normal);
+        cp.maxNormalImpulse = 0.0f;
+    }
+}
+
+// One soft-step pass over a contact: the biased solve when useBias is set,
+// the relax pass when not.
+static void solve_contact_soft(PhysicsWorld* world, ContactConstraint& c, float inv_h, bool useBias) {
+    SolverBody& a = world->solverBodies[c.bodyA], &b = world->solverBodies[c.bodyB];
+    if (!a.isAwake && !b.isAwake) return;
+
+    const Vec2 normal = {c.normalX, c.normalY}, tangent = {-c.normalY, c.normalX};
+    const Vec2 posA = {a.x, a.y}, posB = {b.x, b.y};
+    // The anchors turn with their bodies; over one step the angle is small
+    // enough that the first-order rotation does.
+    const float dA = a.rotation - c.rotationA, dB = b.rotation - c.rotationB;
+
+    for (int j = 0; j < c.pointCount; ++j) {
+        ContactConstraintPoint& cp = c.points[j];
+        const Vec2 ra = {cp.anchorAx, cp.anchorAy}, rb = {cp.anchorBx, cp.anchorBy};
+        const Vec2 raNow = ra + cross(dA, ra), rbNow = rb + cross(dB, rb);
+        const float s = cp.baseSeparation + ((posB + rbNow) - (posA + raNow)).dot(normal);
+
+        float bias = 0.0f, massScale = 1.0f, impulseScale = 0.0f;
+        if (s > 0.0f) {
+            // Apart for now: let them close the gap this substep, no more.
+            bias = s * inv_h;
+        } else if (useBias) {
+            bias = std::max(c.softness.biasRate * s, -kContactPushMaxVelocity);
+            massScale = c.softness.massScale;
+            impulseScale = c.softness.impulseScale;
+        }
+
+        const Vec2 dv = (Vec2{b.vx, b.vy} + cross(b.angularVelocity, rb)) - (Vec2{a.vx, a.vy} + cross(a.angularVelocity, ra));
+        const float vn = dv.dot(normal);
+        const float impulse = -cp.normalMass * massScale * (vn + bias) - impulseScale * cp.normalImpulse;
+        const float newImpulse = std::max(cp.normalImpulse + impulse, 0.0f);
+        const float applied = newImpulse - cp.normalImpulse;
+        cp.normalImpulse = newImpulse;
+        cp.maxNormalImpulse = std::max(cp.maxNormalImpulse, applied);
+        apply_contact_impulse(a, b, ra, rb, normal * applied);
+    }
+
+    for (int j = 0; j < c.pointCount; ++j) {
+        ContactConstraintPoint& cp = c.points[j];
+        const Vec2 ra = {cp.anchorAx, cp.anchorAy}, rb = {cp.anchorBx, cp.anchorBy};
+        const Vec2 dv = (Vec2{b.vx, b.vy} + cross(b.angularVelocity, rb)) - (Vec2{a.vx, a.vy} + cross(a.angularVelocity, ra));
+        const float maxF = c.friction * cp.normalImpulse;
+        const float newImpulse = std::max(-maxF, std::min(cp.tangentImpulse - cp.tangentMass * dv.dot(tangent), maxF));
+        const float applied = newImpulse - cp.tangentImpulse;
+        cp.tangentImpulse = newImpulse;
+        apply_contact_impulse(a, b, ra, rb, tangent * applied);
+    }
+}
+
+// After the last substep: bounce back the approach velocity of points that
+// arrived fast enough and actually pushed. The NGS path folds restitution
+// into every velocity iteration instead.
+static void apply_contact_restitution(PhysicsWorld* world, ContactConstraint& c) {
+    if (c.restitution == 0.0f) return;
+    SolverBody& a = world->solverBodies[c.bodyA], &b = world->solverBodies[c.bodyB];
+    if (!a.isAwake && !b.isAwake) return;
+
+    const Vec2 normal = {c.normalX, c.normalY};
+    const float threshold = world->restitutionThreshold;
+    for (int j = 0; j < c.pointCount; ++j) {
+        ContactConstraintPoint& cp = c.points[j];
+        if (cp.relativeVelocity > -threshold || cp.maxNormalImpulse == 0.0f) continue;
+
+        const Vec2 ra = {cp.anchorAx, cp.anchorAy}, rb = {cp.anchorBx, cp.anchorBy};
+        const Vec2 dv = (Vec2{b.vx, b.vy} + cross(b.angularVelocity, rb)) - (Vec2{a.vx, a.vy} + cross(a.angularVelocity, ra));
+        const float vn = dv.dot(normal);
+        const float impulse = -cp.normalMass * (vn + c.restitution * cp.relativeVelocity);
+        const float newImpulse = std::max(cp.normalImpulse + impulse, 0.0f);
+        const float applied = newImpulse - cp.normalImpulse;
+        cp.normalImpulse = newImpulse;
+        cp.maxNormalImpulse = std::max(cp.maxNormalImpulse, applied);
+        apply_contact_impulse(a, b, ra, rb, normal * applied);
+    }
+}
+
+// Constraints handed to one pool task. Large enough that a task outweighs the
+// cost of claiming it, small enough that a color of a few hundred contacts
+// still spreads across the cores.
+constexpr int kSolverBlockSize = 32;
+
+// Solves one color across the pool: its `wideCount` WideContacts with
+// wideFn, then the contacts they do not hold one at a time, then its joints.
+static void solve_color_parallel(PhysicsWorld* world, const GraphColor& color,
+                                 WideContact* wide, int wideCount,
+                                 const std::function<void(WideContact&)>& wideFn,
+                                 const std::function<void(ContactConstraint&)>& contactFn,
+                                 const std::function<void(Joint&)>& jointFn) {
+    const int scalarBegin = wideCount * kContactLanes;
+    const int contactCount = (int)color.contacts.size() - scalarBegin;
+    const int jointCount = (int)color.joints.size();
+    const int total = wideCount + contactCount + jointCount;
+    const int blocks = (total + kSolverBlockSize - 1) / kSolverBlockSize;
+    flash::ThreadPool::instance().parallel_for(blocks, [&](int block) {
+        const int begin = block * kSolverBlockSize;
+        const int end = std::min(begin + kSolverBlockSize, total);
+        for (int k = begin; k < end; ++k) {
+            if (k < wideCount) wideFn(wide[k]);
+            else if (k - wideCount < contactCount) contactFn(world->constraints[color.contacts[scalarBegin + k - wideCount]]);
+            else jointFn(world->boxJoints[color.joints[k - wideCount - contactCount]]);
+        }
+    });
+}
+
+// A constraint is solved while at least one of its bodies is. The contacts
+// and joints of a sleeping island stay in their arrays — contacts keep their
+// impulses for when it wakes — and are skipped.
+static inline bool constraint_awake(const PhysicsWorld* world, uint32_t bodyA, uint32_t bodyB) {
+    auto awake = [world](uint32_t id) {
+        return id < (uint32_t)world->activeCount && world->solverBodies[id].isAwake;
+    };
+    return awake(bodyA) || awake(bodyB);
+}
+
+// Runs `iterations` solver passes over every awake contact and joint.
+//
+// Serial: all contacts, then all joints, per iteration, as it always was.
+//
+// Graph colored: per iteration the colors run in order, each split across the
+// pool, and the overflow set last on the calling thread. Given a wideFn, the
+// contacts world->wideContacts holds go to it four at a time instead of to
+// contactFn; the other paths ignore it.
+//
+// Islands: one pool task per island, running every iteration over that
+// island's constraints. Islands share no body the solver writes, so each task
+// sees exactly the serial order restricted to its island, and the result is
+// bit-identical to the serial solver. One dispatch per pass rather than one
+// per color per iteration — but one huge pile is one task.
+template <typename ContactFn, typename JointFn>
+static void solve_pass(PhysicsWorld* world, int iterations, ContactFn contactFn, JointFn jointFn,
+                       const std::function<void(WideContact&)>& wideFn = nullptr) {
+    if (world->solverThreading == SOLVER_THREADING_ISLANDS) {
+        const IslandSet* set = world->islands;
+        flash::ThreadPool::instance().parallel_for(set->solveCount, [&](int k) {
+            const Island& island = set->islands[set->solveOrder[k]];
+            for (int iter = 0; iter < iterations; ++iter) {
+                for (int32_t i : island.contacts) contactFn(world->constraints[i]);
+                for (int32_t i : island.joints) jointFn(world->boxJoints[i]);
+            }
+        });
+        return;
+    }
+
+    if (world->solverThreading == SOLVER_THREADING_GRAPH_COLORED) {
+        const ConstraintGraph* graph = world->constraintGraph;
+        const std::function<void(ContactConstraint&)> contacts = contactFn;
+        const std::function<void(Joint&)> joints = jointFn;
+        WideContactSet* wide = world->wideContacts;
+        for (int iter = 0; iter < iterations; ++iter) {
+            for (int c = 0; c < graph->activeColorCount; ++c) {
+                const int begin = wideFn ? wide->colorStart[c] : 0;
+                const int count = wideFn ? wide->colorStart[c + 1] - begin : 0;
+                solve_color_parallel(world, graph->colors[c], count ? &wide->contacts[begin] : nullptr, count,
+                                     wideFn, contacts, joints);
+            }
+            for (int32_t i : graph->overflow.contacts) contactFn(world->constraints[i]);
+            for (int32_t i : graph->overflow.joints) jointFn(world->boxJoints[i]);
+        }
+        return;
+    }
+
+    for (int iter = 0; iter < iterations; ++iter) {
+        for (int i = 0; i < world->activeConstraints; ++i) {
+            ContactConstraint& c = world->constraints[i];
+            if (constraint_awake(world, c.bodyA, c.bodyB)) contactFn(c);
+        }
+        for (int i = 0; i < world->activeBoxJoints; ++i) {
+            Joint& j = world->boxJoints[i];
+            if (constraint_awake(world, j.bodyA, j.bodyB)) jointFn(j);
+        }
+    }
 }
 
 extern "C" {
 
-FLASH_API PhysicsWorld* create_physics_world(int maxBodies) {
+FLASH_API PhysicsWorld* create_physics_world(int maxBodies, int32_t broadphase) {
+    if (maxBodies <= 0 || maxBodies > kMaxContactBodies) return NULL;
+
     // Use calloc to ensure all fields are zeroed (prevents uninitialized garbage)
     PhysicsWorld* world = (PhysicsWorld*)calloc(1, sizeof(PhysicsWorld));
     if (!world) return NULL;
@@ -80,8 +401,9 @@ FLASH_API PhysicsWorld* create_physics_world(int maxBodies) {
     world->softBodies = (NativeSoftBody*)calloc(world->maxSoftBodies, sizeof(NativeSoftBody));
     world->activeSoftBodies = 0;
 
-    // Create dynamic AABB tree for broadphase
-    world->tree = create_dynamic_tree(maxBodies * 2);
+    // Create dynamic AABB trees for broadphase
+    world->tree = create_dynamic_tree(maxBodies * 2, broadphase);
+    world->staticTree = create_dynamic_tree(maxBodies * 2, BROADPHASE_TREE);
     
     world->bodyFreeList = (int32_t*)calloc(maxBodies, sizeof(int32_t));
     world->bodyFreeCount = 0;
@@ -94,6 +416,21 @@ FLASH_API PhysicsWorld* create_physics_world(int maxBodies) {
     world->maxBoxJoints = 200;
     world->boxJoints = (Joint*)calloc(world->maxBoxJoints, sizeof(Joint));
     world->activeBoxJoints = 0;
+
+    world->solverMode = SOLVER_MODE_NGS;
+    world->subStepCount = 4;
+    world->wideContactSolver = 1;
+
+    world->islands = create_island_set(maxBodies);
+    world->contactTable = create_contact_table(maxBodies, world->maxConstraints);
+    world->continuous = create_continuous_set(maxBodies);
+    world->previousPoses = (BodyPose*)calloc(maxBodies, sizeof(BodyPose));
+    world->renderPoses = (BodyPose*)calloc(maxBodies, sizeof(BodyPose));
+    world->polygons = (PolygonShape*)calloc(maxBodies, sizeof(PolygonShape));
+    world->chains = create_chain_set(maxBodies);
+    world->solverBodies = (SolverBody*)calloc(maxBodies, sizeof(SolverBody));
+    world->awakeBodies = (int32_t*)calloc(maxBodies, sizeof(int32_t));
+    world->awakeAccelerations = (BodyAcceleration*)calloc(maxBodies, sizeof(BodyAcceleration));
     
     return world;
 }
@@ -107,9 +444,16 @@ FLASH_API void destroy_physics_world(PhysicsWorld* world) {
     free(world->bodies);
     free(world->constraints);
     destroy_dynamic_tree(world->tree);
+    destroy_dynamic_tree(world->staticTree);
     free(world->boxJoints);
     free(world->pairScratch);
     free(world->bodyFreeList);
+    free(world->previousPoses);
+    free(world->renderPoses);
+    free(world->polygons);
+    free(world->solverBodies);
+    free(world->awakeBodies);
+    free(world->awakeAccelerations);
 
     for (int i = 0; i < world->activeSoftBodies; ++i) {
         free(world->softBodies[i].points);
@@ -117,9 +461,14 @@ FLASH_API void destroy_physics_world(PhysicsWorld* world) {
     }
     free(world->softBodies);
 
-    // The warm-start cache is a real C++ object (new'd std::map), so it is
-    // the one allocation here that genuinely needs delete.
-    delete static_cast<ImpulseCache*>(world->warmStartCache);
+    // The C++ side tables are new'd, so they are the allocations here that
+    // genuinely need delete.
+    destroy_contact_table(world->contactTable);
+    destroy_constraint_graph(world->constraintGraph);
+    destroy_wide_contact_set(world->wideContacts);
+    destroy_island_set(world->islands);
+    destroy_continuous_set(world->continuous);
+    destroy_chain_set(world->chains);
 
     free(world);
 }
@@ -130,8 +479,25 @@ struct CollisionManifold {
     Vec2 contacts[2];
     int contactCount;
     bool collided;
+    // Per contact point. The circle and box detectors report one depth for
+    // the whole manifold and copy -penetration into both; clipping gives each
+    // point its own, so a tilted face resting on an edge is not pushed out
+    // as if both ends were as deep as the deepest.
+    float separations[2];
+    // Per contact point, Box2D's feature id: which shape's face is the
+    // reference, that face, and the incident vertex the point was clipped
+    // from. It names the same point from one step to the next however the
+    // manifold is ordered. Zero for the one-point circle manifolds.
+    uint32_t ids[2];
 };
 
+// Feature ids: the reference edge, the incident vertex, and whether the
+// reference face belongs to the pair's second shape.
+constexpr uint32_t kFeatureFlipped = 1u << 16;
+static inline uint32_t make_feature_id(int referenceEdge, int incidentVertex, bool flip) {
+    return (flip ? kFeatureFlipped : 0u) | (uint32_t)referenceEdge << 8 | (uint32_t)incidentVertex;
+}
+
 // --- Collision Detection (SAT & Math) ---
 
 CollisionManifold detectCircleCircle(NativeBody& a, NativeBody& b) {
@@ -141,10 +507,10 @@ CollisionManifold detectCircleCircle(NativeBody& a, NativeBody& b) {
     float distSq = d.lengthSq();
     float radiusSum = a.radius + b.radius;
 
-    if (distSq >= radiusSum * radiusSum) return {{0,0}, 0, {{0,0}}, 0, false};
+    if (distSq >= radiusSum * radiusSum) return {{0,0}, 0, {{0,0}}, 0, false, {0,0}, {0,0}};
 
     float dist = std::sqrt(distSq);
-    CollisionManifold m;
+    CollisionManifold m = {};
     m.collided = true;
     m.contactCount = 1;
 
@@ -157,6 +523,7 @@ CollisionManifold detectCircleCircle(NativeBody& a, NativeBody& b) {
         m.normal = d * (1.0f / dist);
         m.contacts[0] = posB - (m.normal * b.radius);
     }
+    m.separations[0] = m.separations[1] = -m.penetration;
     return m;
 }
 
@@ -167,11 +534,11 @@ struct BoxFrame {
 };
 
 static inline BoxFrame make_box_frame(const NativeBody& body) {
-    // One sin/cos for the whole body. The previous version called rotate()
-    // — and therefore cos+sin — for all four corners on each of four axes,
-    // for both bodies: 64 trig calls per pair where 4 suffice.
-    const float c = std::cos(body.rotation);
-    const float s = std::sin(body.rotation);
+    // The body's own cos and sin, taken once when it last rotated. The
+    // first version called cos+sin for all four corners on each of four
+    // axes, for both bodies: 64 trig calls per pair.
+    const float c = body.q.c;
+    const float s = body.q.s;
     const float hw = body.width * 0.5f;
     const float hh = body.height * 0.5f;
 
@@ -190,76 +557,6 @@ static inline BoxFrame make_box_frame(const NativeBody& body) {
     return f;
 }
 
-static inline void project_frame(const BoxFrame& f, Vec2 axis, float& min, float& max) {
-    min = max = axis.dot(f.corners[0]);
-    for (int i = 1; i < 4; ++i) {
-        const float p = axis.dot(f.corners[i]);
-        if (p < min) min = p;
-        if (p > max) max = p;
-    }
-}
-
-CollisionManifold detectBoxBox(NativeBody& a, NativeBody& b) {
-    const BoxFrame fa = make_box_frame(a);
-    const BoxFrame fb = make_box_frame(b);
-
-    float minOverlap = 1e10f;
-    Vec2 bestAxis;
-    NativeBody* ref = &a;
-    NativeBody* inc = &b;
-    const BoxFrame* incFrame = &fb;
-
-    const Vec2 axes[4] = { fa.axisX, fa.axisY, fb.axisX, fb.axisY };
-
-    for (int i = 0; i < 4; ++i) {
-        float minA, maxA, minB, maxB;
-        project_frame(fa, axes[i], minA, maxA);
-        project_frame(fb, axes[i], minB, maxB);
-
-        float overlap = std::min(maxA, maxB) - std::max(minA, minB);
-        if (overlap <= 0) return {{0,0}, 0, {{0,0}}, 0, false};
-
-        if (overlap < minOverlap) {
-            minOverlap = overlap;
-            bestAxis = axes[i];
-            if (i < 2) { ref = &a; inc = &b; incFrame = &fb; }
-            else       { ref = &b; inc = &a; incFrame = &fa; }
-        }
-    }
-
-    Vec2 d = {b.x - a.x, b.y - a.y};
-    if (bestAxis.dot(d) < 0) bestAxis = bestAxis * -1.0f;
-
-    CollisionManifold m;
-    m.collided = true;
-    m.normal = bestAxis;
-    m.penetration = minOverlap;
-    m.contactCount = 0;
-
-    // Stable Multi-point Contact: vertices of 'inc' that overlap 'ref' on bestAxis.
-    // Corners are reused from the frame built at the top — no more trig here.
-    const Vec2* v_inc = incFrame->corners;
-
-    float minA, maxA;
-    project_frame(ref == &a ? fa : fb, bestAxis, minA, maxA);
-
-    for (int i = 0; i < 4; ++i) {
-        float p = bestAxis.dot(v_inc[i]);
-        // If vertex is inside reference body's SAT projection (with slop)
-        if (p <= maxA + 0.01f) {
-            m.contacts[m.contactCount++] = v_inc[i] + (bestAxis * (minOverlap * 0.5f));
-            if (m.contactCount >= 2) break;
-        }
-    }
-    
-    if (m.contactCount == 0) {
-        // Fallback for safety
-        m.contactCount = 1;
-        m.contacts[0] = {inc->x, inc->y};
-    }
-    return m;
-}
-
 // Box2D's softness calculation for spring-damped constraints
 inline Softness makeSoftness(float hertz, float dampingRatio, float h) {
     if (hertz == 0.0f) {
@@ -287,7 +584,7 @@ CollisionManifold detectCircleBox(NativeBody& circle, NativeBody& box) {
     Vec2 pb = {box.x, box.y};
     
     Vec2 d = pc - pb;
-    Vec2 localD = rotate(d, -box.rotation);
+    Vec2 localD = inv_rotate(d, box.q);
 
     float hw = box.width * 0.5f;
     float hh = box.height * 0.5f;
@@ -297,144 +594,564 @@ CollisionManifold detectCircleBox(NativeBody& circle, NativeBody& box) {
     float distSq = localNormal.lengthSq();
     float r = circle.radius;
 
-    if (distSq > r * r && (std::abs(localD.x) > hw || std::abs(localD.y) > hh)) return {{0,0}, 0, {{0,0}}, 0, false};
+    if (distSq > r * r && (std::abs(localD.x) > hw || std::abs(localD.y) > hh)) return {{0,0}, 0, {{0,0}}, 0, false, {0,0}, {0,0}};
 
     float dist = std::sqrt(distSq);
-    CollisionManifold m;
+    CollisionManifold m = {};
     m.collided = true;
     m.contactCount = 1;
     
     if (dist > 0.0001f) {
-        m.normal = rotate(localNormal, box.rotation) * (1.0f / dist);
+        m.normal = rotate(localNormal, box.q) * (1.0f / dist);
     } else {
         float dx = hw - std::abs(localD.x);
         float dy = hh - std::abs(localD.y);
         if (dx < dy) {
-            m.normal = rotate({(localD.x > 0) ? 1.0f : -1.0f, 0}, box.rotation);
+            m.normal = rotate({(localD.x > 0) ? 1.0f : -1.0f, 0}, box.q);
             dist = -dx;
         } else {
-            m.normal = rotate({0, (localD.y > 0) ? 1.0f : -1.0f}, box.rotation);
+            m.normal = rotate({0, (localD.y > 0) ? 1.0f : -1.0f}, box.q);
             dist = -dy;
         }
     }
     
     m.penetration = r - dist;
-    m.contacts[0] = pb + rotate(closest, box.rotation);
+    m.contacts[0] = pb + rotate(closest, box.q);
+    m.separations[0] = m.separations[1] = -m.penetration;
     return m;
 }
 
-// --- Solver ---
+// --- Polygons ---
+//
+// The BoxFrame idea generalised: a body's world-space vertices and edge
+// normals, built once per pair so the SAT and clipping below are plain
+// arithmetic. A box is the 4-vertex case, so box-box and box-polygon pairs
+// need no code of their own. Box-box pairs had their own SAT, which took up
+// to two incident corners that overlapped the reference box's projection
+// and pushed each out by half the depth of the whole manifold; clipping the
+// incident face gives each point where it is and how deep it is.
+//
+// Vertices are kept as separate x and y arrays padded to kMaxPolygonVertices
+// by repeating the last one. A repeated vertex projects where the original
+// does, so min/max over all eight is the same as over `count`, and the
+// fixed-length loops in find_max_separation vectorise without a remainder.
+struct PolygonFrame {
+    int count;
+    float x[kMaxPolygonVertices], y[kMaxPolygonVertices];
+    float nx[kMaxPolygonVertices], ny[kMaxPolygonVertices];
+};
 
-void step_soft_body(PhysicsWorld* world, float dt);
+static inline PolygonFrame make_polygon_frame(const NativeBody& body, const PolygonShape* polygon) {
+    PolygonFrame f;
+    if (!polygon) {
+        // A box: BoxFrame's corners are counter-clockwise from the bottom
+        // left, and its edges' normals are its axes.
+        const BoxFrame box = make_box_frame(body);
+        const Vec2 normals[4] = { box.axisY * -1.0f, box.axisX, box.axisY, box.axisX * -1.0f };
+        f.count = 4;
+        for (int i = 0; i < 4; ++i) {
+            f.x[i] = box.corners[i].x;
+            f.y[i] = box.corners[i].y;
+            f.nx[i] = normals[i].x;
+            f.ny[i] = normals[i].y;
+        }
+    } else {
+        const float c = body.q.c;
+        const float s = body.q.s;
+        f.count = polygon->count;
+        for (int i = 0; i < f.count; ++i) {
+            f.x[i] = body.x + c * polygon->x[i] - s * polygon->y[i];
+            f.y[i] = body.y + s * polygon->x[i] + c * polygon->y[i];
+            f.nx[i] = c * polygon->nx[i] - s * polygon->ny[i];
+            f.ny[i] = s * polygon->nx[i] + c * polygon->ny[i];
+        }
+    }
+    for (int i = f.count; i < kMaxPolygonVertices; ++i) {
+        f.x[i] = f.x[f.count - 1];
+        f.y[i] = f.y[f.count - 1];
+    }
+    return f;
+}
 
-FLASH_API void step_physics(PhysicsWorld* world, float dt) {
-    if (!world || dt <= 0) return;
+// b2FindMaxSeparation: the edge of `p1` that `p2` is furthest out of, and
+// that distance. Negative when they overlap, along every edge.
+static float find_max_separation(const PolygonFrame& p1, const PolygonFrame& p2, int& edge) {
+    float best = -INFINITY;
+    edge = 0;
+    for (int i = 0; i < p1.count; ++i) {
+        const float nx = p1.nx[i], ny = p1.ny[i];
+        const float offset = nx * p1.x[i] + ny * p1.y[i];
+        float si = INFINITY;
+        for (int j = 0; j < kMaxPolygonVertices; ++j) {
+            si = std::min(si, nx * p2.x[j] + ny * p2.y[j]);
+        }
+        si -= offset;
+        if (si > best) { best = si; edge = i; }
+    }
+    return best;
+}
 
-    // Step Soft Bodies
-    step_soft_body(world, dt);
+// Box2D's b2_speculativeDistance: how far in front of the reference face a
+// clipped point may be and still stay in the manifold.
+constexpr float kSpeculativeDistance = 4.0f * kLinearSlop;
+
+// Box2D's b2ClipPolygons: the incident face is the edge of `inc` most
+// opposed to reference face `edge` of `ref`, and the manifold is that face
+// clipped to the reference face's side planes. Normal from ref to inc, or
+// from inc to ref when `flip` says ref is the pair's second shape.
+static CollisionManifold clip_polygons(const PolygonFrame& ref, int edge, const PolygonFrame& inc, bool flip) {
+    CollisionManifold m = {{0,0}, 0, {{0,0}}, 0, false, {0,0}, {0,0}};
+
+    const Vec2 normal = { ref.nx[edge], ref.ny[edge] };
+    int incident = 0;
+    float minDot = INFINITY;
+    for (int i = 0; i < inc.count; ++i) {
+        const float d = normal.x * inc.nx[i] + normal.y * inc.ny[i];
+        if (d < minDot) { minDot = d; incident = i; }
+    }
 
-    if (world->activeCount == 0) return;
+    const int edgeNext = edge + 1 < ref.count ? edge + 1 : 0;
+    const int incidentNext = incident + 1 < inc.count ? incident + 1 : 0;
+    const Vec2 v11 = { ref.x[edge], ref.y[edge] }, v12 = { ref.x[edgeNext], ref.y[edgeNext] };
+    const Vec2 tangent = { -normal.y, normal.x };  // along v11 -> v12
+
+    // Clip the incident edge to the slab between the reference edge's ends.
+    Vec2 clip[2] = { { inc.x[incident], inc.y[incident] }, { inc.x[incidentNext], inc.y[incidentNext] } };
+    const int vertex[2] = { incident, incidentNext };
+    const float lower = tangent.dot(v11), upper = tangent.dot(v12);
+    for (int side = 0; side < 2; ++side) {
+        const float d0 = side == 0 ? lower - tangent.dot(clip[0]) : tangent.dot(clip[0]) - upper;
+        const float d1 = side == 0 ? lower - tangent.dot(clip[1]) : tangent.dot(clip[1]) - upper;
+        if (d0 > 0.0f && d1 > 0.0f) return m;  // entirely outside this side plane
+        if (d0 > 0.0f) clip[0] = clip[0] + (clip[1] - clip[0]) * (d0 / (d0 - d1));
+        else if (d1 > 0.0f) clip[1] = clip[1] + (clip[0] - clip[1]) * (d1 / (d1 - d0));
+    }
 
-    // Phase 1: Update Broadphase Tree
-    for (int i = 0; i < world->activeCount; ++i) {
-        NativeBody& b = world->bodies[i];
-        if (!b.alive) continue;
-        b.collision_count = 0;
-        if (b.type == STATIC) continue;
-        
-        AABB aabb = calculate_body_aabb(b);
-        // Important: Update proxyId as tree_insert_leaf returns a new ID
-        b.proxyId = tree_update_leaf(world->tree, b.proxyId, aabb);
+    // Keep the clipped points behind the reference face, and, as Box2D does,
+    // those up to kSpeculativeDistance in front of it. A point dropped the
+    // moment it cleared the face came back as a new point with no impulse,
+    // so a box rocking on its corners lost its warm start at every rock;
+    // that is what brought columns down at two substeps. Unlike Box2D, a
+    // manifold with no point behind the face is still no contact, so BEGIN
+    // and END keep meaning touching. Each contact sits halfway between the
+    // two surfaces.
+    const float front = normal.dot(v11);
+    bool touching = false;
+    for (int i = 0; i < 2; ++i) {
+        const float separation = normal.dot(clip[i]) - front;
+        if (separation > kSpeculativeDistance) continue;
+        touching = touching || separation <= 0.0f;
+        m.contacts[m.contactCount] = clip[i] - normal * (0.5f * separation);
+        m.separations[m.contactCount] = separation;
+        m.ids[m.contactCount] = make_feature_id(edge, vertex[i], flip);
+        m.penetration = std::max(m.penetration, -separation);
+        ++m.contactCount;
+    }
+    if (!touching) {
+        m.contactCount = 0;
+        return m;
     }
 
-    world->activeConstraints = 0;
-    BroadphasePair* pairs = world->pairScratch;
-    int pairCount = query_tree_pairs(world->tree, pairs, world->maxPairs);
+    m.collided = true;
+    m.normal = flip ? normal * -1.0f : normal;
+    return m;
+}
 
-    Softness contactSoftness = makeSoftness(world->contactHertz, world->contactDampingRatio, dt);
+// Prefer the first shape's face unless the second's is clearly better, so
+// the reference face does not flip between two near-equal candidates from
+// step to step. Box2D's value.
+constexpr float kRelativeTolerance = 0.1f * kLinearSlop;
 
-    for (int p = 0; p < pairCount && world->activeConstraints < world->maxConstraints; ++p) {
-        int i = pairs[p].bodyA;
-        int j = pairs[p].bodyB;
-        
-        NativeBody& a = world->bodies[i];
-        NativeBody& b = world->bodies[j];
-        if (a.type == STATIC && b.type == STATIC) continue;
-        if (!((a.maskBits & b.categoryBits) != 0 && (b.maskBits & a.categoryBits) != 0)) continue;
-
-        CollisionManifold m = {{0,0}, 0, {{0,0}}, 0, false};
-        if (a.shapeType == SHAPE_CIRCLE && b.shapeType == SHAPE_CIRCLE) m = detectCircleCircle(a, b);
-        else if (a.shapeType == SHAPE_BOX && b.shapeType == SHAPE_BOX) m = detectBoxBox(a, b);
-        else if (a.shapeType == SHAPE_CIRCLE) m = detectCircleBox(a, b);
-        else { m = detectCircleBox(b, a); }
-
-        if (!m.collided) continue;
-        if (a.shapeType == SHAPE_CIRCLE && b.shapeType == SHAPE_BOX) m.normal = m.normal * -1.0f;
-
-        ContactConstraint& constraint = world->constraints[world->activeConstraints++];
-        constraint.bodyA = i;
-        constraint.bodyB = j;
-        constraint.normalX = m.normal.x;
-        constraint.normalY = m.normal.y;
-        constraint.friction = std::sqrt(a.friction * b.friction);
-        
-        // Restitution with threshold
-        float relV = (Vec2{b.vx, b.vy} - Vec2{a.vx, a.vy}).dot(m.normal);
-        constraint.restitution = (relV < -world->restitutionThreshold) ? std::max(a.restitution, b.restitution) : 0.0f;
+// Box2D's b2CollidePolygons: the reference face is the edge of least
+// penetration, then clip_polygons. Normal from a to b.
+static CollisionManifold detectPolygons(const PolygonFrame& a, const PolygonFrame& b) {
+    CollisionManifold m = {{0,0}, 0, {{0,0}}, 0, false, {0,0}, {0,0}};
+
+    int edgeA, edgeB;
+    const float separationA = find_max_separation(a, b, edgeA);
+    if (separationA > 0.0f) return m;
+    const float separationB = find_max_separation(b, a, edgeB);
+    if (separationB > 0.0f) return m;
+
+    if (separationB > separationA + kRelativeTolerance) return clip_polygons(b, edgeB, a, true);
+    return clip_polygons(a, edgeA, b, false);
+}
+
+// Box2D's b2CollidePolygonAndCircle: the face the centre is furthest out of,
+// then whichever of that face and its two end vertices is closest. Like
+// detectCircleBox, the normal points from the polygon to the circle.
+static CollisionManifold detectCirclePolygon(const NativeBody& circle, const PolygonFrame& polygon) {
+    CollisionManifold m = {{0,0}, 0, {{0,0}}, 0, false, {0,0}, {0,0}};
+    const Vec2 centre = { circle.x, circle.y };
+    const float r = circle.radius;
+
+    int edge = 0;
+    float separation = -INFINITY;
+    for (int i = 0; i < polygon.count; ++i) {
+        const float s = polygon.nx[i] * (centre.x - polygon.x[i]) + polygon.ny[i] * (centre.y - polygon.y[i]);
+        if (s > r) return m;
+        if (s > separation) { separation = s; edge = i; }
+    }
+
+    const int next = edge + 1 < polygon.count ? edge + 1 : 0;
+    const Vec2 v1 = { polygon.x[edge], polygon.y[edge] }, v2 = { polygon.x[next], polygon.y[next] };
+    Vec2 normal = { polygon.nx[edge], polygon.ny[edge] };
+    Vec2 point;
+    float distance;
+
+    if (separation > 0.0f && (centre - v1).dot(v2 - v1) <= 0.0f) {
+        // Vertex region of v1.
+        const Vec2 d = centre - v1;
+        distance = d.length();
+        if (distance > r) return m;
+        normal = d * (1.0f / distance);
+        point = v1;
+    } else if (separation > 0.0f && (centre - v2).dot(v1 - v2) <= 0.0f) {
+        const Vec2 d = centre - v2;
+        distance = d.length();
+        if (distance > r) return m;
+        normal = d * (1.0f / distance);
+        point = v2;
+    } else {
+        // Face region, including a centre inside the polygon.
+        distance = separation;
+        point = centre - normal * separation;
+    }
+
+    m.collided = true;
+    m.contactCount = 1;
+    m.normal = normal;
+    m.penetration = r - distance;
+    m.contacts[0] = point;
+    m.separations[0] = m.separations[1] = -m.penetration;
+    return m;
+}
+
+// --- Chain segments ---
+//
+// One segment of a chain, with the vertices either side of it. The normal
+// is the segment's front; nothing behind it collides.
+struct ChainSegment {
+    Vec2 v1, v2;
+    Vec2 normal;
+    Vec2 ghost1, ghost2;   // the vertex before v1 and the one after v2
+};
+
+static inline ChainSegment chain_segment(const ChainShape& chain, int i) {
+    ChainSegment seg;
+    seg.v1 = { chain.x[i], chain.y[i] };
+    seg.v2 = { chain.x[i + 1], chain.y[i + 1] };
+    seg.normal = { chain.nx[i], chain.ny[i] };
+    chain_ghosts(chain, i, seg.ghost1.x, seg.ghost1.y, seg.ghost2.x, seg.ghost2.y);
+    return seg;
+}
+
+// Box2D's b2CollideChainSegmentAndCircle. A circle past either end of the
+// segment belongs to the neighbouring segment, except in the corner region of
+// v1 beyond the previous segment's end, which this one owns — so a vertex is
+// tested once, and a circle rolling over a flat seam sees one face at a time.
+// Normal from the segment to the circle.
+static CollisionManifold detectSegmentCircle(const ChainSegment& seg, const NativeBody& circle) {
+    CollisionManifold m = {{0,0}, 0, {{0,0}}, 0, false, {0,0}, {0,0}};
+    const Vec2 p = { circle.x, circle.y };
+    const float offset = seg.normal.dot(p - seg.v1);
+    if (offset < 0.0f) return m;  // behind
+
+    const Vec2 e = seg.v2 - seg.v1;
+    const float u = e.dot(seg.v2 - p), v = e.dot(p - seg.v1);
+    Vec2 closest;
+    if (v <= 0.0f) {
+        if ((seg.v1 - seg.ghost1).dot(p - seg.v1) <= 0.0f) return m;  // the previous segment's
+        closest = seg.v1;
+    } else if (u <= 0.0f) {
+        return m;  // the next segment's, corner included
+    } else {
+        closest = seg.v1 + e * (v / e.dot(e));
+    }
+
+    const Vec2 d = p - closest;
+    const float distance = d.length();
+    if (distance > circle.radius) return m;
+
+    m.collided = true;
+    m.contactCount = 1;
+    m.normal = distance > 0.0001f && v <= 0.0f ? d * (1.0f / distance) : seg.normal;
+    m.penetration = circle.radius - (v <= 0.0f ? distance : offset);
+    m.contacts[0] = closest;
+    m.separations[0] = m.separations[1] = -m.penetration;
+    return m;
+}
+
+// Whether unit normal `n` lies on the short arc from `from` to `to`.
+static inline bool normal_between(Vec2 n, Vec2 from, Vec2 to) {
+    return from.cross(n) >= 0.0f && n.cross(to) >= 0.0f;
+}
+
+// A segment against a box or polygon: b2CollideChainSegmentAndPolygon's
+// approach, without its speculative margin. The segment is a two-sided
+// PolygonFrame for the SAT and clipping. What makes it a chain segment is
+// which normals may be used. Its own always may. The polygon's face normal
+// may only where it could be the normal of the chain's surface: in the
+// corner regions of convex vertices, between the two segments' normals. A
+// polygon face normal anywhere else is the internal-edge snag, the box
+// catching on a seam between flush segments, and the segment's normal is
+// used instead. Normal from the segment to the polygon.
+static CollisionManifold detectSegmentPolygon(const ChainSegment& seg, const PolygonFrame& polygon) {
+    CollisionManifold m = {{0,0}, 0, {{0,0}}, 0, false, {0,0}, {0,0}};
+
+    // The polygon's centroid is the mean of its vertices closely enough to
+    // say which side of the segment it is on.
+    Vec2 centre = {0.0f, 0.0f};
+    for (int i = 0; i < polygon.count; ++i) centre = centre + Vec2{polygon.x[i], polygon.y[i]};
+    centre = centre * (1.0f / polygon.count);
+    if (seg.normal.dot(centre - seg.v1) < 0.0f) return m;  // behind
+
+    PolygonFrame frame;
+    frame.count = 2;
+    for (int i = 0; i < kMaxPolygonVertices; ++i) {
+        const Vec2 v = i == 0 ? seg.v1 : seg.v2;
+        frame.x[i] = v.x;
+        frame.y[i] = v.y;
+    }
+    frame.nx[0] = seg.normal.x;  frame.ny[0] = seg.normal.y;
+    frame.nx[1] = -seg.normal.x; frame.ny[1] = -seg.normal.y;
+
+    // Only the front face counts for the segment.
+    float separationSegment = INFINITY;
+    for (int i = 0; i < kMaxPolygonVertices; ++i) {
+        separationSegment = std::min(separationSegment, seg.normal.dot(Vec2{polygon.x[i], polygon.y[i]} - seg.v1));
+    }
+    if (separationSegment > 0.0f) return m;
+    int edgePolygon;
+    const float separationPolygon = find_max_separation(polygon, frame, edgePolygon);
+    if (separationPolygon > 0.0f) return m;
+
+    if (separationPolygon > separationSegment + kRelativeTolerance) {
+        const Vec2 normal = { -polygon.nx[edgePolygon], -polygon.ny[edgePolygon] };
+        const Vec2 e = seg.v2 - seg.v1;
+        const Vec2 e1 = seg.v1 - seg.ghost1, e2 = seg.ghost2 - seg.v2;
+        const Vec2 n1 = Vec2{e1.y, -e1.x} * (1.0f / e1.length());
+        const Vec2 n2 = Vec2{e2.y, -e2.x} * (1.0f / e2.length());
+        // Solid on the left, so a left turn is a convex vertex.
+        const bool convex1 = e1.cross(e) > 0.0f, convex2 = e.cross(e2) > 0.0f;
+        if ((convex1 && normal_between(normal, n1, seg.normal)) ||
+            (convex2 && normal_between(normal, seg.normal, n2))) {
+            return clip_polygons(polygon, edgePolygon, frame, true);
+        }
+    }
+    return clip_polygons(frame, 0, polygon, false);
+}
+
+// --- Solver ---
+
+void step_soft_body(PhysicsWorld* world, float dt);
+
+// Refreshes the contact of bodies i < j, and chain segment `child`, from a
+// manifold that touches, creating it if they did not touch last step.
+static bool update_contact(PhysicsWorld* world, int i, int j, int32_t child, const CollisionManifold& m,
+                           const Softness& contactSoftness) {
+    NativeBody& a = world->bodies[i];
+    NativeBody& b = world->bodies[j];
+    ContactTable* table = world->contactTable;
+    int32_t slot = find_contact(table, i, j, child);
+    const bool began = slot < 0;
+    if (began) {
+        slot = create_contact(table, world, i, j, child);
+        if (slot < 0) return false;  // constraint array full
+    }
+    table->touchedStep[slot] = table->step;
+
+    // Updated in place. A point whose feature id was in last step's manifold
+    // takes that point's accumulated impulses for warm starting, wherever it
+    // was in the list; the rest start from zero. Matching by index gave a
+    // point its neighbour's impulses whenever the two swapped places, or one
+    // dropped out ahead of the other.
+    ContactConstraint& constraint = world->constraints[slot];
+    const int previousPointCount = world->enableWarmStarting ? constraint.pointCount : 0;
+    ContactConstraintPoint previous[2];
+    for (int c = 0; c < previousPointCount; ++c) previous[c] = constraint.points[c];
+    constraint.normalX = m.normal.x;
+    constraint.normalY = m.normal.y;
+    constraint.friction = std::sqrt(a.friction * b.friction);
+    
+    // Restitution with threshold
+    float relV = (Vec2{b.vx, b.vy} - Vec2{a.vx, a.vy}).dot(m.normal);
+    constraint.restitution = (relV < -world->restitutionThreshold) ? std::max(a.restitution, b.restitution) : 0.0f;
+    
+    constraint.pointCount = m.contactCount;
+    constraint.softness = contactSoftness;
+    constraint.rotationA = a.rotation;
+    constraint.rotationB = b.rotation;
+
+    for (int c = 0; c < m.contactCount; ++c) {
+        ContactConstraintPoint& cp = constraint.points[c];
+        cp.anchorAx = m.contacts[c].x - a.x;
+        cp.anchorAy = m.contacts[c].y - a.y;
+        cp.anchorBx = m.contacts[c].x - b.x;
+        cp.anchorBy = m.contacts[c].y - b.y;
+        cp.baseSeparation = m.separations[c];
         
-        constraint.pointCount = m.contactCount;
-        constraint.softness = contactSoftness;
-
-        for (int c = 0; c < m.contactCount; ++c) {
-            ContactConstraintPoint& cp = constraint.points[c];
-            cp.anchorAx = m.contacts[c].x - a.x;
-            cp.anchorAy = m.contacts[c].y - a.y;
-            cp.anchorBx = m.contacts[c].x - b.x;
-            cp.anchorBy = m.contacts[c].y - b.y;
-            cp.baseSeparation = -m.penetration;
-            
-            Vec2 ra = {cp.anchorAx, cp.anchorAy}, rb = {cp.anchorBx, cp.anchorBy}, normal = {m.normal.x, m.normal.y};
-            float raN = ra.cross(normal), rbN = rb.cross(normal);
-            float kN = a.inverseMass + b.inverseMass + raN * raN * a.inverseInertia + rbN * rbN * b.inverseInertia + contactSoftness.massScale;
-            cp.normalMass = kN > 0.0f ? 1.0f / kN : 0.0f;
-
-            Vec2 tangent = {-normal.y, normal.x};
-            float raT = ra.cross(tangent), rbT = rb.cross(tangent);
-            float kT = a.inverseMass + b.inverseMass + raT * raT * a.inverseInertia + rbT * rbT * b.inverseInertia;
-            cp.tangentMass = kT > 0.0f ? 1.0f / kT : 0.0f;
-            cp.normalImpulse = cp.tangentImpulse = 0.0f;
+        Vec2 ra = {cp.anchorAx, cp.anchorAy}, rb = {cp.anchorBx, cp.anchorBy}, normal = {m.normal.x, m.normal.y};
+        float raN = ra.cross(normal), rbN = rb.cross(normal);
+        float kN = a.inverseMass + b.inverseMass + raN * raN * a.inverseInertia + rbN * rbN * b.inverseInertia + contactSoftness.massScale;
+        cp.normalMass = kN > 0.0f ? 1.0f / kN : 0.0f;
+
+        Vec2 tangent = {-normal.y, normal.x};
+        float raT = ra.cross(tangent), rbT = rb.cross(tangent);
+        float kT = a.inverseMass + b.inverseMass + raT * raT * a.inverseInertia + rbT * rbT * b.inverseInertia;
+        cp.tangentMass = kT > 0.0f ? 1.0f / kT : 0.0f;
+
+        cp.id = m.ids[c];
+        cp.normalImpulse = cp.tangentImpulse = 0.0f;
+        for (int k = 0; k < previousPointCount; ++k) {
+            if (previous[k].id != cp.id) continue;
+            cp.normalImpulse = previous[k].normalImpulse;
+            cp.tangentImpulse = previous[k].tangentImpulse;
+            break;
         }
-        a.collision_count++; b.collision_count++;
     }
+    // Closing speed at the centre of the manifold, from the velocities the
+    // solver is about to start from, rotation included.
+    Vec2 centre = {0.0f, 0.0f};
+    for (int c = 0; c < m.contactCount; ++c) centre = centre + m.contacts[c];
+    if (m.contactCount > 0) centre = centre * (1.0f / m.contactCount);
+    const Vec2 ra = {centre.x - a.x, centre.y - a.y}, rb = {centre.x - b.x, centre.y - b.y};
+    const Vec2 va = {a.vx - a.angularVelocity * ra.y, a.vy + a.angularVelocity * ra.x};
+    const Vec2 vb = {b.vx - b.angularVelocity * rb.y, b.vy + b.angularVelocity * rb.x};
+    const float approachSpeed = std::max(0.0f, -(vb - va).dot(m.normal));
+    push_contact_event(table, world, slot, began ? CONTACT_BEGIN : CONTACT_PERSIST, approachSpeed);
+
+    a.collision_count++; b.collision_count++;
+    return true;
+}
+
+// A chain against the body on the other side of the pair: a contact per
+// segment the body touches, found through the chain's own segment tree.
+static bool collide_chain(PhysicsWorld* world, int i, int j, const Softness& contactSoftness) {
+    const bool chainIsA = world->bodies[i].shapeType == SHAPE_CHAIN;
+    const int chainId = chainIsA ? i : j, otherId = chainIsA ? j : i;
+    const ChainShape* chain = body_chain(world, chainId);
+    const NativeBody& other = world->bodies[otherId];
+    if (!chain || other.shapeType == SHAPE_CHAIN) return false;
+
+    const PolygonShape* polygon = body_polygon(world, otherId);
+    PolygonFrame frame;
+    if (other.shapeType != SHAPE_CIRCLE) frame = make_polygon_frame(other, polygon);
+
+    bool touching = false;
+    tree_query(chain->segments, calculate_body_aabb(other, polygon), [&](uint32_t segment) {
+        const ChainSegment seg = chain_segment(*chain, (int)segment);
+        CollisionManifold m = other.shapeType == SHAPE_CIRCLE ? detectSegmentCircle(seg, other) : detectSegmentPolygon(seg, frame);
+        if (!m.collided) return true;
+        if (!chainIsA) m.normal = m.normal * -1.0f;
+        touching |= update_contact(world, i, j, (int32_t)segment, m, contactSoftness);
+        return true;
+    });
+    return touching;
+}
+
+// Narrow phase for one broadphase pair: refreshes the pair's contact if the
+// shapes touch, creating it if they did not last step, and reports whether
+// they do.
+static bool collide_pair(PhysicsWorld* world, int i, int j, const Softness& contactSoftness) {
+    // Contacts are stored lower id first, so that a pair the tree reports the
+    // other way round next step still lines up with its manifold.
+    if (i > j) std::swap(i, j);
+
+    NativeBody& a = world->bodies[i];
+    NativeBody& b = world->bodies[j];
+    if (a.type == STATIC && b.type == STATIC) return false;
+    if (!((a.maskBits & b.categoryBits) != 0 && (b.maskBits & a.categoryBits) != 0)) return false;
+    if (a.shapeType == SHAPE_CHAIN || b.shapeType == SHAPE_CHAIN) return collide_chain(world, i, j, contactSoftness);
+
+    CollisionManifold m = {{0,0}, 0, {{0,0}}, 0, false, {0,0}, {0,0}};
+    const PolygonShape* polygonA = body_polygon(world, i);
+    const PolygonShape* polygonB = body_polygon(world, j);
+    if (a.shapeType == SHAPE_CIRCLE && b.shapeType == SHAPE_CIRCLE) m = detectCircleCircle(a, b);
+    else if (a.shapeType == SHAPE_CIRCLE) {
+        m = polygonB ? detectCirclePolygon(a, make_polygon_frame(b, polygonB)) : detectCircleBox(a, b);
+    } else if (b.shapeType == SHAPE_CIRCLE) {
+        m = polygonA ? detectCirclePolygon(b, make_polygon_frame(a, polygonA)) : detectCircleBox(b, a);
+    } else {
+        m = detectPolygons(make_polygon_frame(a, polygonA), make_polygon_frame(b, polygonB));
+    }
+
+    if (!m.collided) return false;
+    // The circle detectors' normal points at the circle.
+    if (a.shapeType == SHAPE_CIRCLE && b.shapeType != SHAPE_CIRCLE) m.normal = m.normal * -1.0f;
+    return update_contact(world, i, j, 0, m, contactSoftness);
+}
+
+// A body the solver moves this step. Static bodies are never awake in this
+// sense, whatever their isAwake flag says.
+static inline bool is_awake_body(const NativeBody& b) {
+    return b.type != STATIC && b.isAwake;
+}
+
+// Collides a pair one of whose bodies is awake. A contact with a sleeping body
+// wakes its whole island; returns whether that happened.
+static bool collide_awake_pair(PhysicsWorld* world, int i, int j, const Softness& softness) {
+    if (!collide_pair(world, i, j, softness)) return false;
+    bool woke = false;
+    if (!world->bodies[i].isAwake) woke |= wake_island(world, i);
+    if (!world->bodies[j].isAwake) woke |= wake_island(world, j);
+    return woke;
+}
 
-    // Phase 2: Integrate Velocities & Apply Sleep
+// Copies each body the step moves into its SolverBody, and lists it with
+// its acceleration. Forces and torques last one step_physics call, however
+// many substeps it takes, so they are used up here.
+static void load_body_states(PhysicsWorld* world) {
+    int count = 0;
     for (int i = 0; i < world->activeCount; ++i) {
         NativeBody& b = world->bodies[i];
-        if (!b.alive || b.type == STATIC) continue;
-        
-        // Sleep check
-        if (b.vx * b.vx + b.vy * b.vy < 0.2f && std::abs(b.angularVelocity) < 0.2f && 
-            b.forceX == 0 && b.forceY == 0 && b.torque == 0) {
-            b.sleepTime += dt;
-        } else {
-            b.sleepTime = 0.0f;
-            b.isAwake = 1;
-        }
+        SolverBody& s = world->solverBodies[i];
+        s.isAwake = b.alive && is_awake_body(b);
+        if (!s.isAwake) continue;
+
+        s.x = b.x; s.y = b.y; s.rotation = b.rotation;
+        s.vx = b.vx; s.vy = b.vy; s.angularVelocity = b.angularVelocity;
+        s.inverseMass = b.inverseMass;
+        s.inverseInertia = b.inverseInertia;
+        s.type = b.type;
+
+        world->awakeBodies[count] = i;
+        world->awakeAccelerations[count] = {world->gravityX + b.forceX * b.inverseMass,
+                                            world->gravityY + b.forceY * b.inverseMass,
+                                            b.torque * b.inverseInertia};
+        b.forceX = b.forceY = b.torque = 0;
+        count++;
+    }
+    world->awakeBodyCount = count;
+}
 
-        if (b.sleepTime > 1.0f) {
-            b.isAwake = 0;
-            b.vx = b.vy = b.angularVelocity = 0;
-            continue;
-        }
+// Copies the solved poses and velocities back to the bodies. The one cos and
+// sin an awake body costs a step are taken here, for the bodies that turned.
+static void store_body_states(PhysicsWorld* world) {
+    for (int k = 0; k < world->awakeBodyCount; ++k) {
+        const int32_t i = world->awakeBodies[k];
+        const SolverBody& s = world->solverBodies[i];
+        NativeBody& b = world->bodies[i];
+        if (s.rotation != b.rotation) b.q = make_rot(s.rotation);
+        b.x = s.x; b.y = s.y; b.rotation = s.rotation;
+        b.vx = s.vx; b.vy = s.vy; b.angularVelocity = s.angularVelocity;
+    }
+}
+
+// Phase 2: gravity and forces into velocity, for every awake body.
+static void integrate_velocities(PhysicsWorld* world, float h, float damping) {
+    const float maxV = world->maxLinearVelocity;
+    for (int k = 0; k < world->awakeBodyCount; ++k) {
+        SolverBody& b = world->solverBodies[world->awakeBodies[k]];
+        const BodyAcceleration& a = world->awakeAccelerations[k];
+
+        b.vx += a.x * h;
+        b.vy += a.y * h;
+        b.angularVelocity += a.angular * h;
 
-        b.vx += (world->gravityX + b.forceX * b.inverseMass) * dt;
-        b.vy += (world->gravityY + b.forceY * b.inverseMass) * dt;
-        b.angularVelocity += (b.torque * b.inverseInertia) * dt;
-        
         // Speed clamp. maxLinearVelocity was configured and never enforced;
         // without it a body caught in a bad contact can accelerate without
         // bound and tunnel through everything.
-        const float maxV = world->maxLinearVelocity;
         if (maxV > 0.0f) {
             const float speedSq = b.vx * b.vx + b.vy * b.vy;
             if (speedSq > maxV * maxV) {
@@ -444,188 +1161,332 @@ FLASH_API void step_physics(PhysicsWorld* world, float dt) {
             }
         }
 
-        // Damping for stability (Reduced from 0.99 to 0.999 to allow gravity to be snappy)
-        b.vx *= 0.999f;
-        b.vy *= 0.999f;
-        b.angularVelocity *= 0.999f;
+        b.vx *= damping;
+        b.vy *= damping;
+        b.angularVelocity *= damping;
+    }
+}
 
-        b.forceX = b.forceY = b.torque = 0;
+// Phase 4: velocity into position, for every awake body.
+static void integrate_positions(PhysicsWorld* world, float h) {
+    for (int k = 0; k < world->awakeBodyCount; ++k) {
+        SolverBody& b = world->solverBodies[world->awakeBodies[k]];
+        b.x += b.vx * h; b.y += b.vy * h; b.rotation += b.angularVelocity * h;
     }
+}
+
+// Damping for stability (reduced from 0.99 to 0.999 to allow gravity to be
+// snappy). Applied once per step whichever solver runs.
+constexpr float kVelocityDamping = 0.999f;
+
+static void solve_ngs(PhysicsWorld* world, float dt) {
+    integrate_velocities(world, dt, kVelocityDamping);
 
     // Phase 3: Solve Velocity Constraints
     init_joint_velocity_constraints(world, dt);
 
-    ImpulseCache* cache = (ImpulseCache*)world->warmStartCache;
-    if (!cache) {
-        cache = new ImpulseCache();
-        world->warmStartCache = cache;
+    // Colored, the velocity passes take contacts four at a time. See
+    // contact_solver.h.
+    const bool wide = world->solverThreading == SOLVER_THREADING_GRAPH_COLORED && world->wideContactSolver;
+    SolverBody* bodies = world->solverBodies;
+    if (wide) {
+        if (!world->wideContacts) world->wideContacts = create_wide_contact_set();
+        prepare_wide_contacts(world->wideContacts, world, world->constraintGraph);
     }
-    
-    // warm start
+
+    // Warm start. The impulses are last step's, left in place on the contact.
     if (world->enableWarmStarting) {
-        for (int i = 0; i < world->activeConstraints; i++) {
-             ContactConstraint& c = world->constraints[i];
-             NativeBody& a = world->bodies[c.bodyA];
-             NativeBody& b = world->bodies[c.bodyB];
-             
-             for (int j = 0; j < c.pointCount; j++) {
-                 ContactConstraintPoint& cp = c.points[j];
-                 // Typically manifolds persist but points might shift.
-                 // For now, assume point index stability (Box2D style requires feature IDs, we use simple index)
-                 uint64_t key = contact_cache_key(c.bodyA, c.bodyB, j);
-
-                 auto it = cache->find(key);
-                 if (it != cache->end()) {
-                     CachedImpulse& imp = it->second;
-                     cp.normalImpulse = imp.normalImpulse;
-                     cp.tangentImpulse = imp.tangentImpulse;
-                     
-                     // Apply cached impulses for warm start
-                     Vec2 normal = {c.normalX, c.normalY}, tangent = {-c.normalY, c.normalX};
-                     Vec2 ra = {cp.anchorAx, cp.anchorAy}, rb = {cp.anchorBx, cp.anchorBy};
-                     
-                     Vec2 P = normal * cp.normalImpulse + tangent * cp.tangentImpulse;
-                     
-                     if (a.type != STATIC) { 
-                         a.vx -= P.x * a.inverseMass; 
-                         a.vy -= P.y * a.inverseMass; 
-                         a.angularVelocity -= ra.cross(P) * a.inverseInertia; 
-                     }
-                     if (b.type != STATIC) { 
-                         b.vx += P.x * b.inverseMass; 
-                         b.vy += P.y * b.inverseMass; 
-                         b.angularVelocity += rb.cross(P) * b.inverseInertia; 
-                     }
-                 } else {
-                     cp.normalImpulse = 0.0f;
-                     cp.tangentImpulse = 0.0f;
-                 }
-             }
-        }
+        solve_pass(world, 1,
+                   [world](ContactConstraint& c) { warm_start_contact(world, c); },
+                   [](Joint&) {},
+                   wide ? [bodies](WideContact& c) { warm_start_wide_contact(bodies, c); }
+                        : std::function<void(WideContact&)>());
     }
-    
-    for (int iter = 0; iter < world->velocityIterations; ++iter) {
-        for (int i = 0; i < world->activeConstraints; ++i) {
-            ContactConstraint& c = world->constraints[i];
-            NativeBody& a = world->bodies[c.bodyA], &b = world->bodies[c.bodyB];
-            if (!a.isAwake && !b.isAwake) continue;
-
-            // Simple Wake-up
-            a.isAwake = b.isAwake = 1;
-            a.sleepTime = b.sleepTime = 0;
-
-            Vec2 normal = {c.normalX, c.normalY}, tangent = {-c.normalY, c.normalX};
-            for (int j = 0; j < c.pointCount; ++j) {
-                ContactConstraintPoint& cp = c.points[j];
-                Vec2 ra = {cp.anchorAx, cp.anchorAy}, rb = {cp.anchorBx, cp.anchorBy};
-                Vec2 dv = (Vec2{b.vx, b.vy} + cross(b.angularVelocity, rb)) - (Vec2{a.vx, a.vy} + cross(a.angularVelocity, ra));
-                
-                // Normal Impulse with Restitution Bias
-                float vn = dv.dot(normal);
-                float bias = c.softness.massScale * c.softness.biasRate * cp.baseSeparation;
-                if (c.restitution > 0) bias -= c.restitution * vn; // Add bounce
-
-                float lambda = -cp.normalMass * (c.softness.massScale * vn + bias) - c.softness.impulseScale * cp.normalImpulse;
-                float oldImpulse = cp.normalImpulse;
-                cp.normalImpulse = std::max(oldImpulse + lambda, 0.0f);
-                lambda = cp.normalImpulse - oldImpulse;
-
-                Vec2 P = normal * lambda;
-                if (a.type != STATIC) { a.vx -= P.x * a.inverseMass; a.vy -= P.y * a.inverseMass; a.angularVelocity -= ra.cross(P) * a.inverseInertia; }
-                if (b.type != STATIC) { b.vx += P.x * b.inverseMass; b.vy += P.y * b.inverseMass; b.angularVelocity += rb.cross(P) * b.inverseInertia; }
-
-                // Friction Impulse
-                dv = (Vec2{b.vx, b.vy} + cross(b.angularVelocity, rb)) - (Vec2{a.vx, a.vy} + cross(a.angularVelocity, ra));
-                float lambdaT = -cp.tangentMass * dv.dot(tangent);
-                float maxF = c.friction * cp.normalImpulse;
-                oldImpulse = cp.tangentImpulse;
-                cp.tangentImpulse = std::max(-maxF, std::min(oldImpulse + lambdaT, maxF));
-                lambdaT = cp.tangentImpulse - oldImpulse;
-
-                Vec2 Pt = tangent * lambdaT;
-                if (a.type != STATIC) { a.vx -= Pt.x * a.inverseMass; a.vy -= Pt.y * a.inverseMass; a.angularVelocity -= ra.cross(Pt) * a.inverseInertia; }
-                if (b.type != STATIC) { b.vx += Pt.x * b.inverseMass; b.vy += Pt.y * b.inverseMass; b.angularVelocity += rb.cross(Pt) * b.inverseInertia; }
-            }
+
+    solve_pass(world, world->velocityIterations,
+               [world](ContactConstraint& c) { solve_contact_velocity(world, c); },
+               [world](Joint& j) { solve_joint_velocity(&j, world); },
+               wide ? [bodies](WideContact& c) { solve_wide_contact_velocity(bodies, c); }
+                    : std::function<void(WideContact&)>());
+    if (wide) store_wide_impulses(world->wideContacts, world);
+
+    // Phase 4: Integrate Positions
+    integrate_positions(world, dt);
+
+    // Phase 5: Position Correction (pseudo-impulse for rotation stability)
+    solve_pass(world, world->positionIterations,
+               [world](ContactConstraint& c) { solve_contact_position(world, c); },
+               [world](Joint& j) { solve_joint_position(&j, world); });
+}
+
+// See "Soft step" above. Joints have no soft formulation yet: they are solved
+// once per substep alongside the biased contact pass, with their softness
+// built for the substep, and get one position pass per substep in place of
+// positionIterations.
+static void solve_soft_step(PhysicsWorld* world, float dt) {
+    const int subSteps = world->subStepCount;
+    const float h = dt / subSteps, inv_h = 1.0f / h;
+
+    // Box2D caps contact stiffness at a quarter of the substep rate; stiffer
+    // than that and the spring is not resolved by the substep.
+    const float contactHertz = std::min(world->contactHertz, 0.25f * inv_h);
+    const Softness contactSoftness = makeSoftness(contactHertz, world->contactDampingRatio, h);
+    const Softness staticSoftness = makeSoftness(2.0f * contactHertz, world->contactDampingRatio, h);
+    solve_pass(world, 1,
+               [&](ContactConstraint& c) { prepare_contact_soft(world, c, contactSoftness, staticSoftness); },
+               [](Joint&) {});
+    init_joint_velocity_constraints(world, h);
+
+    // The per-step damping, spread evenly over the substeps.
+    const float damping = std::pow(kVelocityDamping, 1.0f / subSteps);
+    const bool hasJoints = world->activeBoxJoints > 0;
+    for (int step = 0; step < subSteps; ++step) {
+        integrate_velocities(world, h, damping);
+        if (world->enableWarmStarting) {
+            solve_pass(world, 1,
+                       [world](ContactConstraint& c) { warm_start_contact(world, c); },
+                       [](Joint&) {});
         }
-        solve_joint_velocity_constraints(world);
+        solve_pass(world, 1,
+                   [world, inv_h](ContactConstraint& c) { solve_contact_soft(world, c, inv_h, true); },
+                   [world](Joint& j) { solve_joint_velocity(&j, world); });
+        integrate_positions(world, h);
+        if (hasJoints) {
+            solve_pass(world, 1,
+                       [](ContactConstraint&) {},
+                       [world](Joint& j) { solve_joint_position(&j, world); });
+        }
+        solve_pass(world, 1,
+                   [world, inv_h](ContactConstraint& c) { solve_contact_soft(world, c, inv_h, false); },
+                   [](Joint&) {});
     }
-    
-    // Store impulses for next frame.
-    // Rebuild from scratch: the cache must hold only pairs that are actually
-    // touching this step. Without the clear it grows without bound, keeping an
-    // entry for every pair that has ever collided during the session.
-    cache->clear();
-    if (world->enableWarmStarting) {
-         for (int i = 0; i < world->activeConstraints; ++i) {
-            ContactConstraint& c = world->constraints[i];
-            for (int j = 0; j < c.pointCount; ++j) {
-                 ContactConstraintPoint& cp = c.points[j];
-                 (*cache)[contact_cache_key(c.bodyA, c.bodyB, j)] = {cp.normalImpulse, cp.tangentImpulse};
-            }
-         }
+
+    solve_pass(world, 1,
+               [world](ContactConstraint& c) { apply_contact_restitution(world, c); },
+               [](Joint&) {});
+}
+
+FLASH_API void step_physics(PhysicsWorld* world, float dt) {
+    if (!world || dt <= 0) return;
+
+    // Step Soft Bodies
+    step_soft_body(world, dt);
+
+    if (world->activeCount == 0) return;
+
+    // A joint from an awake body to a sleeping one wakes the sleeper's island
+    // before anything else runs. create_joint already does this; the check
+    // here covers a body that was woken directly through the API.
+    for (int i = 0; i < world->activeBoxJoints; ++i) {
+        const Joint& j = world->boxJoints[i];
+        if (j.bodyA >= (uint32_t)world->activeCount || j.bodyB >= (uint32_t)world->activeCount) continue;
+        const NativeBody& a = world->bodies[j.bodyA];
+        const NativeBody& b = world->bodies[j.bodyB];
+        if (is_awake_body(a) && b.alive) wake_island(world, j.bodyB);
+        if (is_awake_body(b) && a.alive) wake_island(world, j.bodyA);
     }
 
-    // Phase 4: Integrate Positions
+    // Phase 1: Update Broadphase Tree
+    //
+    // Sleeping bodies do not move, so their proxies are left alone. Their
+    // collision counts are left alone too: a body at rest on the ground is
+    // still touching it. Every other body, statics included, is counted
+    // afresh by this step's contacts. An awake body only touches the tree
+    // once it leaves its fat AABB, which is stretched along the distance it
+    // will cover this step.
+    BroadphaseStats& stats = world->broadphaseStats;
+    stats.checkedProxies = 0;
+    stats.reinsertions = 0;
     for (int i = 0; i < world->activeCount; ++i) {
         NativeBody& b = world->bodies[i];
-        if (!b.alive || b.type == STATIC || !b.isAwake) continue;
-        b.x += b.vx * dt; b.y += b.vy * dt; b.rotation += b.angularVelocity * dt;
+        if (!b.alive) continue;
+        if (b.type == STATIC || b.isAwake) b.collision_count = 0;
+        if (!is_awake_body(b)) continue;
+
+        AABB aabb = calculate_body_aabb(b, body_polygon(world, i));
+        stats.checkedProxies++;
+        if (tree_update_leaf(world->tree, b.proxyId, aabb, b.vx * dt, b.vy * dt)) {
+            tree_buffer_move(world->tree, b.proxyId);
+            stats.reinsertions++;
+        }
     }
+    // Only does anything under BROADPHASE_REBUILD_INCREMENTAL.
+    tree_rebuild(world->tree, false);
 
-    // Phase 5: Position Correction (pseudo-impulse for rotation stability)
-    //
-    // This used to re-run the entire narrow phase — SAT and all — inside every
-    // position iteration. With 4 iterations and 2 sub-steps that meant the same
-    // box pair went through detectBoxBox eight times per frame, purely to
-    // re-derive a penetration depth.
-    //
-    // The constraint already carries what is needed: the contact anchors
-    // relative to each body centre, and baseSeparation from manifold time. At
-    // that moment the two anchor points coincide in world space, so the current
-    // separation is baseSeparation plus however far the anchors have drifted
-    // apart along the normal. That is a dot product, and it shrinks as the
-    // solver pushes the bodies apart — which is exactly the feedback the
-    // re-detection was providing.
-    //
-    // This is how Box2D's position solver works, and it is why those fields
-    // exist on ContactConstraintPoint.
-    const float slop = 0.01f, baumgarte = 0.2f;
-    for (int iter = 0; iter < world->positionIterations; ++iter) {
-        for (int i = 0; i < world->activeConstraints; ++i) {
-            ContactConstraint& c = world->constraints[i];
-            NativeBody& a = world->bodies[c.bodyA], &b = world->bodies[c.bodyB];
-            if (!a.isAwake && !b.isAwake) continue;
-            if (c.pointCount == 0) continue;
-
-            const Vec2 normal = { c.normalX, c.normalY };
-            const Vec2 posA = { a.x, a.y };
-            const Vec2 posB = { b.x, b.y };
-
-            for (int j = 0; j < c.pointCount; ++j) {
-                ContactConstraintPoint& cp = c.points[j];
-                const Vec2 ra = { cp.anchorAx, cp.anchorAy };
-                const Vec2 rb = { cp.anchorBx, cp.anchorBy };
-
-                // Anchors coincided when the manifold was built, so the drift
-                // along the normal is the separation gained since then.
-                const float drift = ((posB + rb) - (posA + ra)).dot(normal);
-                const float separation = cp.baseSeparation + drift;
-
-                const float C = std::max(-separation - slop, 0.0f) * baumgarte;
-                if (C <= 0.0f) continue;
-
-                const float raN = ra.cross(normal), rbN = rb.cross(normal);
-                const float k = a.inverseMass + b.inverseMass +
-                                raN * raN * a.inverseInertia + rbN * rbN * b.inverseInertia;
-                if (k <= 1e-6f) continue;
-
-                const Vec2 P = normal * (C / k);
-                if (a.type != STATIC) { a.x -= P.x * a.inverseMass; a.y -= P.y * a.inverseMass; a.rotation -= ra.cross(P) * a.inverseInertia; }
-                if (b.type != STATIC) { b.x += P.x * b.inverseMass; b.y += P.y * b.inverseMass; b.rotation += rb.cross(P) * b.inverseInertia; }
+    world->contactTable->step++;
+    BroadphasePair* pairs = world->pairScratch;
+    int pairCount = query_tree_pairs(world->tree, world->staticTree, pairs, world->maxPairs);
+    stats.pairCount = (int32_t)world->tree->pairs.size();
+
+    Softness contactSoftness = makeSoftness(world->contactHertz, world->contactDampingRatio, dt);
+
+    // Narrow phase, awake pairs only. A pair with neither body awake is
+    // deferred rather than dropped: a contact later in the list may wake one
+    // of them, and its contacts are needed this step or the freshly woken
+    // island would spend a step falling through whatever it rested on.
+    std::vector<int32_t>& deferred = world->islands->deferredPairs;
+    deferred.clear();
+    bool woke = false;
+    for (int p = 0; p < pairCount; ++p) {
+        const int i = pairs[p].bodyA, j = pairs[p].bodyB;
+        if (!is_awake_body(world->bodies[i]) && !is_awake_body(world->bodies[j])) {
+            deferred.push_back(p);
+            continue;
+        }
+        woke |= collide_awake_pair(world, i, j, contactSoftness);
+    }
+    while (woke) {
+        woke = false;
+        size_t remaining = 0;
+        for (int32_t p : deferred) {
+            const int i = pairs[p].bodyA, j = pairs[p].bodyB;
+            if (!is_awake_body(world->bodies[i]) && !is_awake_body(world->bodies[j])) {
+                deferred[remaining++] = p;
+                continue;
             }
+            woke |= collide_awake_pair(world, i, j, contactSoftness);
         }
-        solve_joint_position_constraints(world);
+        deferred.resize(remaining);
     }
+
+    // Contacts that were looked at and no longer touch go. Those of sleeping
+    // islands were not looked at, and stay.
+    sweep_contacts(world->contactTable, world);
+
+    // Islands. Every contact now has an awake body on at least one side —
+    // sleeping pairs were never collided, and a contact with a sleeper woke
+    // it — so the grouping covers every constraint the solver will see.
+    build_islands(world->islands, world);
+
+    if (world->solverThreading == SOLVER_THREADING_GRAPH_COLORED) {
+        if (!world->constraintGraph) world->constraintGraph = create_constraint_graph();
+        color_constraints(world->constraintGraph, world);
+    }
+
+    begin_continuous(world->continuous, world);
+    load_body_states(world);
+    if (world->solverMode == SOLVER_MODE_SOFT_STEP) {
+        solve_soft_step(world, dt);
+    } else {
+        solve_ngs(world, dt);
+    }
+    store_body_states(world);
+
+    // Bullets that moved far enough to have skipped through something are
+    // pulled back to their time of impact. Their proxies catch up at the top
+    // of the next step, like everyone else's.
+    solve_continuous(world->continuous, world);
+
+    // Phase 6: Sleep. Decided per island, on the velocities the step ended
+    // with.
+    sleep_islands(world->islands, world, dt);
+}
+
+FLASH_API int32_t step_physics_fixed(PhysicsWorld* world, float frameDt, float fixedDt, int32_t maxSubsteps) {
+    if (!world || fixedDt <= 0.0f) return 0;
+
+    // Dart used to keep this accumulator and call step_physics once per fixed
+    // step, and bodies were drawn at whatever the last step left: up to a
+    // whole step stale, and visibly stepping whenever the render rate is not
+    // a multiple of the physics rate. Keeping both ends of the last step
+    // here lets the renderer draw in between, so physics can run slower than
+    // the display.
+    world->stepAccumulator += frameDt > 0.0f ? frameDt : 0.0f;
+    int32_t steps = (int32_t)(world->stepAccumulator / fixedDt);
+    if (steps > maxSubsteps) {
+        // Behind by more than the budget: drop whole steps, keep the phase.
+        steps = maxSubsteps > 0 ? maxSubsteps : 0;
+        world->stepAccumulator = std::fmod(world->stepAccumulator, fixedDt) + (float)steps * fixedDt;
+    }
+
+    for (int32_t s = 0; s < steps; ++s) {
+        // Only the last step's start pose is ever blended from.
+        if (s == steps - 1) {
+            for (int i = 0; i < world->activeCount; ++i) {
+                const NativeBody& b = world->bodies[i];
+                world->previousPoses[i] = BodyPose{b.x, b.y, b.rotation};
+            }
+        }
+        step_physics(world, fixedDt);
+        world->stepAccumulator -= fixedDt;
+    }
+    if (world->stepAccumulator < 0.0f) world->stepAccumulator = 0.0f;
+
+    const float alpha = std::min(world->stepAccumulator / fixedDt, 1.0f);
+    world->stepAlpha = alpha;
+    for (int i = 0; i < world->activeCount; ++i) {
+        const NativeBody& b = world->bodies[i];
+        if (!b.alive) continue;
+        const BodyPose& p = world->previousPoses[i];
+        // Rotation is an unwrapped angle, so a straight lerp takes the short
+        // way round.
+        world->renderPoses[i] = BodyPose{
+            p.x + (b.x - p.x) * alpha,
+            p.y + (b.y - p.y) * alpha,
+            p.rotation + (b.rotation - p.rotation) * alpha,
+        };
+    }
+    return steps;
+}
+
+FLASH_API const BodyPose* get_interpolated_poses(PhysicsWorld* world) {
+    return world ? world->renderPoses : nullptr;
+}
+
+FLASH_API int32_t set_solver_threading(PhysicsWorld* world, int32_t mode) {
+    if (!world) return SOLVER_THREADING_SERIAL;
+    const int32_t previous = world->solverThreading;
+    switch (mode) {
+        case SOLVER_THREADING_GRAPH_COLORED:
+        case SOLVER_THREADING_ISLANDS:
+            world->solverThreading = mode;
+            break;
+        default:
+            world->solverThreading = SOLVER_THREADING_SERIAL;
+            break;
+    }
+    return previous;
+}
+
+FLASH_API int32_t set_wide_contact_solver(PhysicsWorld* world, int32_t enabled) {
+    if (!world) return 0;
+    const int32_t previous = world->wideContactSolver;
+    world->wideContactSolver = enabled ? 1 : 0;
+    return previous;
+}
+
+FLASH_API int32_t set_solver_mode(PhysicsWorld* world, int32_t mode, int32_t subStepCount) {
+    if (!world) return SOLVER_MODE_NGS;
+    const int32_t previous = world->solverMode;
+    world->solverMode = mode == SOLVER_MODE_SOFT_STEP ? SOLVER_MODE_SOFT_STEP : SOLVER_MODE_NGS;
+    world->subStepCount = std::max(subStepCount, 1);
+    return previous;
+}
+
+FLASH_API int32_t get_contact_events(PhysicsWorld* world, ContactEvent* buffer, int32_t max) {
+    if (!world) return 0;
+    return drain_contact_events(world->contactTable, buffer, max);
+}
+
+FLASH_API int32_t set_contact_event_mask(PhysicsWorld* world, int32_t mask) {
+    if (!world) return 0;
+    const int32_t previous = (int32_t)world->contactTable->eventMask;
+    world->contactTable->eventMask = (uint32_t)mask & ((1u << CONTACT_BEGIN) | (1u << CONTACT_END) | (1u << CONTACT_PERSIST));
+    return previous;
+}
+
+FLASH_API int32_t get_contact_points(PhysicsWorld* world, int32_t bodyA, int32_t bodyB, ManifoldPoint* out, int32_t max) {
+    if (!world || !out || bodyA < 0 || bodyB < 0) return 0;
+    const int32_t slot = find_contact(world->contactTable, (uint32_t)bodyA, (uint32_t)bodyB);
+    if (slot < 0) return 0;
+
+    const ContactConstraint& c = world->constraints[slot];
+    int32_t count = 0;
+    for (int j = 0; j < c.pointCount && count < max; ++j) {
+        const ContactConstraintPoint& cp = c.points[j];
+        out[count++] = ManifoldPoint{cp.anchorAx, cp.anchorAy, cp.baseSeparation, cp.normalImpulse, cp.tangentImpulse, cp.id};
+    }
+    return count;
 }
 
 // Version handshake. Dart uses this as a cheap, side-effect-free probe to
@@ -635,8 +1496,15 @@ FLASH_API int32_t get_physics_version() {
     return FLASH_ABI_VERSION;
 }
 
-FLASH_API int32_t create_body(PhysicsWorld* world, int type, int shapeType, float x, float y, float w, float h, float rotation, uint32_t categoryBits, uint32_t maskBits) {
-    if (!world) return -1;
+// Claims a slot and fills it from `def`. Everything but the broadphase
+// proxy, which create_body inserts on its own and create_bodies in bulk. A
+// SHAPE_POLYGON def needs its `polygon`, and a SHAPE_CHAIN one is only taken
+// from create_chain_body, which builds the chain next; the BodyDef has no
+// room for either shape.
+static int32_t claim_body(PhysicsWorld* world, const BodyDef& def, const PolygonShape* polygon = nullptr,
+                          bool chain = false) {
+    if (def.shapeType == SHAPE_POLYGON && !polygon) return -1;
+    if (def.shapeType == SHAPE_CHAIN && !chain) return -1;
 
     int32_t id;
     if (world->bodyFreeCount > 0) {
@@ -646,13 +1514,16 @@ FLASH_API int32_t create_body(PhysicsWorld* world, int type, int shapeType, floa
         id = world->activeCount++;
     }
 
+    const int type = def.type, shapeType = def.shapeType;
+    const float w = def.width, h = def.height;
     NativeBody& b = world->bodies[id];
     b.id = id;
     b.type = type;
     b.shapeType = shapeType;
-    b.x = x;
-    b.y = y;
-    b.rotation = rotation;
+    b.x = def.x;
+    b.y = def.y;
+    b.rotation = def.rotation;
+    b.q = make_rot(def.rotation);
     b.vx = b.vy = b.angularVelocity = 0;
     b.forceX = b.forceY = b.torque = 0;
     b.width = w;
@@ -666,36 +1537,230 @@ FLASH_API int32_t create_body(PhysicsWorld* world, int type, int shapeType, floa
         b.inertia = b.inverseInertia = 0;
     } else {
         if (shapeType == SHAPE_BOX) b.inertia = (1.0f / 12.0f) * b.mass * (w * w + h * h);
+        else if (shapeType == SHAPE_POLYGON) b.inertia = polygon_inertia(*polygon, b.mass);
         else b.inertia = 0.5f * b.mass * (b.radius * b.radius);
         b.inverseInertia = 1.0f / b.inertia;
     }
     
-    b.restitution = 0.2f;
-    b.friction = 0.4f;
+    b.restitution = def.restitution;
+    b.friction = def.friction;
     b.sleepTime = 0.0f;  // Initialize sleep timer
     b.collision_count = 0;
-    b.categoryBits = categoryBits;
-    b.maskBits = maskBits;
-    
-    // Broadphase Proxy
-    AABB aabb = calculate_body_aabb(b);
-    b.proxyId = tree_insert_leaf(world->tree, id, aabb);
+    b.categoryBits = def.categoryBits;
+    b.maskBits = def.maskBits;
+    b.proxyId = -1;
     
     b.isAwake = 1;
     b.alive = 1;
+    b.isBullet = def.isBullet ? 1 : 0;
+    if (polygon) world->polygons[id] = *polygon;
+    // A static body's is never loaded again; see load_body_states.
+    world->solverBodies[id] = SolverBody{b.x, b.y, b.rotation, 0, 0, 0, b.inverseMass, b.inverseInertia, type, 0};
+
+    // No motion to interpolate yet: both ends of the blend are where the
+    // body was created.
+    world->previousPoses[id] = world->renderPoses[id] = BodyPose{def.x, def.y, def.rotation};
+
+    return id;
+}
+
+// The broadphase tree a body's proxy lives in. A body's type is fixed at
+// creation, so it stays in the same one.
+static inline DynamicTree* body_tree(PhysicsWorld* world, const NativeBody& b) {
+    return b.type == STATIC ? world->staticTree : world->tree;
+}
+
+// Puts a new body into the broadphase, queued for its first pair query.
+static void create_proxy(PhysicsWorld* world, int32_t id, const AABB& aabb) {
+    NativeBody& b = world->bodies[id];
+    DynamicTree* tree = body_tree(world, b);
+    b.proxyId = tree_insert_leaf(tree, id, aabb, TreeFilter{b.categoryBits, b.maskBits});
+    tree_buffer_move(tree, b.proxyId);
+}
+
+FLASH_API int32_t create_body(PhysicsWorld* world, int type, int shapeType, float x, float y, float w, float h, float rotation, uint32_t categoryBits, uint32_t maskBits) {
+    if (!world) return -1;
+
+    BodyDef def;
+    def.type = type;
+    def.shapeType = shapeType;
+    def.x = x;
+    def.y = y;
+    def.width = w;
+    def.height = h;
+    def.rotation = rotation;
+    def.restitution = 0.2f;
+    def.friction = 0.4f;
+    def.categoryBits = categoryBits;
+    def.maskBits = maskBits;
+    def.isBullet = 0;
+
+    const int32_t id = claim_body(world, def);
+    if (id < 0) return -1;
+
+    // Broadphase Proxy
+    create_proxy(world, id, calculate_body_aabb(world->bodies[id]));
+    return id;
+}
+
+FLASH_API int32_t create_bodies(PhysicsWorld* world, const BodyDef* defs, int32_t count, int32_t* outIds) {
+    if (!world || !defs || !outIds || count <= 0) return 0;
+
+    // One batch per tree; [1] is the static one.
+    std::vector<uint32_t> ids[2];
+    std::vector<AABB> aabbs[2];
+    std::vector<TreeFilter> filters[2];
+    int32_t created = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        const int32_t id = claim_body(world, defs[i]);
+        outIds[i] = id;
+        if (id < 0) continue;
+        const int batch = world->bodies[id].type == STATIC ? 1 : 0;
+        ids[batch].push_back((uint32_t)id);
+        aabbs[batch].push_back(calculate_body_aabb(world->bodies[id]));
+        filters[batch].push_back(TreeFilter{world->bodies[id].categoryBits, world->bodies[id].maskBits});
+        ++created;
+    }
+
+    for (int batch = 0; batch < 2; ++batch) {
+        std::vector<int32_t> proxies(ids[batch].size());
+        tree_insert_leaves(batch ? world->staticTree : world->tree, ids[batch].data(), aabbs[batch].data(),
+                           filters[batch].data(), (int)ids[batch].size(), proxies.data());
+        for (size_t k = 0; k < ids[batch].size(); ++k) {
+            world->bodies[ids[batch][k]].proxyId = proxies[k];
+            tree_buffer_move(batch ? world->staticTree : world->tree, proxies[k]);
+        }
+    }
+    return created;
+}
+
+FLASH_API int32_t create_polygon_body(PhysicsWorld* world, int type, float x, float y, float rotation,
+                                      const float* vertices, int32_t count, uint32_t categoryBits, uint32_t maskBits) {
+    if (!world) return -1;
+
+    PolygonShape polygon;
+    float cx, cy;
+    if (!make_polygon(vertices, count, polygon, cx, cy)) return -1;
+
+    // width/height enclose the hull about its centroid, so the code that only
+    // knows boxes — the bullet extent, the soft body bounds — stays
+    // conservative for polygons.
+    float hw = 0.0f, hh = 0.0f;
+    for (int i = 0; i < polygon.count; ++i) {
+        hw = std::max(hw, std::abs(polygon.x[i]));
+        hh = std::max(hh, std::abs(polygon.y[i]));
+    }
 
+    const float c = std::cos(rotation), s = std::sin(rotation);
+    BodyDef def;
+    def.type = type;
+    def.shapeType = SHAPE_POLYGON;
+    def.x = x + c * cx - s * cy;
+    def.y = y + s * cx + c * cy;
+    def.width = 2.0f * hw;
+    def.height = 2.0f * hh;
+    def.rotation = rotation;
+    def.restitution = 0.2f;
+    def.friction = 0.4f;
+    def.categoryBits = categoryBits;
+    def.maskBits = maskBits;
+    def.isBullet = 0;
+
+    const int32_t id = claim_body(world, def, &polygon);
+    if (id < 0) return -1;
+
+    create_proxy(world, id, calculate_body_aabb(world->bodies[id], &world->polygons[id]));
     return id;
 }
 
+static void release_body(PhysicsWorld* world, int32_t bodyId);
+
+FLASH_API int32_t create_chain_body(PhysicsWorld* world, const float* vertices, int32_t count, int32_t loop,
+                                    uint32_t categoryBits, uint32_t maskBits) {
+    if (!world || !vertices || count < 2) return -1;
+
+    // The body is the chain's bounding box, centred, so anything that only
+    // knows boxes — calculate_body_aabb, the world tree — sees its extent.
+    float minX = vertices[0], minY = vertices[1], maxX = minX, maxY = minY;
+    for (int32_t i = 1; i < count; ++i) {
+        minX = std::min(minX, vertices[2 * i]);
+        minY = std::min(minY, vertices[2 * i + 1]);
+        maxX = std::max(maxX, vertices[2 * i]);
+        maxY = std::max(maxY, vertices[2 * i + 1]);
+    }
+
+    BodyDef def;
+    def.type = STATIC;
+    def.shapeType = SHAPE_CHAIN;
+    def.x = 0.5f * (minX + maxX);
+    def.y = 0.5f * (minY + maxY);
+    def.width = maxX - minX;
+    def.height = maxY - minY;
+    def.rotation = 0.0f;
+    def.restitution = 0.2f;
+    def.friction = 0.4f;
+    def.categoryBits = categoryBits;
+    def.maskBits = maskBits;
+    def.isBullet = 0;
+
+    const int32_t id = claim_body(world, def, nullptr, true);
+    if (id < 0) return -1;
+    if (!make_chain(world->chains, id, vertices, count, loop != 0)) {
+        release_body(world, id);
+        return -1;
+    }
+
+    create_proxy(world, id, calculate_body_aabb(world->bodies[id]));
+    return id;
+}
+
+FLASH_API int32_t get_polygon_vertices(PhysicsWorld* world, int32_t bodyId, float* outXY, int32_t max) {
+    if (!world || !outXY || bodyId < 0 || bodyId >= world->activeCount) return 0;
+    const PolygonShape* polygon = body_polygon(world, bodyId);
+    if (!polygon) return 0;
+
+    const int32_t count = std::min(polygon->count, max);
+    for (int32_t i = 0; i < count; ++i) {
+        outXY[2 * i] = polygon->x[i];
+        outXY[2 * i + 1] = polygon->y[i];
+    }
+    return count;
+}
+
+// The part of destroy_body that is the same one body at a time or in bulk:
+// waking what rested on it, dropping its contacts, and releasing the slot.
+// The caller has already taken it out of the tree and dropped its joints.
+static void release_body(PhysicsWorld* world, int32_t bodyId) {
+    NativeBody& b = world->bodies[bodyId];
+
+    // Contacts are keyed by body pair. A recycled slot inheriting one would be
+    // shoved apart on its first frame by a contact — and its impulses — that
+    // belonged to a body that no longer exists. The body's own contact list
+    // names exactly the ones to drop.
+    destroy_body_contacts(world->contactTable, world, bodyId);
+    release_chain(world->chains, bodyId);
+
+    b.alive = 0;
+    b.type = STATIC;      // belt and braces: nothing integrates a dead slot
+    b.isAwake = 0;
+    b.collision_count = 0;
+    b.proxyId = -1;
+    world->bodyFreeList[world->bodyFreeCount++] = bodyId;
+}
+
 FLASH_API void destroy_body(PhysicsWorld* world, int32_t bodyId) {
     if (!world || bodyId < 0 || bodyId >= world->activeCount) return;
     NativeBody& b = world->bodies[bodyId];
     if (!b.alive) return; // guard against double release
 
+    // Whatever was resting on this body is in its island. Left asleep, it
+    // would hang in the air where the body used to be.
+    wake_island(world, bodyId);
+
     // Out of the broadphase first: a leaf left behind would keep generating
     // pairs, and a later body reusing the slot would insert a second one.
     if (b.proxyId >= 0) {
-        tree_remove_leaf(world->tree, b.proxyId);
+        tree_remove_leaf(body_tree(world, b), b.proxyId);
         b.proxyId = -1;
     }
 
@@ -708,23 +1773,37 @@ FLASH_API void destroy_body(PhysicsWorld* world, int32_t bodyId) {
         }
     }
 
-    // Warm-start impulses are keyed by body pair. A recycled slot inheriting
-    // them would be shoved apart on its first frame by a contact that belonged
-    // to a body that no longer exists.
-    if (world->warmStartCache) {
-        ImpulseCache& cache = *static_cast<ImpulseCache*>(world->warmStartCache);
-        for (auto it = cache.begin(); it != cache.end();) {
-            const uint32_t lo = (uint32_t)(it->first >> 40);
-            const uint32_t hi = (uint32_t)((it->first >> 8) & 0xFFFFFF);
-            it = (lo == (uint32_t)bodyId || hi == (uint32_t)bodyId) ? cache.erase(it) : ++it;
-        }
+    release_body(world, bodyId);
+}
+
+FLASH_API void destroy_bodies(PhysicsWorld* world, const int32_t* ids, int32_t count) {
+    if (!world || !ids || count <= 0) return;
+
+    // Which slots are going, so the joint list is walked once rather than
+    // once per body. Invalid, dead and repeated ids drop out here.
+    std::vector<uint8_t> dying(world->activeCount, 0);
+    std::vector<int32_t> bodies, proxies, staticProxies;
+    bodies.reserve(count);
+    for (int32_t i = 0; i < count; ++i) {
+        const int32_t id = ids[i];
+        if (id < 0 || id >= world->activeCount || dying[id] || !world->bodies[id].alive) continue;
+        dying[id] = 1;
+        bodies.push_back(id);
+        wake_island(world, id);
+        const NativeBody& b = world->bodies[id];
+        if (b.proxyId >= 0) (b.type == STATIC ? staticProxies : proxies).push_back(b.proxyId);
     }
+    if (bodies.empty()) return;
 
-    b.alive = 0;
-    b.type = STATIC;      // belt and braces: nothing integrates a dead slot
-    b.isAwake = 0;
-    b.collision_count = 0;
-    world->bodyFreeList[world->bodyFreeCount++] = bodyId;
+    tree_remove_leaves(world->tree, proxies.data(), (int)proxies.size());
+    tree_remove_leaves(world->staticTree, staticProxies.data(), (int)staticProxies.size());
+
+    for (int i = world->activeBoxJoints - 1; i >= 0; --i) {
+        const Joint& j = world->boxJoints[i];
+        if (dying[j.bodyA] || dying[j.bodyB]) destroy_joint(world, i);
+    }
+
+    for (int32_t id : bodies) release_body(world, id);
 }
 
 FLASH_API int32_t create_soft_body(PhysicsWorld* world, int pointCount, float* initialX, float* initialY, float pressure, float stiffness) {
@@ -846,6 +1925,9 @@ FLASH_API void set_soft_body_params(PhysicsWorld* world, int32_t sbId, float pre
 // --- Soft Body Simulation ---
 
 void step_soft_body(PhysicsWorld* world, float dt) {
+    // The chain segments near a soft body, one buffer for every candidate
+    // chain rather than one each.
+    std::vector<uint32_t> segments;
     for (int i = 0; i < world->activeSoftBodies; i++) {
         NativeSoftBody& sb = world->softBodies[i];
         
@@ -936,25 +2018,32 @@ void step_soft_body(PhysicsWorld* world, float dt) {
         // touch is not excluded by the broad phase.
         sbBounds.fatten(2.0f);
 
-        const int kMaxSoftBodyCandidates = 128;
-        uint32_t candidates[kMaxSoftBodyCandidates];
-        const int candidateCount =
-            tree_query_aabb(world->tree, sbBounds, candidates, kMaxSoftBodyCandidates);
-
-        for (int cIdx = 0; cIdx < candidateCount; cIdx++) {
-            const uint32_t bodyId = candidates[cIdx];
-            if ((int)bodyId >= world->activeCount) continue;
+        //
+        // Each candidate is handled as the tree finds it. They were copied
+        // into a 128-entry buffer first, and a soft body resting on a pile
+        // larger than that fell through whatever did not fit.
+        auto collide = [&](uint32_t bodyId) {
+            if ((int)bodyId >= world->activeCount) return true;
             NativeBody& b = world->bodies[bodyId];
-            if (!b.alive) continue;
-
-            // Constant for the whole point loop. This used to be two trig calls
-            // per point per body.
-            const float c = std::cos(-b.rotation);
-            const float s = std::sin(-b.rotation);
-            const float c_rot = c;   // cos(-r) == cos(r)
-            const float s_rot = -s;  // sin(-r) == -sin(r)
+            if (!b.alive) return true;
+
+            // The inverse rotation, for taking points into the body's
+            // frame, and the rotation, for taking normals back out.
+            const float c = b.q.c;
+            const float s = -b.q.s;
+            const float c_rot = b.q.c;
+            const float s_rot = b.q.s;
             const float hw = b.width * 0.5f;
             const float hh = b.height * 0.5f;
+            const PolygonShape* polygon = body_polygon(world, bodyId);
+            const ChainShape* chain = body_chain(world, bodyId);
+            segments.clear();
+            if (chain) {
+                tree_query(chain->segments, sbBounds, [&](uint32_t segment) {
+                    segments.push_back(segment);
+                    return true;
+                });
+            }
 
             for (int pIdx = 0; pIdx < sb.pointCount; pIdx++) {
                 SoftBodyPoint& p = sb.points[pIdx];
@@ -1027,9 +2116,58 @@ void step_soft_body(PhysicsWorld* world, float dt) {
                         p.oldX = p.x - (p.x - p.oldX) * 0.5f; 
                         p.oldY = p.y - (p.y - p.oldY) * 0.5f;
                     }
+                } else if (polygon) {
+                    // The box test generalised: the point is inside the hull
+                    // grown by the point radius when it is behind every edge,
+                    // and the edge it is least far behind is the way out.
+                    const float pointRadius = 2.0f;
+                    const float dx = p.x - b.x;
+                    const float dy = p.y - b.y;
+                    const float localX = dx * c - dy * s;
+                    const float localY = dx * s + dy * c;
+
+                    float separation = -INFINITY;
+                    int edge = 0;
+                    for (int e = 0; e < polygon->count; ++e) {
+                        const float d = polygon->nx[e] * (localX - polygon->x[e]) + polygon->ny[e] * (localY - polygon->y[e]) - pointRadius;
+                        if (d > separation) { separation = d; edge = e; }
+                    }
+                    if (separation < 0.0f) {
+                        const float worldNx = polygon->nx[edge] * c_rot - polygon->ny[edge] * s_rot;
+                        const float worldNy = polygon->nx[edge] * s_rot + polygon->ny[edge] * c_rot;
+                        p.x -= worldNx * separation;
+                        p.y -= worldNy * separation;
+                        p.oldX = p.x - (p.x - p.oldX) * 0.5f;
+                        p.oldY = p.y - (p.y - p.oldY) * 0.5f;
+                    }
+                } else if (chain) {
+                    // A segment has no inside to be pushed out of. A point
+                    // within the point radius of its front, that was in front
+                    // of it last step, is moved back out along the normal.
+                    const float pointRadius = 2.0f;
+                    for (const uint32_t segment : segments) {
+                        const int e = (int)segment;
+                        const float ax = chain->x[e], ay = chain->y[e];
+                        const float ex = chain->x[e + 1] - ax, ey = chain->y[e + 1] - ay;
+                        const float t = ((p.x - ax) * ex + (p.y - ay) * ey) / (ex * ex + ey * ey);
+                        if (t < 0.0f || t > 1.0f) continue;
+
+                        const float nx = chain->nx[e], ny = chain->ny[e];
+                        const float d = nx * (p.x - ax) + ny * (p.y - ay);
+                        const float dOld = nx * (p.oldX - ax) + ny * (p.oldY - ay);
+                        if (d >= pointRadius || dOld < -pointRadius) continue;
+
+                        p.x += nx * (pointRadius - d);
+                        p.y += ny * (pointRadius - d);
+                        p.oldX = p.x - (p.x - p.oldX) * 0.5f;
+                        p.oldY = p.y - (p.y - p.oldY) * 0.5f;
+                    }
                 }
             }
-        }
+            return true;
+        };
+        tree_query(world->tree, sbBounds, collide);
+        tree_query(world->staticTree, sbBounds, collide);
 
         // 5. Primitive World Bounds (Keep it inside a box for now)
         for (int pIdx = 0; pIdx < sb.pointCount; pIdx++) {
@@ -1047,7 +2185,7 @@ FLASH_API void apply_force(PhysicsWorld* world, int32_t bodyId, float fx, float
         NativeBody& b = world->bodies[bodyId];
         b.forceX += fx;
         b.forceY += fy;
-        b.isAwake = 1;
+        wake_island(world, bodyId);
         b.sleepTime = 0.0f;
     }
 }
@@ -1056,7 +2194,7 @@ FLASH_API void apply_torque(PhysicsWorld* world, int32_t bodyId, float torque) {
     if (world && bodyId >= 0 && bodyId < world->activeCount) {
         NativeBody& b = world->bodies[bodyId];
         b.torque += torque;
-        b.isAwake = 1;
+        wake_island(world, bodyId);
         b.sleepTime = 0.0f;
     }
 }
@@ -1066,7 +2204,23 @@ FLASH_API void set_body_velocity(PhysicsWorld* world, int32_t bodyId, float vx,
         NativeBody& b = world->bodies[bodyId];
         b.vx = vx;
         b.vy = vy;
-        b.isAwake = 1;
+        wake_island(world, bodyId);
+        b.sleepTime = 0.0f;
+    }
+}
+
+FLASH_API void set_body_filter(PhysicsWorld* world, int32_t bodyId, uint32_t categoryBits, uint32_t maskBits) {
+    if (!world || bodyId < 0 || bodyId >= world->activeCount) return;
+    NativeBody& b = world->bodies[bodyId];
+    if (!b.alive) return;
+    b.categoryBits = categoryBits;
+    b.maskBits = maskBits;
+    DynamicTree* tree = body_tree(world, b);
+    if (tree_set_leaf_filter(tree, b.proxyId, TreeFilter{categoryBits, maskBits})) {
+        tree_buffer_move(tree, b.proxyId);
+        // Its contacts change with its pairs, which a sleeping island would
+        // not notice.
+        wake_island(world, bodyId);
         b.sleepTime = 0.0f;
     }
 }
@@ -1078,6 +2232,50 @@ FLASH_API void get_body_position(PhysicsWorld* world, int32_t bodyId, float* x,
     }
 }
 
+static inline void write_body_state(const NativeBody& b, int32_t id, BodyState& s) {
+    s.id = id;
+    s.x = b.x;
+    s.y = b.y;
+    s.rotation = b.rotation;
+    s.vx = b.vx;
+    s.vy = b.vy;
+    s.angularVelocity = b.angularVelocity;
+    s.awake = b.isAwake;
+}
+
+FLASH_API int32_t get_body_transforms(PhysicsWorld* world, const int32_t* ids, int32_t count, BodyState* out) {
+    if (!world || !ids || !out) return 0;
+    int32_t live = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        const int32_t id = ids[i];
+        if (id >= 0 && id < world->activeCount && world->bodies[id].alive) {
+            write_body_state(world->bodies[id], id, out[i]);
+            ++live;
+        } else {
+            out[i] = BodyState{id, 0, 0, 0, 0, 0, 0, 0};
+        }
+    }
+    return live;
+}
+
+FLASH_API int32_t get_awake_body_transforms(PhysicsWorld* world, BodyState* out, int32_t max) {
+    if (!world || !out) return 0;
+    int32_t written = 0;
+    for (int i = 0; i < world->activeCount && written < max; ++i) {
+        const NativeBody& b = world->bodies[i];
+        if (!b.alive || b.type == STATIC || !b.isAwake) continue;
+        write_body_state(b, i, out[written++]);
+    }
+    // Their last step moved them, if only by less than the sleep tolerance.
+    for (int32_t id : world->islands->fellAsleep) {
+        if (written >= max) break;
+        const NativeBody& b = world->bodies[id];
+        if (!b.alive || b.isAwake) continue;
+        write_body_state(b, id, out[written++]);
+    }
+    return written;
+}
+
 // --- RayCasting Implementation ---
 
 bool intersectRayCircle(float startX, float startY, float dx, float dy, 
@@ -1161,7 +2359,40 @@ bool intersectRayAABB(float startX, float startY, float dx, float dy,
     return true;
 }
 
-FLASH_API RayCastHit ray_cast(PhysicsWorld* world, float startX, float startY, float endX, float endY) {
+FLASH_API BroadphaseStats get_broadphase_stats(PhysicsWorld* world) {
+    if (!world) return BroadphaseStats{0, 0, 0, 0, 0, 0.0f, 0.0f};
+    BroadphaseStats stats = world->broadphaseStats;
+    stats.treeHeight = tree_height(world->tree);
+    stats.staticTreeHeight = tree_height(world->staticTree);
+    stats.areaRatio = tree_area_ratio(world->tree);
+    stats.staticAreaRatio = tree_area_ratio(world->staticTree);
+    return stats;
+}
+
+FLASH_API int32_t set_broadphase_rebuild(PhysicsWorld* world, int32_t mode) {
+    if (!world) return BROADPHASE_REBUILD_REINSERT;
+    const int32_t previous = world->tree->incrementalRebuild ? BROADPHASE_REBUILD_INCREMENTAL
+                                                             : BROADPHASE_REBUILD_REINSERT;
+    // Nodes left enlarged by a switch back are rebuilt by the next step.
+    world->tree->incrementalRebuild = mode == BROADPHASE_REBUILD_INCREMENTAL;
+    return previous;
+}
+
+FLASH_API void rebuild_broadphase(PhysicsWorld* world) {
+    if (!world) return;
+    tree_rebuild(world->tree, true);
+    tree_rebuild(world->staticTree, true);
+}
+
+FLASH_API int32_t set_pair_parallel_threshold(PhysicsWorld* world, int32_t threshold) {
+    if (!world) return kPairParallelThreshold;
+    const int32_t previous = world->tree->parallelThreshold;
+    world->tree->parallelThreshold = threshold;
+    return previous;
+}
+
+FLASH_API RayCastHit ray_cast(PhysicsWorld* world, float startX, float startY, float endX, float endY,
+                              uint32_t maskBits) {
     RayCastHit closest;
     closest.hit = 0;
     closest.fraction = 1.0f;
@@ -1177,20 +2408,18 @@ FLASH_API RayCastHit ray_cast(PhysicsWorld* world, float startX, float startY, f
     // tree is best at, since a segment prunes most of the hierarchy at the
     // first couple of levels.
     //
-    // Candidates are bounded by the scratch buffer. A segment that genuinely
-    // crosses more bodies than fit will test the first `kMaxRayCandidates` of
-    // them; that is a broad-phase clamp, so the exact test below still decides
-    // which is nearest among those.
-    const int kMaxRayCandidates = 256;
-    uint32_t candidates[kMaxRayCandidates];
-    const int candidateCount =
-        tree_query_ray(world->tree, startX, startY, endX, endY, candidates, kMaxRayCandidates);
-
-    for (int c = 0; c < candidateCount; ++c) {
-        const uint32_t bodyId = candidates[c];
-        if ((int)bodyId >= world->activeCount) continue;
+    // Each candidate is tested as the tree finds it, and the ray is clipped
+    // to the nearest hit so far: a body the ray only reaches past it cannot
+    // be nearer, so its subtree is never opened. Candidates used to be
+    // collected first into a 256-entry buffer, and a segment across a dense
+    // scene could miss its nearest hit among the ones that did not fit.
+    //
+    // Bodies outside `maskBits` never become candidates: the tree skips the
+    // subtrees that hold none of its categories.
+    auto cast = [&](uint32_t bodyId) {
+        if ((int)bodyId >= world->activeCount) return closest.fraction;
         NativeBody& b = world->bodies[bodyId];
-        if (!b.alive) continue;
+        if (!b.alive) return closest.fraction;
 
         float hitFraction = 1.0f;
         float nx = 0, ny = 0;
@@ -1200,8 +2429,8 @@ FLASH_API RayCastHit ray_cast(PhysicsWorld* world, float startX, float startY, f
              hit = intersectRayCircle(startX, startY, dx, dy, b.x, b.y, b.radius, hitFraction, nx, ny);
         } else if (b.shapeType == SHAPE_BOX) {
             // Transform Ray to Box Local Space
-            float c = std::cos(-b.rotation);
-            float s = std::sin(-b.rotation);
+            float c = b.q.c;
+            float s = -b.q.s;
             
             float localStartX = (startX - b.x) * c - (startY - b.y) * s;
             float localStartY = (startX - b.x) * s + (startY - b.y) * c;
@@ -1216,12 +2445,8 @@ FLASH_API RayCastHit ray_cast(PhysicsWorld* world, float startX, float startY, f
                                 -hw, -hh, hw, hh, hitFraction, nx, ny)) {
                 
                 // Transform normal back to world space
-                float c_rot = std::cos(b.rotation); // Assuming previous c was cos(-rot) = cos(rot)
-                float s_rot = std::sin(b.rotation); // existing s was sin(-rot) = -sin(rot)
-                
-                // Manually recalculate C/S for clarity
-                c_rot = c;
-                s_rot = -s;
+                float c_rot = b.q.c;
+                float s_rot = b.q.s;
                 
                 float worldNx = nx * c_rot - ny * s_rot;
                 float worldNy = nx * s_rot + ny * c_rot;
@@ -1230,6 +2455,10 @@ FLASH_API RayCastHit ray_cast(PhysicsWorld* world, float startX, float startY, f
                 ny = worldNy;
                 hit = true;
             }
+        } else if (const PolygonShape* polygon = body_polygon(world, bodyId)) {
+            hit = ray_cast_polygon(b, *polygon, startX, startY, dx, dy, hitFraction, nx, ny);
+        } else if (const ChainShape* chain = body_chain(world, bodyId)) {
+            hit = ray_cast_chain(*chain, startX, startY, dx, dy, hitFraction, nx, ny);
         }
         
         if (hit && hitFraction < closest.fraction) {
@@ -1241,7 +2470,10 @@ FLASH_API RayCastHit ray_cast(PhysicsWorld* world, float startX, float startY, f
             closest.x = startX + dx * hitFraction;
             closest.y = startY + dy * hitFraction;
         }
-    }
+        return closest.fraction;
+    };
+    tree_raycast(world->tree, TreeRay{startX, startY, endX, endY, closest.fraction}, cast, maskBits);
+    tree_raycast(world->staticTree, TreeRay{startX, startY, endX, endY, closest.fraction}, cast, maskBits);
     
     return closest;
 }
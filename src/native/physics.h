@@ -2,12 +2,25 @@
 #define FLASH_PHYSICS_H
 
 #include <stdint.h>
+#include <cmath>
 #include <vector>
 #include "flash_export.h"
 
 // Bumped whenever the exported C ABI changes (struct layout, signatures).
 // Dart mirrors this in FlashNative and checks it at load time.
-#define FLASH_ABI_VERSION 4
+#define FLASH_ABI_VERSION 20
+
+// A rotation as its cosine and sine (Box2D v3's b2Rot).
+struct Rot {
+    float c, s;
+};
+
+inline Rot make_rot(float angle) { return {std::cos(angle), std::sin(angle)}; }
+
+// Box2D's b2_linearSlop (0.005 m) in this world's pixels at 100 per metre:
+// the collision tolerance the narrow phase and the continuous pass work to,
+// and how close two polygon or chain points must be to weld into one.
+constexpr float kLinearSlop = 0.005f * 100.0f;
 
 extern "C" {
 
@@ -19,7 +32,126 @@ enum BodyType {
 
 enum ShapeType {
     SHAPE_CIRCLE = 0,
-    SHAPE_BOX = 1
+    SHAPE_BOX = 1,
+    SHAPE_POLYGON = 2,  // convex, up to 8 vertices; see polygon.h
+    SHAPE_CHAIN = 3     // static polyline of one-sided segments; see chain.h
+};
+
+// How step_physics spreads the contact and joint solver over the thread pool.
+enum SolverThreading {
+    SOLVER_THREADING_SERIAL = 0,         // one thread, constraint list order
+    SOLVER_THREADING_GRAPH_COLORED = 1,  // colors in order, each split across the pool
+    SOLVER_THREADING_ISLANDS = 2         // one task per awake island
+};
+
+// Which contact solver step_physics runs.
+enum SolverMode {
+    // velocityIterations of sequential impulses, one position integration,
+    // then positionIterations of Baumgarte pseudo-impulses. The default.
+    SOLVER_MODE_NGS = 0,
+    // Box2D v3's soft step: subStepCount substeps of integrate, solve with
+    // soft contacts, integrate, relax; then one restitution pass. The
+    // iteration counts are not used.
+    SOLVER_MODE_SOFT_STEP = 1
+};
+
+// What holds the moving bodies' proxies; picked at create_physics_world.
+// Static bodies are in a tree whichever is picked: they never move, which is
+// what a tree is best at, and a ground box spanning the arena would defeat
+// a grid's cells and widen every sort-and-sweep scan.
+enum Broadphase {
+    BROADPHASE_TREE = 0,            // dynamic AABB tree; the default
+    BROADPHASE_GRID = 1,            // uniform spatial-hash grid; see spatial_grid.h
+    BROADPHASE_SORT_AND_SWEEP = 2   // sorted on x, swept 4 wide; see sort_and_sweep.h
+};
+
+// How the moving-body broadphase tree keeps up with bodies that leave their
+// fat AABB.
+enum BroadphaseRebuild {
+    // Each one is removed and reinserted at once. The default.
+    BROADPHASE_REBUILD_REINSERT = 0,
+    // Box2D v3's: each one is grown in place, and the part of the tree they
+    // grew is rebuilt with SAH once per step, before the pairs are found.
+    BROADPHASE_REBUILD_INCREMENTAL = 1
+};
+
+// What a ContactEvent reports. Also the bit index in set_contact_event_mask.
+enum ContactEventType {
+    CONTACT_BEGIN = 0,           // the pair started touching this step
+    CONTACT_END = 1,             // the pair stopped touching, or a body was destroyed
+    CONTACT_PERSIST = 2,         // the pair is still touching; off by default
+    CONTACT_EVENTS_DROPPED = 3   // the ring overflowed and older events were lost
+};
+
+// One entry of the contact event stream. bodyA is the lower id; the normal
+// points from A to B. For CONTACT_END the point and normal are from the last
+// step the pair touched. approachSpeed is the closing speed along the normal
+// at the point, measured before the solver ran, and 0 when separating — it is
+// what impact sounds and damage want. A CONTACT_EVENTS_DROPPED entry carries
+// no pair (both ids -1) and means every count derived from earlier events is
+// stale.
+struct ContactEvent {
+    int32_t type;
+    int32_t bodyA;
+    int32_t bodyB;
+    float x, y;
+    float normalX, normalY;
+    float approachSpeed;
+};
+
+// One point of a contact's manifold as the last step left it (Box2D's
+// b2ManifoldPoint, trimmed). The anchor is relative to body A's position when
+// the manifold was built; separation is negative when overlapping. id names
+// the point across steps: the feature it was clipped from.
+struct ManifoldPoint {
+    float anchorX, anchorY;
+    float separation;
+    float normalImpulse;
+    float tangentImpulse;
+    uint32_t id;
+};
+
+// A body's pose, as step_physics_fixed interpolates it for rendering.
+struct BodyPose {
+    float x, y;
+    float rotation;
+};
+
+// Everything create_body takes, plus what Dart used to set straight after it,
+// for create_bodies.
+struct BodyDef {
+    int32_t type;
+    int32_t shapeType;
+    float x, y;
+    float width, height;
+    float rotation;
+    float restitution;
+    float friction;
+    uint32_t categoryBits;
+    uint32_t maskBits;
+    int32_t isBullet;
+};
+
+// One body's state in a get_body_transforms export. awake is 0 for a body
+// that is asleep (or, in the awake export, fell asleep in the last step) and
+// for an id that names no live body, whose other fields are then 0 too.
+struct BodyState {
+    int32_t id;
+    float x, y, rotation;
+    float vx, vy, angularVelocity;
+    int32_t awake;
+};
+
+// Broadphase work done by the last step_physics, and the shape of the trees
+// now, from get_broadphase_stats.
+struct BroadphaseStats {
+    int32_t checkedProxies;   // awake proxies checked against their fat AABB
+    int32_t reinsertions;     // ... of which had left it and were reinserted
+    int32_t pairCount;        // pairs in the persistent pair set
+    int32_t treeHeight;       // height of the moving-body tree
+    int32_t staticTreeHeight; // height of the static-body tree
+    float areaRatio;          // moving tree's internal perimeters over its root's
+    float staticAreaRatio;    // the same for the static tree
 };
 
 // Softness parameters for spring-damped constraints (Box2D-inspired)
@@ -65,6 +197,9 @@ struct ContactConstraintPoint {
     float tangentImpulse;      // Accumulated tangent impulse
     float normalMass;          // Effective mass in normal direction
     float tangentMass;         // Effective mass in tangent direction
+    float relativeVelocity;    // Normal velocity before the solver ran (soft step restitution)
+    float maxNormalImpulse;    // Largest normal impulse this step; 0 means the point never pushed
+    uint32_t id;               // Feature id the manifold gave the point; matches it across steps
 };
 
 // Contact constraint for advanced solver
@@ -78,6 +213,8 @@ struct ContactConstraint {
     float rollingResistance;
     int pointCount;
     Softness softness;
+    float rotationA, rotationB;  // Body rotations when the manifold was built
+    int32_t childIndex;          // chain segment for a pair with a chain, else 0
 };
 
 struct NativeBody {
@@ -85,6 +222,11 @@ struct NativeBody {
     int type;
     int shapeType;
     float x, y, rotation;
+    // cos and sin of rotation, refreshed wherever rotation is written, so
+    // the narrow phase, AABBs and queries never take them per pair or per
+    // query. rotation stays the integrated angle: unwrapped, which is what
+    // interpolation and the soft step's angle deltas need.
+    Rot q;
     float vx, vy, angularVelocity;
     float forceX, forceY, torque;
     float mass, inverseMass;
@@ -99,6 +241,30 @@ struct NativeBody {
     int32_t proxyId;
     int isAwake;
     int alive;           // 0 once the slot is released back to the free list
+    int isBullet;        // swept against the world after each step; see continuous.h
+};
+
+// The part of a body the solver reads and writes, split out of NativeBody.
+//
+// A NativeBody is 124 bytes, and the fields a contact solve needs — pose,
+// velocity, inverse mass and inertia, type, awake — are spread across it, so
+// every body a contact touches pulled two cache lines, most of them
+// filter bits, dimensions and timers. These 40 bytes are what the
+// integrate loops and the contact and joint solvers work on during the
+// solve; NativeBody stays the body Dart sees, loaded from and stored back to
+// around it. Static bodies' states are written once, at creation.
+struct SolverBody {
+    float x, y, rotation;
+    float vx, vy, angularVelocity;
+    float inverseMass, inverseInertia;
+    int type;
+    int isAwake; // alive, not static and awake: the solver moves it this step
+};
+
+// An awake body's acceleration from gravity and its applied force and
+// torque, taken once per step.
+struct BodyAcceleration {
+    float x, y, angular;
 };
 
 struct PhysicsWorld {
@@ -117,7 +283,7 @@ struct PhysicsWorld {
     float maxLinearVelocity;     // Maximum linear velocity (for stability)
     
     // Internal solver state (keep at end to avoid shifting offsets for Dart FFI)
-    ContactConstraint* constraints;
+    ContactConstraint* constraints;  // live contacts, sleeping islands' included
     int maxConstraints;
     int activeConstraints;
 
@@ -131,38 +297,231 @@ struct PhysicsWorld {
     int32_t* bodyFreeList;
     int bodyFreeCount;
 
-    // Broadphase dynamic tree
+    // Broadphase trees. Static bodies have one of their own: it changes only
+    // when one is created or destroyed, and is only ever queried against,
+    // never walked for pairs. `tree` holds everything that can move.
     struct DynamicTree* tree;
+    struct DynamicTree* staticTree;
     
     // Native Box2D-style Joints
     struct Joint* boxJoints;
     int maxBoxJoints;
     int activeBoxJoints;
 
-    // Internal cache for warm starting (C++ std::map<uint64_t, ...>*)
-    void* warmStartCache;
+    // Persistent contacts: the pair -> slot hash and per-body contact lists
+    // over `constraints`, which hold each contact's manifold and impulses
+    // from step to step. See contact_table.h.
+    struct ContactTable* contactTable;
 
     // Broadphase pair scratch, owned for the life of the world. This was a
     // new[]/delete[] pair on every step_physics call.
     struct BroadphasePair* pairScratch;
     int maxPairs;
+
+    // Solver threading, a SolverThreading value; serial by default. The
+    // graph is only built for SOLVER_THREADING_GRAPH_COLORED. See
+    // set_solver_threading.
+    int solverThreading;
+    struct ConstraintGraph* constraintGraph;
+
+    // Simulation islands: rebuilt every step, and the unit that sleeps and
+    // wakes. See island.h.
+    struct IslandSet* islands;
+
+    // Contact solver, a SolverMode value; NGS by default. subStepCount is
+    // only read by SOLVER_MODE_SOFT_STEP. See set_solver_mode.
+    int solverMode;
+    int subStepCount;
+
+    // Start poses of the awake bullets for the continuous pass at the end of
+    // the step. See continuous.h.
+    struct ContinuousSet* continuous;
+
+    // step_physics_fixed's state. The accumulator holds the frame time not
+    // yet stepped. previousPoses are the bodies' poses before the last fixed
+    // step (the current ones are the bodies themselves), and renderPoses the
+    // blend of the two at stepAlpha = accumulator / fixedDt; both maxBodies
+    // long.
+    float stepAccumulator;
+    float stepAlpha;
+    BodyPose* previousPoses;
+    BodyPose* renderPoses;
+
+    // Vertices and normals of SHAPE_POLYGON bodies, indexed by body id,
+    // maxBodies long; other slots are unused. See polygon.h.
+    struct PolygonShape* polygons;
+
+    // Segments of SHAPE_CHAIN bodies, per body id. See chain.h.
+    struct ChainSet* chains;
+
+    // Filled in by each step_physics. See get_broadphase_stats.
+    BroadphaseStats broadphaseStats;
+
+    // The solver's body storage, maxBodies long: solverBodies by body id, and
+    // the awake bodies' ids in slot order with their accelerations
+    // alongside, for the integrate loops. See SolverBody.
+    SolverBody* solverBodies;
+    int32_t* awakeBodies;
+    BodyAcceleration* awakeAccelerations;
+    int awakeBodyCount;
+
+    // The graph-colored NGS solver's contacts, four to a WideContact, rebuilt
+    // every step; on unless set_wide_contact_solver turned it off. See
+    // contact_solver.h.
+    struct WideContactSet* wideContacts;
+    int wideContactSolver;
 };
 
-FLASH_API PhysicsWorld* create_physics_world(int maxBodies);
+/// Creates a world of up to `maxBodies` bodies, with `broadphase` (a
+/// Broadphase value; anything else selects the tree) holding the moving
+/// ones. A grid or sort-and-sweep world reports zero height and area ratio
+/// for its moving bodies in BroadphaseStats, and ignores
+/// set_broadphase_rebuild. Returns NULL for a `maxBodies` below 1 or above
+/// 2^24, the most the contact table can tell apart.
+FLASH_API PhysicsWorld* create_physics_world(int maxBodies, int32_t broadphase);
 FLASH_API void destroy_physics_world(PhysicsWorld* world);
 FLASH_API void step_physics(PhysicsWorld* world, float dt);
+
+/// Advances the world by `frameDt` in whole steps of `fixedDt`, carrying the
+/// remainder to the next call, and then writes every live body's pose,
+/// interpolated between its last two fixed steps by the remainder, to the
+/// buffer get_interpolated_poses returns. At most `maxSubsteps` steps are
+/// taken; time beyond that is dropped rather than owed to later frames.
+/// Returns the number of steps taken, which may be 0.
+FLASH_API int32_t step_physics_fixed(PhysicsWorld* world, float frameDt, float fixedDt, int32_t maxSubsteps);
+
+/// The pose buffer step_physics_fixed writes, indexed by body id and
+/// maxBodies long. Stable for the life of the world. Slots of released
+/// bodies hold stale poses.
+FLASH_API const BodyPose* get_interpolated_poses(PhysicsWorld* world);
 /// Releases a body's slot back to the pool: removes its broadphase proxy,
 /// drops any joint that referenced it, and purges its warm-start impulses so a
-/// later body reusing the slot does not inherit them.
+/// later body reusing the slot does not inherit them. Each contact it had
+/// queues a CONTACT_END event, so whatever it was touching hears about it.
 FLASH_API void destroy_body(PhysicsWorld* world, int32_t bodyId);
 
+/// Picks how the solver uses the thread pool; `mode` is a SolverThreading
+/// value, and anything else selects serial. Island mode solves each island in
+/// serial order, so it matches the serial solver exactly. Graph coloring
+/// visits constraints in a different order and agrees within solver tolerance
+/// rather than bit for bit. Neither result depends on the thread count.
+/// Returns the previous mode.
+FLASH_API int32_t set_solver_threading(PhysicsWorld* world, int32_t mode);
+
+/// Whether the graph-colored NGS solver (SOLVER_THREADING_GRAPH_COLORED)
+/// solves contacts four at a time with SSE or NEON; on by default. The
+/// bodies come out bit for bit the same either way, so this only exists to
+/// compare the two. Serial, island and soft-step solving are unaffected.
+/// Returns the previous setting.
+FLASH_API int32_t set_wide_contact_solver(PhysicsWorld* world, int32_t enabled);
+
+/// Picks the contact solver; `mode` is a SolverMode value, and anything else
+/// selects NGS. `subStepCount` is the soft step's substeps per step_physics
+/// call, clamped to at least 1, and is kept whichever mode is chosen.
+/// Returns the previous mode. Threading (set_solver_threading) applies to
+/// both.
+FLASH_API int32_t set_solver_mode(PhysicsWorld* world, int32_t mode, int32_t subStepCount);
+
+/// Copies up to `max` pending contact events into `buffer`, oldest first, and
+/// removes them from the queue; returns the number written. step_physics
+/// appends to the queue and destroy_body appends the END events of the body's
+/// contacts. It is a ring of maxConstraints entries: if it fills before it is
+/// drained, the oldest are overwritten and the next drain starts with a
+/// CONTACT_EVENTS_DROPPED entry.
+FLASH_API int32_t get_contact_events(PhysicsWorld* world, ContactEvent* buffer, int32_t max);
+
+/// Picks which event types are queued: bit `1 << type` per ContactEventType.
+/// BEGIN and END by default. PERSIST costs one event per touching pair per
+/// step, so it is opt-in. Returns the previous mask.
+FLASH_API int32_t set_contact_event_mask(PhysicsWorld* world, int32_t mask);
+
+/// Copies up to `max` points of the contact between two bodies, in either
+/// order, to `out`, in manifold order; returns the number written, 0 if they
+/// are not touching. Pairs with a chain have a contact per segment, which
+/// this does not read.
+FLASH_API int32_t get_contact_points(PhysicsWorld* world, int32_t bodyA, int32_t bodyB, ManifoldPoint* out, int32_t max);
+
 FLASH_API int32_t create_body(PhysicsWorld* world, int type, int shapeType, float x, float y, float w, float h, float rotation, uint32_t categoryBits, uint32_t maskBits);
 FLASH_API int32_t get_physics_version();
+
+/// create_body for `count` bodies in one call, writing each new id (or -1
+/// once the pool is full) to `outIds`. Polygon and chain defs get -1 too:
+/// those shapes come from create_polygon_body and create_chain_body. The proxies go into the broadphase
+/// together, so a batch into an empty or small tree is one top-down build
+/// instead of a rebalancing insert per body. Returns how many were created.
+FLASH_API int32_t create_bodies(PhysicsWorld* world, const BodyDef* defs, int32_t count, int32_t* outIds);
+
+/// destroy_body for `count` bodies: one pass over the joints for the whole
+/// batch, and one tree rebuild when the batch is most of the tree. Invalid,
+/// already released and repeated ids are skipped.
+FLASH_API void destroy_bodies(PhysicsWorld* world, const int32_t* ids, int32_t count);
+
+/// Creates a convex polygon body from `count` points (interleaved x, y)
+/// relative to (x, y), up to 8. The body is their convex hull, and its
+/// position is the hull's centroid — (x, y) plus the centroid, rotated —
+/// since that is what it turns about. Returns -1 if the points do not span
+/// an area or there are more than 8.
+FLASH_API int32_t create_polygon_body(PhysicsWorld* world, int type, float x, float y, float rotation,
+                                      const float* vertices, int32_t count, uint32_t categoryBits, uint32_t maskBits);
+
+/// Creates a static chain body: the polyline through `count` points
+/// (interleaved x, y, world space), closed back to the first point when
+/// `loop` is set. Segments are one-sided and collide with what is on their
+/// right, so list a terrain surface right to left and wind a loop
+/// counter-clockwise. Returns -1 for fewer than 2 distinct points (3 for a
+/// loop), or for more than 65536 segments.
+FLASH_API int32_t create_chain_body(PhysicsWorld* world, const float* vertices, int32_t count, int32_t loop,
+                                    uint32_t categoryBits, uint32_t maskBits);
+
+/// Copies a polygon body's hull to `outXY` (interleaved x, y, up to `max`
+/// vertices), in its local frame: counter-clockwise about the body position.
+/// Returns the vertex count, or 0 if the body is not a polygon.
+FLASH_API int32_t get_polygon_vertices(PhysicsWorld* world, int32_t bodyId, float* outXY, int32_t max);
 FLASH_API void apply_force(PhysicsWorld* world, int32_t bodyId, float fx, float fy);
 FLASH_API void apply_torque(PhysicsWorld* world, int32_t bodyId, float torque);
 FLASH_API void set_body_velocity(PhysicsWorld* world, int32_t bodyId, float vx, float vy);
+
+/// Changes a body's collision filter. The broadphase keeps a copy of it to
+/// skip whole layers in its queries, so writing NativeBody's fields directly
+/// leaves pairs found, or not, under the old one.
+FLASH_API void set_body_filter(PhysicsWorld* world, int32_t bodyId, uint32_t categoryBits, uint32_t maskBits);
 FLASH_API void get_body_position(PhysicsWorld* world, int32_t bodyId, float* x, float* y);
 
+/// Copies the state of each of `count` bodies in `ids` to `out`, in the same
+/// order; one call per frame in place of a struct read per body. Returns how
+/// many of the ids were live bodies.
+FLASH_API int32_t get_body_transforms(PhysicsWorld* world, const int32_t* ids, int32_t count, BodyState* out);
+
+/// Copies the state of every awake body, and of every body that fell asleep
+/// in the last step (with awake 0, so its resting pose is not missed), to
+/// `out`, up to `max`. Static and sleeping bodies do not move, so this is
+/// everything a renderer needs to refresh. Returns the number written.
+FLASH_API int32_t get_awake_body_transforms(PhysicsWorld* world, BodyState* out, int32_t max);
+
+/// What the broadphase did in the last step_physics: how many awake proxies
+/// it checked, how many of those had outgrown their fat AABB and were
+/// reinserted into the tree, and how many pairs it holds; all zero before the
+/// first step. Also the height and area ratio (see tree_area_ratio in
+/// broadphase.h) of both trees as they are now, which stay flat over a long
+/// session if the trees are not degrading.
+FLASH_API BroadphaseStats get_broadphase_stats(PhysicsWorld* world);
+
+/// Picks how the moving-body tree handles bodies that leave their fat AABB;
+/// `mode` is a BroadphaseRebuild value, and anything else selects reinsert.
+/// Either way a moved proxy counts as a reinsertion in BroadphaseStats.
+/// Returns the previous mode.
+FLASH_API int32_t set_broadphase_rebuild(PhysicsWorld* world, int32_t mode);
+
+/// Rebuilds both broadphase trees top-down with SAH. create_bodies does this
+/// for a batch at least as large as the tree; call it after a level is
+/// loaded body by body, or to reset a tree after heavy churn.
+FLASH_API void rebuild_broadphase(PhysicsWorld* world);
+
+/// Moved proxies at or above which a step's pair finding runs across the
+/// thread pool. The pairs are the same either way; exposed so a benchmark can
+/// measure both paths on identical input. Returns the previous threshold.
+FLASH_API int32_t set_pair_parallel_threshold(PhysicsWorld* world, int32_t threshold);
+
 // Soft Body functions
 FLASH_API int32_t create_soft_body(PhysicsWorld* world, int pointCount, float* initialX, float* initialY, float pressure, float stiffness);
 FLASH_API void get_soft_body_point(PhysicsWorld* world, int32_t sbId, int pointIdx, float* x, float* y);
@@ -185,7 +544,10 @@ struct RayCastHit {
     int hit; // boolean flag
 };
 
-FLASH_API RayCastHit ray_cast(PhysicsWorld* world, float startX, float startY, float endX, float endY);
+/// The nearest body the segment hits among those whose categoryBits share a
+/// bit with `maskBits`; 0xFFFFFFFF hits every body.
+FLASH_API RayCastHit ray_cast(PhysicsWorld* world, float startX, float startY, float endX, float endY,
+                              uint32_t maskBits);
 
 }
 
@@ -0,0 +1,143 @@
+#include "polygon.h"
+#include "physics.h"
+#include <cmath>
+
+namespace {
+
+struct Point {
+    float x, y;
+};
+
+inline float cross(Point o, Point a, Point b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+} // namespace
+
+bool make_polygon(const float* xy, int count, PolygonShape& out, float& centroidX, float& centroidY) {
+    if (!xy || count < 3 || count > kMaxPolygonVertices) return false;
+
+    // Weld points within kLinearSlop of one another.
+    Point points[kMaxPolygonVertices];
+    int n = 0;
+    for (int i = 0; i < count; ++i) {
+        const Point p = {xy[2 * i], xy[2 * i + 1]};
+        bool unique = true;
+        for (int k = 0; k < n && unique; ++k) {
+            const float dx = p.x - points[k].x, dy = p.y - points[k].y;
+            unique = dx * dx + dy * dy > kLinearSlop * kLinearSlop;
+        }
+        if (unique) points[n++] = p;
+    }
+    if (n < 3) return false;
+
+    // Andrew's monotone chain, counter-clockwise. A strict turn test drops
+    // collinear points, which would otherwise give zero-length normals'
+    // worth of redundant edges.
+    // Insertion sort by x, then y; there are at most eight.
+    for (int i = 1; i < n; ++i) {
+        const Point p = points[i];
+        int k = i;
+        for (; k > 0 && (points[k - 1].x > p.x || (points[k - 1].x == p.x && points[k - 1].y > p.y)); --k) {
+            points[k] = points[k - 1];
+        }
+        points[k] = p;
+    }
+    Point hull[2 * kMaxPolygonVertices];
+    int h = 0;
+    for (int i = 0; i < n; ++i) {
+        while (h >= 2 && cross(hull[h - 2], hull[h - 1], points[i]) <= 0.0f) --h;
+        hull[h++] = points[i];
+    }
+    for (int i = n - 2, lower = h + 1; i >= 0; --i) {
+        while (h >= lower && cross(hull[h - 2], hull[h - 1], points[i]) <= 0.0f) --h;
+        hull[h++] = points[i];
+    }
+    --h;  // the last point repeats the first
+    if (h < 3) return false;
+
+    // Area-weighted centroid, from a triangle fan about the first vertex.
+    float area = 0.0f, cx = 0.0f, cy = 0.0f;
+    for (int i = 1; i + 1 < h; ++i) {
+        const float a = 0.5f * cross(hull[0], hull[i], hull[i + 1]);
+        area += a;
+        cx += a * (hull[0].x + hull[i].x + hull[i + 1].x) / 3.0f;
+        cy += a * (hull[0].y + hull[i].y + hull[i + 1].y) / 3.0f;
+    }
+    if (area <= kLinearSlop * kLinearSlop) return false;
+    centroidX = cx / area;
+    centroidY = cy / area;
+
+    out.count = h;
+    for (int i = 0; i < h; ++i) {
+        out.x[i] = hull[i].x - centroidX;
+        out.y[i] = hull[i].y - centroidY;
+    }
+    for (int i = 0; i < h; ++i) {
+        const int j = i + 1 < h ? i + 1 : 0;
+        const float ex = out.x[j] - out.x[i], ey = out.y[j] - out.y[i];
+        const float len = std::sqrt(ex * ex + ey * ey);
+        out.nx[i] = ey / len;
+        out.ny[i] = -ex / len;
+    }
+    return true;
+}
+
+float polygon_inertia(const PolygonShape& polygon, float mass) {
+    // b2ComputePolygonMass with the centroid as the fan origin, which the
+    // vertices already are relative to.
+    float area = 0.0f, inertia = 0.0f;
+    for (int i = 0; i < polygon.count; ++i) {
+        const int j = i + 1 < polygon.count ? i + 1 : 0;
+        const float e1x = polygon.x[i], e1y = polygon.y[i];
+        const float e2x = polygon.x[j], e2y = polygon.y[j];
+        const float d = e1x * e2y - e1y * e2x;
+        area += 0.5f * d;
+        const float intx2 = e1x * e1x + e2x * e1x + e2x * e2x;
+        const float inty2 = e1y * e1y + e2y * e1y + e2y * e2y;
+        inertia += (0.25f / 3.0f) * d * (intx2 + inty2);
+    }
+    return area > 0.0f ? mass * inertia / area : 0.0f;
+}
+
+const PolygonShape* body_polygon(const PhysicsWorld* world, int32_t bodyId) {
+    if (!world || world->bodies[bodyId].shapeType != SHAPE_POLYGON) return nullptr;
+    return &world->polygons[bodyId];
+}
+
+bool ray_cast_polygon(const NativeBody& body, const PolygonShape& polygon, float startX, float startY,
+                      float dx, float dy, float& outFraction, float& outNx, float& outNy) {
+    // b2RayCastPolygon: clip the segment against each edge's half plane, in
+    // the polygon's frame.
+    const float c = body.q.c, s = body.q.s;
+    const float px = c * (startX - body.x) + s * (startY - body.y);
+    const float py = -s * (startX - body.x) + c * (startY - body.y);
+    const float ldx = c * dx + s * dy;
+    const float ldy = -s * dx + c * dy;
+
+    float lower = 0.0f, upper = 1.0f;
+    int index = -1;
+    for (int i = 0; i < polygon.count; ++i) {
+        // p = p1 + t * d; dot(normal, p - v) = 0 at the edge.
+        const float numerator = polygon.nx[i] * (polygon.x[i] - px) + polygon.ny[i] * (polygon.y[i] - py);
+        const float denominator = polygon.nx[i] * ldx + polygon.ny[i] * ldy;
+        if (denominator == 0.0f) {
+            if (numerator < 0.0f) return false;  // parallel and outside
+        } else if (denominator < 0.0f && numerator < lower * denominator) {
+            // Entering this half plane later than any so far.
+            lower = numerator / denominator;
+            index = i;
+        } else if (denominator > 0.0f && numerator < upper * denominator) {
+            upper = numerator / denominator;
+        }
+        if (upper < lower) return false;
+    }
+    // index < 0 means the start is inside, which is not a hit — the same as
+    // the circle and box tests.
+    if (index < 0) return false;
+
+    outFraction = lower;
+    outNx = c * polygon.nx[index] - s * polygon.ny[index];
+    outNy = s * polygon.nx[index] + c * polygon.ny[index];
+    return true;
+}
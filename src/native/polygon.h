@@ -0,0 +1,50 @@
+#ifndef FLASH_POLYGON_H
+#define FLASH_POLYGON_H
+
+// Convex polygon shapes (Box2D's b2Polygon, without the rounding radius).
+//
+// Ramps, wedges and hulls used to be built from several boxes, each its own
+// body: more bodies, more broadphase pairs, and seams that snag whatever
+// slides across them. A polygon body is one convex hull of up to
+// kMaxPolygonVertices.
+//
+// The vertices live in a side table on the world, one PolygonShape per body
+// slot, rather than in NativeBody: 8 vertices and their normals would more
+// than double a struct every body pays for and Dart mirrors. They are stored
+// in the body's local frame, counter-clockwise and centred on the centroid —
+// the body's position is the centroid, because that is the point the solver
+// rotates it about — with each edge's outward normal precomputed, as
+// detectPolygons needs them for every pair every step.
+
+#include <stdint.h>
+
+struct PhysicsWorld;
+struct NativeBody;
+
+constexpr int kMaxPolygonVertices = 8;
+
+struct PolygonShape {
+    int32_t count;
+    float x[kMaxPolygonVertices], y[kMaxPolygonVertices];     // vertices, local
+    float nx[kMaxPolygonVertices], ny[kMaxPolygonVertices];   // edge i's normal, edge i = v[i] -> v[i+1]
+};
+
+// Builds the convex hull of `count` points (interleaved x, y), recentred on
+// its centroid, which is written to (centroidX, centroidY) in the input's
+// frame. Points closer than half a pixel are welded and collinear ones
+// dropped. Returns false for fewer than 3 hull points or more than
+// kMaxPolygonVertices input points.
+bool make_polygon(const float* xy, int count, PolygonShape& out, float& centroidX, float& centroidY);
+
+// Rotational inertia about the centroid of a polygon with the given mass.
+float polygon_inertia(const PolygonShape& polygon, float mass);
+
+// The polygon of a SHAPE_POLYGON body, or nullptr for any other shape.
+const PolygonShape* body_polygon(const PhysicsWorld* world, int32_t bodyId);
+
+// Exact ray test in world space against `body`, which has shape `polygon`.
+// On a hit writes the fraction along (dx, dy) and the world normal.
+bool ray_cast_polygon(const NativeBody& body, const PolygonShape& polygon, float startX, float startY,
+                      float dx, float dy, float& outFraction, float& outNx, float& outNy);
+
+#endif // FLASH_POLYGON_H
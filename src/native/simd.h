@@ -0,0 +1,32 @@
+#ifndef FLASH_SIMD_H
+#define FLASH_SIMD_H
+
+// Which 4-wide float instructions the native core may use.
+//
+// SSE2 is part of x86-64 itself and NEON of AArch64, so every desktop and
+// phone target has one of them without extra compiler flags. Anything else
+// (32-bit ARM built without NEON, say) falls back to the scalar loops beside
+// each use.
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define FLASH_SIMD_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FLASH_SIMD_NEON 1
+#endif
+
+#if defined(FLASH_SIMD_NEON)
+// _mm_movemask_ps for NEON: bit i set when lane i of the compare result `m`
+// is all ones.
+inline uint32_t neon_movemask(uint32x4_t m) {
+    static const uint32_t kLaneBits[4] = {1, 2, 4, 8};
+    const uint32x4_t bits = vandq_u32(m, vld1q_u32(kLaneBits));
+    const uint32x2_t half = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+    return vget_lane_u32(vpadd_u32(half, half), 0);
+}
+#endif
+
+#endif
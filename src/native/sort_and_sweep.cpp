@@ -0,0 +1,83 @@
+#include "sort_and_sweep.h"
+#include <cmath>
+
+SortAndSweep* create_sort_and_sweep() {
+    SortAndSweep* sweep = new SortAndSweep();
+    sweep->maxWidth = 0.0f;
+    sweep->changes = 0;
+    sweep->dirty = true;
+    return sweep;
+}
+
+void destroy_sort_and_sweep(SortAndSweep* sweep) {
+    delete sweep;
+}
+
+void sweep_insert(SortAndSweep* sweep, int32_t proxy) {
+    if ((size_t)proxy >= sweep->slot.size()) sweep->slot.resize(proxy + 1, -1);
+    sweep->slot[proxy] = (int32_t)sweep->proxies.size();
+    sweep->proxies.push_back(proxy);
+    sweep->changes++;
+    sweep->dirty = true;
+}
+
+void sweep_remove(SortAndSweep* sweep, int32_t proxy) {
+    const int32_t index = sweep->slot[proxy];
+    const int32_t last = sweep->proxies.back();
+    sweep->proxies[index] = last;
+    sweep->slot[last] = index;
+    sweep->proxies.pop_back();
+    sweep->slot[proxy] = -1;
+    sweep->changes++;
+    sweep->dirty = true;
+}
+
+void sweep_prepare(SortAndSweep* sweep, const TreeNode* nodes) {
+    if (!sweep->dirty) return;
+    std::vector<int32_t>& proxies = sweep->proxies;
+    const size_t count = proxies.size();
+
+    // Ties broken by proxy ID, so the order, and with it the order queries
+    // report in, does not depend on the order of the moves.
+    auto before = [nodes](int32_t a, int32_t b) {
+        const float ka = nodes[a].aabb.minX, kb = nodes[b].aabb.minX;
+        return ka < kb || (ka == kb && a < b);
+    };
+    if ((size_t)sweep->changes * 8 > count) {
+        std::sort(proxies.begin(), proxies.end(), before);
+    } else {
+        // Step to step the order barely changes, and insertion sort is
+        // linear on a list that is nearly sorted already.
+        for (size_t i = 1; i < count; ++i) {
+            const int32_t p = proxies[i];
+            size_t j = i;
+            while (j > 0 && before(p, proxies[j - 1])) {
+                proxies[j] = proxies[j - 1];
+                --j;
+            }
+            proxies[j] = p;
+        }
+    }
+
+    sweep->minX.resize(count + kSweepPadding);
+    sweep->minY.resize(count + kSweepPadding);
+    sweep->maxX.resize(count + kSweepPadding);
+    sweep->maxY.resize(count + kSweepPadding);
+    float maxWidth = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const AABB& b = nodes[proxies[i]].aabb;
+        sweep->minX[i] = b.minX;
+        sweep->minY[i] = b.minY;
+        sweep->maxX[i] = b.maxX;
+        sweep->maxY[i] = b.maxY;
+        maxWidth = std::max(maxWidth, b.maxX - b.minX);
+        sweep->slot[proxies[i]] = (int32_t)i;
+    }
+    for (size_t i = count; i < count + kSweepPadding; ++i) {
+        sweep->minX[i] = sweep->minY[i] = INFINITY;
+        sweep->maxX[i] = sweep->maxY[i] = -INFINITY;
+    }
+    sweep->maxWidth = maxWidth;
+    sweep->changes = 0;
+    sweep->dirty = false;
+}
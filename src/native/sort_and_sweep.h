@@ -0,0 +1,94 @@
+#ifndef FLASH_SORT_AND_SWEEP_H
+#define FLASH_SORT_AND_SWEEP_H
+
+// Sort and sweep on the x axis: the BROADPHASE_SORT_AND_SWEEP backend of a
+// DynamicTree.
+//
+// The leaves are kept sorted by the left edge of their fat AABB, with their
+// bounds copied out into flat arrays. A query finds where its box starts by
+// binary search, backs up by the widest leaf, and scans forward until the
+// leaves start right of it, testing four at a time with SSE or NEON. There is
+// nothing to rebalance: a move out of a fat AABB only marks the order stale,
+// and the next query re-sorts, which for bodies that moved a little is one
+// insertion-sort pass. It suits bodies of similar size spread along x; one
+// very wide leaf widens every scan.
+//
+// The leaves stay in the DynamicTree's node pool, so proxy IDs, the move
+// buffer and the pair set work as they do for the tree.
+
+#include "broadphase.h"
+#include "simd.h"
+#include <algorithm>
+#include <vector>
+
+struct SortAndSweep {
+    // Leaves in order of minX, then proxy ID, once sweep_prepare has run.
+    std::vector<int32_t> proxies;
+    // Their bounds, parallel to `proxies` and followed by kSweepPadding
+    // entries that overlap nothing, so a 4-wide load never runs off the end.
+    std::vector<float> minX, minY, maxX, maxY;
+    // Each proxy's index in `proxies`, by proxy ID; -1 if it has none.
+    std::vector<int32_t> slot;
+    float maxWidth;  // widest leaf, how far a scan backs up
+    int32_t changes; // inserts and removals since the last sort
+    bool dirty;      // order or bounds stale
+};
+
+constexpr int kSweepPadding = 4;
+
+SortAndSweep* create_sort_and_sweep();
+void destroy_sort_and_sweep(SortAndSweep* sweep);
+
+void sweep_insert(SortAndSweep* sweep, int32_t proxy);
+void sweep_remove(SortAndSweep* sweep, int32_t proxy);
+
+// Re-sorts and refreshes the bounds if anything changed since the last
+// call. Queries call it themselves; call it first when queries will run on
+// several threads.
+void sweep_prepare(SortAndSweep* sweep, const TreeNode* nodes);
+
+// Bit i set when entry i of the four from `index` overlaps `box`; the same
+// test as AABB::overlaps.
+inline uint32_t sweep_overlap4(const SortAndSweep* sweep, size_t index, const AABB& box) {
+#if defined(FLASH_SIMD_SSE2)
+    __m128 m = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&sweep->minX[index]), _mm_set1_ps(box.maxX)),
+                          _mm_cmpge_ps(_mm_loadu_ps(&sweep->maxX[index]), _mm_set1_ps(box.minX)));
+    m = _mm_and_ps(m, _mm_cmple_ps(_mm_loadu_ps(&sweep->minY[index]), _mm_set1_ps(box.maxY)));
+    m = _mm_and_ps(m, _mm_cmpge_ps(_mm_loadu_ps(&sweep->maxY[index]), _mm_set1_ps(box.minY)));
+    return (uint32_t)_mm_movemask_ps(m);
+#elif defined(FLASH_SIMD_NEON)
+    uint32x4_t m = vandq_u32(vcleq_f32(vld1q_f32(&sweep->minX[index]), vdupq_n_f32(box.maxX)),
+                             vcgeq_f32(vld1q_f32(&sweep->maxX[index]), vdupq_n_f32(box.minX)));
+    m = vandq_u32(m, vcleq_f32(vld1q_f32(&sweep->minY[index]), vdupq_n_f32(box.maxY)));
+    m = vandq_u32(m, vcgeq_f32(vld1q_f32(&sweep->maxY[index]), vdupq_n_f32(box.minY)));
+    return neon_movemask(m);
+#else
+    uint32_t mask = 0;
+    for (int k = 0; k < 4; ++k) {
+        const size_t i = index + k;
+        if (sweep->minX[i] <= box.maxX && sweep->maxX[i] >= box.minX &&
+            sweep->minY[i] <= box.maxY && sweep->maxY[i] >= box.minY) {
+            mask |= 1u << k;
+        }
+    }
+    return mask;
+#endif
+}
+
+// Leaves whose fat AABB overlaps `box`, each passed to `visit` once.
+template <typename Visit>
+void sweep_query(SortAndSweep* sweep, const TreeNode* nodes, const AABB& box, Visit&& visit) {
+    sweep_prepare(sweep, nodes);
+    const size_t count = sweep->proxies.size();
+    const float* minX = sweep->minX.data();
+    size_t i = std::lower_bound(minX, minX + count, box.minX - sweep->maxWidth) - minX;
+    for (; i < count && minX[i] <= box.maxX; i += 4) {
+        const uint32_t mask = sweep_overlap4(sweep, i, box);
+        if (mask == 0) continue;
+        for (int k = 0; k < 4; ++k) {
+            if (mask & (1u << k)) visit(nodes[sweep->proxies[i + k]]);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,69 @@
+#include "spatial_grid.h"
+
+namespace {
+
+void set_cell_size(SpatialGrid* grid, float cellSize) {
+    grid->cellSize = cellSize > 0.0f ? cellSize : kGridDefaultCellSize;
+    grid->invCellSize = 1.0f / grid->cellSize;
+}
+
+void erase_entry(std::vector<GridEntry>& bucket, int32_t proxy, int32_t x, int32_t y) {
+    for (size_t i = 0; i < bucket.size(); ++i) {
+        if (bucket[i].proxy == proxy && bucket[i].cellX == x && bucket[i].cellY == y) {
+            bucket[i] = bucket.back();
+            bucket.pop_back();
+            return;
+        }
+    }
+}
+
+} // namespace
+
+SpatialGrid* create_spatial_grid(int capacity, float cellSize) {
+    SpatialGrid* grid = new SpatialGrid();
+    uint32_t buckets = 64;
+    while (buckets < (uint32_t)capacity) buckets *= 2;
+    grid->buckets.resize(buckets);
+    grid->bucketMask = buckets - 1;
+    set_cell_size(grid, cellSize);
+    return grid;
+}
+
+void destroy_spatial_grid(SpatialGrid* grid) {
+    delete grid;
+}
+
+void grid_insert(SpatialGrid* grid, int32_t proxy, const AABB& aabb) {
+    const GridRange r = grid_range(grid, aabb);
+    if (r.cellCount() > kGridMaxCells) {
+        grid->large.push_back(proxy);
+        return;
+    }
+    for (int32_t y = r.y0; y <= r.y1; ++y) {
+        for (int32_t x = r.x0; x <= r.x1; ++x) {
+            grid->buckets[grid_bucket(grid, x, y)].push_back(GridEntry{proxy, x, y});
+        }
+    }
+}
+
+void grid_remove(SpatialGrid* grid, int32_t proxy, const AABB& aabb) {
+    const GridRange r = grid_range(grid, aabb);
+    if (r.cellCount() > kGridMaxCells) {
+        std::vector<int32_t>& large = grid->large;
+        const auto it = std::find(large.begin(), large.end(), proxy);
+        if (it != large.end()) large.erase(it);
+        return;
+    }
+    for (int32_t y = r.y0; y <= r.y1; ++y) {
+        for (int32_t x = r.x0; x <= r.x1; ++x) {
+            erase_entry(grid->buckets[grid_bucket(grid, x, y)], proxy, x, y);
+        }
+    }
+}
+
+void grid_rebuild(SpatialGrid* grid, const TreeNode* nodes, const int32_t* proxies, int count, float cellSize) {
+    for (std::vector<GridEntry>& bucket : grid->buckets) bucket.clear();
+    grid->large.clear();
+    set_cell_size(grid, cellSize);
+    for (int i = 0; i < count; ++i) grid_insert(grid, proxies[i], nodes[proxies[i]].aabb);
+}
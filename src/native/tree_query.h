@@ -0,0 +1,206 @@
+#ifndef FLASH_TREE_QUERY_H
+#define FLASH_TREE_QUERY_H
+
+// Spatial queries of a broadphase: the leaves a box overlaps, or a segment
+// crosses, each passed to a visitor as the walk finds it.
+//
+// The tree existed only to build the pair list; everything else that needed
+// a spatial lookup — raycasts, soft body contacts — walked all bodies. The
+// queries that replaced that walk, tree_query_aabb and tree_query_ray, filled
+// a caller's fixed array from a fixed stack: a ray across a dense scene, or
+// a soft body over a pile, lost whatever did not fit, and a tree deeper than
+// the stack lost whole subtrees, without a word. These have no output to
+// fill, and their TreeStack spills to the heap rather than dropping entries.
+// A visitor can stop the query, and a ray's can clip the ray, so a
+// closest-hit query stops opening subtrees past the nearest hit it has.
+//
+// Visitors must not change the tree they are called from.
+//
+// A tree answers from its wide copy once it has been queried enough since it
+// last changed (see kWideBuildWork). Leaves come out in the same order
+// either way, on every backend the same order the array queries wrote them.
+
+#include "broadphase.h"
+#include "sort_and_sweep.h"
+#include "spatial_grid.h"
+#include "wide_tree.h"
+#include <algorithm>
+
+// A segment from (x0, y0) to (x1, y1), of which tree_raycast only looks at
+// the part up to maxFraction.
+struct TreeRay {
+    float x0, y0;
+    float x1, y1;
+    float maxFraction;
+};
+
+// The tree's wide copy brought up to date, or null while it is not yet worth
+// rebuilding; see kWideBuildWork.
+inline const WideTree* tree_current_wide(DynamicTree* tree) {
+    WideTree* wide = tree->wide;
+    if (!wide) return nullptr;
+    if (wide->stale) {
+        if (wide->work < kWideBuildWork * tree->nodeCount) return nullptr;
+        wide_build(wide, tree);
+    } else if (wide->refit) {
+        wide_refit(wide, tree);
+    }
+    return wide;
+}
+
+// Slab test of the segment from (x0, y0) with reciprocal direction
+// (invDx, invDy) against `b`. The segment is bounded: anything the ray only
+// reaches past maxFraction, or entirely behind its start, misses.
+inline bool segment_overlaps(const AABB& b, float x0, float y0, float invDx, float invDy, float maxFraction) {
+    const float tx1 = (b.minX - x0) * invDx;
+    const float tx2 = (b.maxX - x0) * invDx;
+    const float ty1 = (b.minY - y0) * invDy;
+    const float ty2 = (b.maxY - y0) * invDy;
+
+    const float tMin = std::max(std::min(tx1, tx2), std::min(ty1, ty2));
+    const float tMax = std::min(std::max(tx1, tx2), std::max(ty1, ty2));
+    return !(tMax < 0.0f || tMin > tMax || tMin > maxFraction);
+}
+
+// Passes `visit(bodyId)` each body whose fat AABB overlaps `box` and whose
+// categoryBits share a bit with `maskBits`, until it returns false. With
+// kQueryAllCategories every body is reported; otherwise a subtree none of
+// whose leaves is in those categories is skipped whole.
+template <typename Visit>
+void tree_query(DynamicTree* tree, const AABB& box, Visit&& visit, uint32_t maskBits = kQueryAllCategories) {
+    if (!tree) return;
+    const bool allCategories = maskBits == kQueryAllCategories;
+
+    if (tree->grid || tree->sweep) {
+        // Their walks cannot be cut short; once stopped, they report nothing.
+        bool stopped = false;
+        auto report = [&](const TreeNode& node) {
+            if (stopped || (!allCategories && (node.categoryBits & maskBits) == 0)) return;
+            stopped = !visit(node.bodyId);
+        };
+        if (tree->grid) grid_query(tree->grid, tree->nodes, box, report);
+        else sweep_query(tree->sweep, tree->nodes, box, report);
+        return;
+    }
+    if (tree->root == -1) return;
+
+    if (const WideTree* wide = tree_current_wide(tree)) {
+        wide_walk(wide,
+                  [&](const WideNode& node) {
+                      const uint32_t hits = wide_overlap4(node, box);
+                      return allCategories ? hits : hits & wide_categories4(node, maskBits);
+                  },
+                  [&](int32_t proxy) { return visit(tree->nodes[proxy].bodyId); });
+        return;
+    }
+
+    TreeStack stack;
+    stack.push(tree->root);
+    int64_t visited = 0;
+    while (!stack.empty()) {
+        const TreeNode& node = tree->nodes[stack.pop()];
+        visited++;
+        if (!allCategories && (node.categoryBits & maskBits) == 0) continue;
+        if (!node.aabb.overlaps(box)) continue;
+
+        if (node.isLeaf()) {
+            if (!visit(node.bodyId)) break;
+        } else {
+            stack.push(node.left);
+            stack.push(node.right);
+        }
+    }
+    if (tree->wide) tree->wide->work += visited;
+}
+
+// Passes `visit(bodyId)` each body, filtered as in tree_query, whose fat
+// AABB `ray` passes through before its maxFraction. Broad phase only: the
+// visitor runs the exact shape test. What it returns steers the rest of the
+// query, as in Box2D's b2DynamicTree_RayCast: 0 stops it, a fraction below
+// the ray's current end clips the ray there, so nothing reached only past a
+// hit is visited, and anything else (1, or -1) goes on unchanged.
+template <typename Visit>
+void tree_raycast(DynamicTree* tree, const TreeRay& ray, Visit&& visit, uint32_t maskBits = kQueryAllCategories) {
+    if (!tree || !(ray.maxFraction > 0.0f)) return;
+    const bool allCategories = maskBits == kQueryAllCategories;
+
+    const float x0 = ray.x0, y0 = ray.y0;
+    const float dx = ray.x1 - x0;
+    const float dy = ray.y1 - y0;
+
+    // Slab test, reciprocal precomputed. A zero component gives an infinite
+    // reciprocal, and the IEEE comparisons below then behave correctly for a
+    // ray running exactly parallel to that axis — except when the origin sits
+    // on the slab boundary, where 0 * inf is NaN. Nudging the reciprocal to a
+    // very large finite value avoids that without a branch in the loop.
+    const float invDx = (dx != 0.0f) ? 1.0f / dx : 1e30f;
+    const float invDy = (dy != 0.0f) ? 1.0f / dy : 1e30f;
+
+    float maxFraction = ray.maxFraction;
+    // Visits a leaf the segment reaches and applies the answer; false once
+    // the query is to stop.
+    auto report = [&](const TreeNode& node) {
+        const float value = visit(node.bodyId);
+        if (value == 0.0f) return false;
+        if (value > 0.0f && value < maxFraction) maxFraction = value;
+        return true;
+    };
+
+    if (tree->grid || tree->sweep) {
+        bool stopped = false;
+        auto test = [&](const TreeNode& node) {
+            if (stopped || (!allCategories && (node.categoryBits & maskBits) == 0)) return;
+            if (!segment_overlaps(node.aabb, x0, y0, invDx, invDy, maxFraction)) return;
+            stopped = !report(node);
+        };
+        // The end as given when the ray is whole: x0 + dx can round away
+        // from x1, and with it the grid cell the walk ends in.
+        const float x1 = maxFraction < 1.0f ? x0 + dx * maxFraction : ray.x1;
+        const float y1 = maxFraction < 1.0f ? y0 + dy * maxFraction : ray.y1;
+        if (tree->grid) {
+            grid_raycast(tree->grid, tree->nodes, x0, y0, x1, y1, test);
+        } else {
+            const AABB bounds{std::min(x0, x1), std::min(y0, y1), std::max(x0, x1), std::max(y0, y1)};
+            sweep_query(tree->sweep, tree->nodes, bounds, test);
+        }
+        return;
+    }
+    if (tree->root == -1) return;
+
+    if (const WideTree* wide = tree_current_wide(tree)) {
+        wide_walk(wide,
+                  [&](const WideNode& node) {
+                      const uint32_t hits = wide_segment4(node, x0, y0, invDx, invDy, maxFraction);
+                      return allCategories ? hits : hits & wide_categories4(node, maskBits);
+                  },
+                  [&](int32_t proxy) {
+                      // Tested when its parent was, maybe before the ray
+                      // was last clipped; the tree's own walk would test it
+                      // now.
+                      const TreeNode& leaf = tree->nodes[proxy];
+                      if (!segment_overlaps(leaf.aabb, x0, y0, invDx, invDy, maxFraction)) return true;
+                      return report(leaf);
+                  });
+        return;
+    }
+
+    TreeStack stack;
+    stack.push(tree->root);
+    int64_t visited = 0;
+    while (!stack.empty()) {
+        const TreeNode& node = tree->nodes[stack.pop()];
+        visited++;
+        if (!allCategories && (node.categoryBits & maskBits) == 0) continue;
+        if (!segment_overlaps(node.aabb, x0, y0, invDx, invDy, maxFraction)) continue;
+
+        if (node.isLeaf()) {
+            if (!report(node)) break;
+        } else {
+            stack.push(node.left);
+            stack.push(node.right);
+        }
+    }
+    if (tree->wide) tree->wide->work += visited;
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include "wide_tree.h"
+
+namespace {
+
+// Appends the wide node for the subtree under tree node `index`, and those
+// below it, returning its index.
+int32_t build_node(WideTree* wide, const DynamicTree* tree, int32_t index) {
+    // Open the largest child until there are four, keeping left-to-right
+    // order: a large box is the one most worth testing past.
+    int32_t slots[4];
+    float area[4]; // perimeter of an internal slot, -1 for a leaf
+    int count = 0;
+    auto place = [&](int k, int32_t slot) {
+        const TreeNode& node = tree->nodes[slot];
+        slots[k] = slot;
+        area[k] = node.isLeaf() ? -1.0f : node.aabb.perimeter();
+    };
+    const TreeNode& top = tree->nodes[index];
+    if (top.isLeaf()) {
+        place(count++, index);
+    } else {
+        place(count++, top.left);
+        place(count++, top.right);
+    }
+    while (count < 4) {
+        int open = 0;
+        for (int k = 1; k < count; ++k) {
+            if (area[k] > area[open]) open = k;
+        }
+        if (area[open] < 0.0f) break;
+        const TreeNode& node = tree->nodes[slots[open]];
+        for (int k = count; k > open + 1; --k) {
+            slots[k] = slots[k - 1];
+            area[k] = area[k - 1];
+        }
+        place(open, node.left);
+        place(open + 1, node.right);
+        count++;
+    }
+
+    const int32_t wideIndex = (int32_t)wide->nodes.size();
+    wide->nodes.emplace_back();
+    wide->sources.insert(wide->sources.end(), 4, -1);
+    WideNode& node = wide->nodes[wideIndex];
+    node.count = count;
+    for (int k = 0; k < 4; ++k) {
+        node.minX[k] = node.minY[k] = INFINITY;
+        node.maxX[k] = node.maxY[k] = -INFINITY;
+        node.child[k] = -1;
+        node.categoryBits[k] = 0;
+    }
+    for (int k = 0; k < count; ++k) {
+        const AABB& b = tree->nodes[slots[k]].aabb;
+        node.minX[k] = b.minX;
+        node.minY[k] = b.minY;
+        node.maxX[k] = b.maxX;
+        node.maxY[k] = b.maxY;
+        node.categoryBits[k] = tree->nodes[slots[k]].categoryBits;
+        wide->sources[wideIndex * 4 + k] = slots[k];
+    }
+    // Children after the node's own entry; `node` may move as they go in.
+    for (int k = 0; k < count; ++k) {
+        const int32_t child = tree->nodes[slots[k]].isLeaf() ? (kWideLeaf | slots[k])
+                                                            : build_node(wide, tree, slots[k]);
+        wide->nodes[wideIndex].child[k] = child;
+    }
+    return wideIndex;
+}
+
+} // namespace
+
+WideTree* create_wide_tree() {
+    WideTree* wide = new WideTree();
+    wide->stale = true;
+    wide->refit = false;
+    wide->work = 0;
+    return wide;
+}
+
+void destroy_wide_tree(WideTree* wide) {
+    delete wide;
+}
+
+void wide_build(WideTree* wide, const DynamicTree* tree) {
+    wide->nodes.clear();
+    wide->sources.clear();
+    // A full 4-ary tree over n leaves has about n / 3 nodes.
+    wide->nodes.reserve(tree->nodeCount / 4 + 1);
+    wide->sources.reserve((tree->nodeCount / 4 + 1) * 4);
+    if (tree->root != -1) build_node(wide, tree, tree->root);
+    wide->stale = false;
+    wide->refit = false;
+    wide->work = 0;
+}
+
+void wide_refit(WideTree* wide, const DynamicTree* tree) {
+    for (size_t i = 0; i < wide->nodes.size(); ++i) {
+        WideNode& node = wide->nodes[i];
+        for (int k = 0; k < node.count; ++k) {
+            const TreeNode& source = tree->nodes[wide->sources[i * 4 + k]];
+            node.minX[k] = source.aabb.minX;
+            node.minY[k] = source.aabb.minY;
+            node.maxX[k] = source.aabb.maxX;
+            node.maxY[k] = source.aabb.maxY;
+            node.categoryBits[k] = source.categoryBits;
+        }
+    }
+    wide->refit = false;
+}
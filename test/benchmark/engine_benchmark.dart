@@ -40,6 +40,39 @@ void main() {
     print('\n=== $title ===\n${engine.profiler.report()}');
   }
 
+  /// Bullet hell: two thousand small bodies flying around a walled arena with
+  /// no gravity, every one of them moving every step. Warmed up 30 steps.
+  /// With [layers] above 1 the bodies are split between that many collision
+  /// layers that only meet the walls and themselves.
+  FPhysicsSystem arena(FBroadphase broadphase, {int layers = 1}) {
+    final physics = FPhysicsSystem(gravity: v.Vector2.zero(), broadphase: broadphase);
+    final random = Random(7);
+    const half = 1000.0;
+    for (final wall in [
+      [0.0, -half, 2 * half, 40.0],
+      [0.0, half, 2 * half, 40.0],
+      [-half, 0.0, 40.0, 2 * half],
+      [half, 0.0, 40.0, 2 * half],
+    ]) {
+      FPhysicsSystem.createBody(
+          physics.world, FPhysics.staticBody, FPhysics.box, wall[0], wall[1], wall[2], wall[3], 0, 0x0001, 0xFFFF);
+    }
+    for (int i = 0; i < 2000; i++) {
+      final category = layers == 1 ? 0x0001 : 0x0002 << (i % layers);
+      final id = FPhysicsSystem.createBody(
+        physics.world, FPhysics.dynamicBody, i.isEven ? FPhysics.circle : FPhysics.box,
+        random.nextDouble() * 1900 - 950, random.nextDouble() * 1900 - 950,
+        12, 12, 0, category, layers == 1 ? 0xFFFF : category | 0x0001,
+      );
+      FPhysicsSystem.setBodyVelocity(
+          physics.world, id, random.nextDouble() * 400 - 200, random.nextDouble() * 400 - 200);
+    }
+    for (int i = 0; i < 30; i++) {
+      physics.update(1 / 60);
+    }
+    return physics;
+  }
+
   group('Baseline', () {
     test('empty scene', () {
       final engine = FEngine()..profiler.enabled = true;
@@ -161,33 +194,45 @@ void main() {
     });
 
     test('300 boxes stacking', () {
-      // Box-box pairs are the expensive narrow-phase case: SAT with per-corner
-      // projection. The mixed scenario above is half circles, which take a
-      // much cheaper path, so it understates the cost of detectBoxBox.
-      final engine = FEngine()..profiler.enabled = true;
-      addTearDown(engine.dispose);
-      engine.viewportSize.setValues(1200, 800);
-
-      final world = FPhysicsSystem(gravity: v.Vector2(0, -980));
-      addTearDown(world.dispose);
-      engine.physicsWorld = world;
-
-      engine.scene.addChild(
-        FPhysicsBody(
-          world: world.world,
-          type: FPhysics.staticBody,
-          shapeType: FPhysics.box,
-          x: 0,
-          y: -400,
-          width: 3000,
-          height: 60,
-        ),
-      );
+      // Box-box pairs are the expensive narrow-phase case: SAT and clipping
+      // of the incident face. The mixed scenario above is half circles,
+      // which take a much cheaper path, so it understates that cost.
+      //
+      // Run under both contact solvers, and the soft step again at half its
+      // substeps: how few a pile needs to come to rest is what its contact
+      // points are worth. Cost alone would flatter whichever run gives up
+      // first, so each also reports how the pile ended up: bodies that sank
+      // through the ground, the fastest body still moving, and how many are
+      // still awake.
+      for (final (mode, subSteps) in [
+        (FSolverMode.ngs, 4),
+        (FSolverMode.softStep, 4),
+        (FSolverMode.softStep, 2),
+      ]) {
+        final engine = FEngine()..profiler.enabled = true;
+        addTearDown(engine.dispose);
+        engine.viewportSize.setValues(1200, 800);
+
+        final world = FPhysicsSystem(gravity: v.Vector2(0, -980), solverMode: mode)..subStepCount = subSteps;
+        addTearDown(world.dispose);
+        engine.physicsWorld = world;
 
-      final rnd = Random(23);
-      for (int i = 0; i < 300; i++) {
         engine.scene.addChild(
           FPhysicsBody(
+            world: world.world,
+            type: FPhysics.staticBody,
+            shapeType: FPhysics.box,
+            x: 0,
+            y: -400,
+            width: 3000,
+            height: 60,
+          ),
+        );
+
+        final rnd = Random(23);
+        final boxes = <FPhysicsBody>[];
+        for (int i = 0; i < 300; i++) {
+          final box = FPhysicsBody(
             world: world.world,
             type: FPhysics.dynamicBody,
             shapeType: FPhysics.box,
@@ -196,12 +241,137 @@ void main() {
             width: 30,
             height: 30,
             rotation: rnd.nextDouble() * 0.2,
-          ),
+          );
+          boxes.add(box);
+          engine.scene.addChild(box);
+        }
+
+        run(engine, 400);
+        report(
+          '300 boxes stacking (${mode.name}'
+          '${mode == FSolverMode.softStep ? ', $subSteps substeps' : ''})',
+          engine,
         );
+
+        var sunk = 0, awake = 0;
+        var maxSpeed = 0.0;
+        for (final box in boxes) {
+          final b = (world.world.ref.bodies + box.bodyId).ref;
+          // The ground's top face is at y = -370; a resting box centre sits
+          // 15 above it.
+          if (b.y < -370) sunk++;
+          if (b.isAwake != 0) awake++;
+          maxSpeed = max(maxSpeed, sqrt(b.vx * b.vx + b.vy * b.vy));
+        }
+        // ignore: avoid_print
+        print('  stability: $sunk sunk through the ground, '
+            'fastest ${maxSpeed.toStringAsFixed(1)} units/s, $awake/300 awake');
       }
+    });
 
-      run(engine, 400);
-      report('300 boxes stacking', engine);
+    test('contact solver threading', () {
+      // Same 500-body scene as above, physics only, down each solver path.
+      // Graph coloring pays a pool dispatch per color per iteration, so what
+      // it measures is whether a color carries enough work to cover that.
+      // Island mode pays one dispatch per pass, but a pile is one task.
+      // Colored runs again with the wide contact solver off, to show what
+      // solving four contacts at a time saves.
+      // ignore: avoid_print
+      print('\n=== contact solver (pool concurrency: ${native.particlePoolConcurrency()}) ===');
+      // ignore: avoid_print
+      print('  ${'bodies'.padLeft(8)}${'serial ms'.padLeft(12)}${'colored ms'.padLeft(13)}'
+          '${'scalar ms'.padLeft(12)}${'islands ms'.padLeft(13)}');
+
+      double measure(int bodyCount, FSolverThreading threading, {bool wide = true}) {
+        final world = FPhysicsSystem(gravity: v.Vector2(0, -980), solverThreading: threading);
+        native.setWideContactSolver(world.world, wide ? 1 : 0);
+        FPhysicsSystem.createBody(world.world, FPhysics.staticBody, FPhysics.box, 0, -600, 6000, 60, 0, 0x0001, 0xFFFF);
+        final rnd = Random(11);
+        for (int i = 0; i < bodyCount; i++) {
+          FPhysicsSystem.createBody(
+            world.world,
+            FPhysics.dynamicBody,
+            i.isEven ? FPhysics.circle : FPhysics.box,
+            (rnd.nextDouble() - 0.5) * 2000,
+            rnd.nextDouble() * 2000,
+            24,
+            24,
+            0,
+            0x0001,
+            0xFFFF,
+          );
+        }
+        // Settle into contact first; the piled-up regime is the expensive one.
+        for (int i = 0; i < 400; i++) {
+          world.update(1 / 60);
+        }
+        const frames = 200;
+        final sw = Stopwatch()..start();
+        for (int i = 0; i < frames; i++) {
+          world.update(1 / 60);
+        }
+        sw.stop();
+        world.dispose();
+        return sw.elapsedMicroseconds / frames / 1000;
+      }
+
+      for (final count in [250, 500, 1000, 2000]) {
+        final s = measure(count, FSolverThreading.serial);
+        final c = measure(count, FSolverThreading.graphColored);
+        final c1 = measure(count, FSolverThreading.graphColored, wide: false);
+        final i = measure(count, FSolverThreading.islands);
+        // ignore: avoid_print
+        print('  ${count.toString().padLeft(8)}${s.toStringAsFixed(3).padLeft(12)}'
+            '${c.toStringAsFixed(3).padLeft(13)}${c1.toStringAsFixed(3).padLeft(12)}${i.toStringAsFixed(3).padLeft(13)}');
+      }
+    });
+
+    test('settled pile sleeps', () {
+      // A level's worth of debris that has come to rest. With per-body sleep
+      // the static ground kept every body it touched awake, so this cost as
+      // much as the first frame; with island sleep it should cost next to
+      // nothing.
+      final world = FPhysicsSystem(gravity: v.Vector2(0, -980));
+      FPhysicsSystem.createBody(world.world, FPhysics.staticBody, FPhysics.box, 0, -300, 8000, 60, 0, 0x0001, 0xFFFF);
+      for (int i = 0; i < 300; i++) {
+        FPhysicsSystem.createBody(
+          world.world,
+          FPhysics.dynamicBody,
+          i.isEven ? FPhysics.circle : FPhysics.box,
+          -3900 + i * 26.0,
+          -260,
+          20,
+          20,
+          0,
+          0x0001,
+          0xFFFF,
+        );
+      }
+
+      double frameMs() {
+        const frames = 60;
+        final sw = Stopwatch()..start();
+        for (int i = 0; i < frames; i++) {
+          world.update(1 / 60);
+        }
+        sw.stop();
+        return sw.elapsedMicroseconds / frames / 1000;
+      }
+
+      final first = frameMs();
+      for (int i = 0; i < 240; i++) {
+        world.update(1 / 60);
+      }
+      final settled = frameMs();
+      var awake = 0;
+      for (int id = 1; id <= 300; id++) {
+        if (FPhysicsSystem.isAwake(world.world, id)) awake++;
+      }
+      world.dispose();
+      // ignore: avoid_print
+      print('\n=== settled pile: 300 bodies ===\n'
+          '  first second ${first.toStringAsFixed(3)} ms/frame, '
+          'settled ${settled.toStringAsFixed(3)} ms/frame, $awake awake');
     });
 
     test('100k particles', () {
@@ -325,6 +495,111 @@ void main() {
       }
     });
 
+    test('broadphase backends', () {
+      // The same bullet-hell scene on each broadphase.
+      // ignore: avoid_print
+      print('\n=== broadphase backends (2000 moving bodies) ===');
+      // ignore: avoid_print
+      print('  ${'backend'.padRight(14)}${'step ms'.padLeft(10)}${'raycast us'.padLeft(13)}');
+
+      for (final broadphase in FBroadphase.values) {
+        final physics = arena(broadphase);
+        final stepWatch = Stopwatch()..start();
+        const frames = 200;
+        for (int i = 0; i < frames; i++) {
+          physics.update(1 / 60);
+        }
+        stepWatch.stop();
+
+        final rayWatch = Stopwatch()..start();
+        const rays = 2000;
+        for (int i = 0; i < rays; i++) {
+          final y = (i % 100) * 19.0 - 950;
+          FPhysicsSystem.rayCast(physics.world, -950, y, 950, -y);
+        }
+        rayWatch.stop();
+
+        // ignore: avoid_print
+        print('  ${broadphase.name.padRight(14)}'
+            '${(stepWatch.elapsedMicroseconds / frames / 1000).toStringAsFixed(3).padLeft(10)}'
+            '${(rayWatch.elapsedMicroseconds / rays).toStringAsFixed(2).padLeft(13)}');
+
+        physics.dispose();
+      }
+    });
+
+    test('parallel pair finding', () {
+      // With every body moving, hundreds leave their fat AABB each step and
+      // are queried for pairs: the case the pool split is for. The
+      // threshold is forced both ways on the same scene; the pair count
+      // must match.
+      // ignore: avoid_print
+      print('\n=== pair finding, serial vs pool (2000 moving bodies, ${native.particlePoolConcurrency()} threads) ===');
+      // ignore: avoid_print
+      print('  ${'backend'.padRight(14)}${'serial ms'.padLeft(11)}${'pool ms'.padLeft(10)}${'pairs'.padLeft(8)}');
+
+      for (final broadphase in FBroadphase.values) {
+        double run(int threshold, List<int> pairCounts) {
+          final physics = arena(broadphase);
+          native.setPairParallelThreshold(physics.world, threshold);
+          final sw = Stopwatch()..start();
+          for (int i = 0; i < 200; i++) {
+            physics.update(1 / 60);
+          }
+          sw.stop();
+          pairCounts.add(physics.broadphaseStats.pairCount);
+          physics.dispose();
+          return sw.elapsedMicroseconds / 200 / 1000;
+        }
+
+        final pairCounts = <int>[];
+        final serial = run(1 << 30, pairCounts);
+        final pooled = run(0, pairCounts);
+        expect(pairCounts[1], pairCounts[0]);
+
+        // ignore: avoid_print
+        print('  ${broadphase.name.padRight(14)}${serial.toStringAsFixed(3).padLeft(11)}'
+            '${pooled.toStringAsFixed(3).padLeft(10)}${pairCounts[0].toString().padLeft(8)}');
+      }
+    });
+
+    test('collision layers', () {
+      // The same arena with its bodies in one layer, then split between
+      // layers that ignore each other. Pair queries skip the subtrees of the
+      // other layers, so the pairs, and the time, should drop with them.
+      // ignore: avoid_print
+      print('\n=== collision layers (2000 moving bodies, tree) ===');
+      // ignore: avoid_print
+      print('  ${'layers'.padLeft(8)}${'step ms'.padLeft(10)}${'pairs'.padLeft(8)}${'raycast us'.padLeft(13)}');
+
+      for (final layers in [1, 3, 6]) {
+        final physics = arena(FBroadphase.tree, layers: layers);
+        final stepWatch = Stopwatch()..start();
+        const frames = 200;
+        for (int i = 0; i < frames; i++) {
+          physics.update(1 / 60);
+        }
+        stepWatch.stop();
+
+        // Rays that only want the first layer.
+        final rayWatch = Stopwatch()..start();
+        const rays = 2000;
+        for (int i = 0; i < rays; i++) {
+          final y = (i % 100) * 19.0 - 950;
+          FPhysicsSystem.rayCast(physics.world, -950, y, 950, -y, maskBits: layers == 1 ? 0x0001 : 0x0002);
+        }
+        rayWatch.stop();
+
+        // ignore: avoid_print
+        print('  ${layers.toString().padLeft(8)}'
+            '${(stepWatch.elapsedMicroseconds / frames / 1000).toStringAsFixed(3).padLeft(10)}'
+            '${physics.broadphaseStats.pairCount.toString().padLeft(8)}'
+            '${(rayWatch.elapsedMicroseconds / rays).toStringAsFixed(2).padLeft(13)}');
+
+        physics.dispose();
+      }
+    });
+
     test('serial vs parallel crossover', () {
         // ignore: avoid_print
       print('\n  ${'count'.padLeft(8)}${'serial'.padLeft(10)}${'parallel'.padLeft(10)}${'ratio'.padLeft(9)}');
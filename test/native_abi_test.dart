@@ -14,7 +14,7 @@ import 'package:flash/src/core/native/flash_native_bindings.dart';
 ///
 /// `PhysicsWorld` is the sharpest edge. The Dart mirror deliberately stops
 /// after `activeSoftBodies` and omits the trailing `tree`, `boxJoints`,
-/// `maxBoxJoints`, `activeBoxJoints` and `warmStartCache` fields, which is
+/// `maxBoxJoints`, `activeBoxJoints` and `contactTable` fields, which is
 /// safe *only* because they sit at the end. Insert a field in the middle of
 /// the C++ struct and every Dart read past that point is wrong. The offset
 /// checks below are what make that loud.
@@ -29,6 +29,12 @@ void main() {
   const structNativeBody = 6;
   const structRayCastHit = 7;
   const structJointDef = 8;
+  const structContactEvent = 9;
+  const structBodyPose = 10;
+  const structBodyState = 11;
+  const structBodyDef = 12;
+  const structBroadphaseStats = 13;
+  const structManifoldPoint = 14;
 
   // Keep in sync with FlashFieldId in src/native/abi_probe.cpp.
   const fieldBodyX = 0;
@@ -49,6 +55,9 @@ void main() {
   const fieldEmitterActiveCount = 15;
   const fieldEmitterShapeType = 16;
   const fieldRayHit = 17;
+  const fieldContactEventApproachSpeed = 18;
+  const fieldBodyIsBullet = 19;
+  const fieldBodyQ = 20;
 
   setUpAll(() {
     expect(
@@ -81,6 +90,12 @@ void main() {
     checkSize('NativeBody', structNativeBody, sizeOf<NativeBody>());
     checkSize('RayCastHit', structRayCastHit, sizeOf<RayCastHit>());
     checkSize('JointDef', structJointDef, sizeOf<JointDef>());
+    checkSize('ContactEvent', structContactEvent, sizeOf<ContactEvent>());
+    checkSize('BodyPose', structBodyPose, sizeOf<BodyPose>());
+    checkSize('BodyState', structBodyState, sizeOf<BodyState>());
+    checkSize('BodyDef', structBodyDef, sizeOf<BodyDef>());
+    checkSize('BroadphaseStats', structBroadphaseStats, sizeOf<BroadphaseStats>());
+    checkSize('ManifoldPoint', structManifoldPoint, sizeOf<ManifoldPoint>());
   });
 
   test('PhysicsWorld Dart mirror is a prefix of the C++ struct', () {
@@ -100,9 +115,13 @@ void main() {
       expect(getFieldOffset(fieldBodyX), 12);
       // rotation follows x and y
       expect(getFieldOffset(fieldBodyRotation), getFieldOffset(fieldBodyX) + 8);
+      // and its cos and sin follow rotation
+      expect(getFieldOffset(fieldBodyQ), getFieldOffset(fieldBodyRotation) + 4);
       // These two must not swap: reading one as the other is a classic
       // silent-corruption bug.
       expect(getFieldOffset(fieldBodyCollisionCount), lessThan(getFieldOffset(fieldBodyCategoryBits)));
+      // isBullet was appended after alive; Dart writes it directly.
+      expect(getFieldOffset(fieldBodyIsBullet), sizeOf<NativeBody>() - 4);
     });
 
     test('PhysicsWorld prefix', () {
@@ -138,5 +157,10 @@ void main() {
       // `hit` is the flag every raycast call branches on.
       expect(getFieldOffset(fieldRayHit), sizeOf<RayCastHit>() - 4);
     });
+
+    test('ContactEvent', () {
+      // approachSpeed is the last of eight 4-byte fields.
+      expect(getFieldOffset(fieldContactEventApproachSpeed), sizeOf<ContactEvent>() - 4);
+    });
   });
 }
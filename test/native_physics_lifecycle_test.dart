@@ -1,5 +1,8 @@
+import 'dart:ffi';
+
 import 'package:flutter_test/flutter_test.dart';
 import 'package:flash/flash.dart';
+import 'package:flash/src/core/native/flash_native_bindings.dart' as native;
 import 'package:vector_math/vector_math_64.dart' as v;
 
 /// Exercises the native physics allocation and teardown paths.
@@ -30,6 +33,13 @@ void main() {
     }
   });
 
+  test('a world too large for the contact table is refused', () {
+    // Contacts are keyed on body ids in 24 bits; a bigger world would let two
+    // pairs share a contact.
+    expect(native.createPhysicsWorld(0, 0), nullptr);
+    expect(native.createPhysicsWorld((1 << 24) + 1, 0), nullptr);
+  });
+
   test('a dynamic body falls under Y-up negative gravity', () {
     final world = FPhysicsSystem(gravity: v.Vector2(0, -980));
     addTearDown(world.dispose);
@@ -50,9 +60,9 @@ void main() {
   });
 
   test('a long multi-contact run stays stable', () {
-    // Also covers the warm-start cache, which is now rebuilt each step. It
-    // previously kept an entry for every pair that had ever touched and grew
-    // for the whole lifetime of the world.
+    // Also covers contact lifetime. The old warm-start cache kept an entry
+    // for every pair that had ever touched and grew for the whole lifetime of
+    // the world; contacts now go as soon as their pair stops touching.
     final world = FPhysicsSystem(gravity: v.Vector2(0, -980));
     addTearDown(world.dispose);
 
@@ -89,9 +89,28 @@ void main() {
         reason: 'slots were not being recycled');
   });
 
+  test('removing a body drops its contacts at once', () {
+    // Contacts persist from step to step now, so nothing else would clear a
+    // removed body's contacts before the next narrow phase — and a sleeping
+    // body's contacts are not looked at by the narrow phase at all.
+    final ground = FPhysicsBody(world: physics.world, type: 0, x: 0, y: -200, width: 400, height: 40);
+    engine.scene.addChild(ground);
+    final resting = addBody(x: -100, y: -155);
+    final removed = addBody(x: 100, y: -155);
+    for (int i = 0; i < 30; i++) {
+      physics.update(1 / 60);
+    }
+    expect(physics.world.ref.activeConstraints, 2);
+
+    remove(removed);
+    expect(physics.world.ref.activeConstraints, 1);
+    expect(FPhysicsSystem.getCollisionCount(physics.world, resting.bodyId), 1);
+  });
+
   test('a recycled slot does not inherit the previous body\'s contacts', () {
-    // Warm-start impulses are cached per body pair. A recycled slot picking up
-    // the old body's cached impulses would be flung apart on its first frame.
+    // Contacts, impulses included, are stored per body pair. A recycled slot
+    // picking up the old body's contact would be flung apart on its first
+    // frame.
     final ground = FPhysicsBody(world: physics.world, type: 0, x: 0, y: -200, width: 400, height: 40);
     engine.scene.addChild(ground);
 
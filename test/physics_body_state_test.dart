@@ -0,0 +1,115 @@
+import 'dart:ffi';
+import 'dart:math' as math;
+
+import 'package:ffi/ffi.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flash/flash.dart';
+import 'package:flash/src/core/native/flash_native_bindings.dart' as native;
+import 'package:vector_math/vector_math_64.dart' as v;
+
+/// Bulk export of body state.
+///
+/// Bodies used to read their pose one NativeBody view at a time. The native
+/// core now copies out the bodies that can have moved in one call, and
+/// [FPhysicsSystem.update] hands the poses to the bodies.
+void main() {
+  late FPhysicsSystem world;
+  late FPhysicsBody ground;
+
+  setUp(() {
+    world = FPhysicsSystem(gravity: v.Vector2(0, -980));
+    ground = FPhysicsBody(
+      world: world.world,
+      type: FPhysics.staticBody,
+      shapeType: FPhysics.box,
+      x: 0,
+      y: -300,
+      width: 4000,
+      height: 60,
+    );
+  });
+
+  tearDown(() => world.dispose());
+
+  FPhysicsBody ball(double x, double y) =>
+      FPhysicsBody(world: world.world, x: x, y: y, width: 40, height: 40, restitution: 0);
+
+  test('exports the listed bodies in order, zeroing unknown ids', () {
+    final a = ball(-100, 0);
+    final b = ball(100, 50);
+    world.update(1 / 60);
+
+    final ids = calloc<Int32>(3);
+    final out = calloc<native.BodyState>(3);
+    addTearDown(() {
+      calloc.free(ids);
+      calloc.free(out);
+    });
+    ids[0] = b.bodyId;
+    ids[1] = 1000;
+    ids[2] = a.bodyId;
+
+    expect(native.getBodyTransforms(world.world, ids, 3, out), 2);
+    final nb = (world.world.ref.bodies + b.bodyId).ref;
+    expect(out[0].id, b.bodyId);
+    expect((out[0].x, out[0].y, out[0].vy), (nb.x, nb.y, nb.vy));
+    expect(out[0].awake, 1);
+    expect((out[1].id, out[1].awake, out[1].x), (1000, 0, 0.0));
+    expect(out[2].x, closeTo(-100, 1e-3));
+  });
+
+  test('the awake export skips static and sleeping bodies', () {
+    final a = ball(0, -250);
+    final out = calloc<native.BodyState>(8);
+    addTearDown(() => calloc.free(out));
+
+    world.update(1 / 60);
+    final count = native.getAwakeBodyTransforms(world.world, out, 8);
+    expect([for (int i = 0; i < count; i++) out[i].id], [a.bodyId]);
+    expect([for (int i = 0; i < count; i++) out[i].id], isNot(contains(ground.bodyId)));
+
+    for (int i = 0; i < 120 && a.isAwake; i++) {
+      world.update(1 / 60);
+    }
+    expect(a.isAwake, isFalse);
+    world.update(1 / 60);
+    expect(native.getAwakeBodyTransforms(world.world, out, 8), 0);
+  });
+
+  test('bodies are drawn where the export put them', () {
+    final a = ball(0, 0);
+    for (int i = 0; i < 10; i++) {
+      world.update(1 / 60);
+    }
+    a.process(1 / 60);
+    final nb = (world.world.ref.bodies + a.bodyId).ref;
+    expect(a.transform.position.y, nb.y);
+    expect(a.transform.position.y, lessThan(0));
+  });
+
+  test('the cos and sin of a body\'s rotation follow it as it turns', () {
+    final box = FPhysicsBody(
+      world: world.world,
+      shapeType: FPhysics.box,
+      y: 200,
+      width: 60,
+      height: 30,
+      rotation: 0.3,
+    );
+    final nb = (world.world.ref.bodies + box.bodyId).ref;
+    void expectInStep() {
+      expect(nb.q.c, closeTo(math.cos(nb.rotation), 1e-6));
+      expect(nb.q.s, closeTo(math.sin(nb.rotation), 1e-6));
+    }
+
+    expectInStep();
+    nb.angularVelocity = 8;
+    for (int i = 0; i < 60; i++) {
+      world.update(1 / 60);
+      expectInStep();
+    }
+    // It turned a good way and landed on the ground.
+    expect(nb.rotation, greaterThan(1.0));
+    expect(nb.y, lessThan(0));
+  });
+}
@@ -0,0 +1,243 @@
+import 'dart:math';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flash/flash.dart';
+import 'package:vector_math/vector_math_64.dart' as v;
+
+/// The broadphase tree only restructures for bodies that leave their
+/// enlarged bounds, and [FPhysicsSystem.broadphaseStats] reports how often
+/// that happens and what shape the tree is in.
+void main() {
+  late FPhysicsSystem world;
+
+  setUp(() => world = FPhysicsSystem(gravity: v.Vector2.zero())..fixedTimeStep = 1 / 60);
+  tearDown(() => world.dispose());
+
+  test('a body at rest is checked but not reinserted', () {
+    FPhysicsBody(world: world.world, shapeType: FPhysics.box, x: 0, y: 0, width: 20, height: 20);
+    world.update(1 / 60);
+
+    final stats = world.broadphaseStats;
+    expect(stats.checkedProxies, 1);
+    expect(stats.reinsertions, 0);
+  });
+
+  test('a moving body is reinserted every few steps, not every step', () {
+    final body = FPhysicsBody(world: world.world, shapeType: FPhysics.box, x: 0, y: 0, width: 20, height: 20);
+    FPhysicsSystem.setBodyVelocity(world.world, body.bodyId, 600, 0);
+    var reinsertions = 0;
+    for (int i = 0; i < 30; i++) {
+      world.update(1 / 60);
+      reinsertions += world.broadphaseStats.reinsertions;
+    }
+
+    // 10 pixels a step against bounds stretched four steps ahead.
+    expect(reinsertions, greaterThan(0));
+    expect(reinsertions, lessThan(10));
+  });
+
+  test('pairs are counted', () {
+    FPhysicsBody(
+      world: world.world,
+      type: FPhysics.staticBody,
+      shapeType: FPhysics.box,
+      x: 0,
+      y: -40,
+      width: 400,
+      height: 60,
+    );
+    FPhysicsBody(world: world.world, shapeType: FPhysics.box, x: 0, y: 0, width: 20, height: 20);
+    world.update(1 / 60);
+
+    expect(world.broadphaseStats.pairCount, 1);
+  });
+
+  // Two boxes 15 apart drifting up side by side: each one's enlarged bounds
+  // reach the other's, so they pair without touching.
+  (FPhysicsBody, FPhysicsBody) drifting() {
+    final a = FPhysicsBody(world: world.world, shapeType: FPhysics.box, x: 0, y: 0, width: 20, height: 20);
+    final b = FPhysicsBody(world: world.world, shapeType: FPhysics.box, x: 35, y: 0, width: 20, height: 20);
+    FPhysicsSystem.setBodyVelocity(world.world, a.bodyId, 0, 30);
+    FPhysicsSystem.setBodyVelocity(world.world, b.bodyId, 0, 30);
+    for (int i = 0; i < 3; i++) {
+      world.update(1 / 60);
+    }
+    return (a, b);
+  }
+
+  test('a step where nothing left its bounds finds no new pairs', () {
+    drifting();
+    expect(world.broadphaseStats.pairCount, 1);
+
+    // Half a pixel a step stays inside the bounds for a while: both bodies
+    // are checked, neither goes into the move buffer, and the pair found
+    // when they last moved is simply kept.
+    for (int i = 0; i < 5; i++) {
+      world.update(1 / 60);
+      final stats = world.broadphaseStats;
+      expect(stats.checkedProxies, 2);
+      expect(stats.reinsertions, 0);
+      expect(stats.pairCount, 1);
+    }
+  });
+
+  test('a pair leaves the set once a moved body stops overlapping', () {
+    final (_, b) = drifting();
+    expect(world.broadphaseStats.pairCount, 1);
+
+    FPhysicsSystem.setBodyVelocity(world.world, b.bodyId, 600, 30);
+    for (int i = 0; i < 30; i++) {
+      world.update(1 / 60);
+    }
+    expect(world.broadphaseStats.pairCount, 0);
+  });
+
+  test('the pair set agrees with a brute-force overlap test', () {
+    // 64 balls scattering at 60 pixels a second. Every step, each pair whose
+    // own bounds overlap must be in the set, and no pair can be whose bounds
+    // are further apart than two enlarged bounds reach: the margin, the
+    // slack kept before a slowed body's bounds are shrunk, and four steps'
+    // displacement, on each side of each body.
+    final rnd = Random(7);
+    final balls = <FPhysicsBody>[];
+    for (int i = 0; i < 64; i++) {
+      final ball = FPhysicsBody(world: world.world, x: (i % 8) * 40.0, y: (i ~/ 8) * 40.0, width: 20, height: 20);
+      final angle = rnd.nextDouble() * 2 * pi;
+      FPhysicsSystem.setBodyVelocity(world.world, ball.bodyId, 60 * cos(angle), 60 * sin(angle));
+      balls.add(ball);
+    }
+
+    const reach = 120.0;
+    for (int frame = 0; frame < 300; frame++) {
+      world.update(1 / 60);
+      final x = [for (final ball in balls) (world.world.ref.bodies + ball.bodyId).ref.x];
+      final y = [for (final ball in balls) (world.world.ref.bodies + ball.bodyId).ref.y];
+      var overlapping = 0, withinReach = 0;
+      for (int i = 0; i < balls.length; i++) {
+        for (int j = i + 1; j < balls.length; j++) {
+          final gapX = (x[i] - x[j]).abs() - 20, gapY = (y[i] - y[j]).abs() - 20;
+          if (gapX <= 0 && gapY <= 0) overlapping++;
+          if (gapX <= reach && gapY <= reach) withinReach++;
+        }
+      }
+      final pairs = world.broadphaseStats.pairCount;
+      expect(pairs, greaterThanOrEqualTo(overlapping), reason: 'frame $frame');
+      expect(pairs, lessThanOrEqualTo(withinReach), reason: 'frame $frame');
+    }
+  });
+
+  test('tree height and area ratio are reported, and a rebuild tightens them', () {
+    for (int i = 0; i < 64; i++) {
+      FPhysicsBody(
+        world: world.world,
+        shapeType: FPhysics.box,
+        x: (i % 8) * 50.0,
+        y: (i ~/ 8) * 50.0,
+        width: 20,
+        height: 20,
+      );
+    }
+    world.update(1 / 60);
+    final before = world.broadphaseStats;
+    expect(before.treeHeight, greaterThanOrEqualTo(6));
+    expect(before.staticTreeHeight, 0);
+
+    world.rebuildBroadphase();
+    final after = world.broadphaseStats;
+    // An 8 x 8 grid splits evenly all the way down.
+    expect(after.treeHeight, 6);
+    expect(after.areaRatio, lessThan(before.areaRatio));
+  });
+
+  test('incremental rebuild finds the same pairs', () {
+    world.broadphaseRebuild = FBroadphaseRebuild.incremental;
+    FPhysicsBody(world: world.world, shapeType: FPhysics.box, x: 0, y: 0, width: 20, height: 20);
+    FPhysicsBody(world: world.world, shapeType: FPhysics.box, x: 0, y: 300, width: 20, height: 20);
+    final mover = FPhysicsBody(world: world.world, shapeType: FPhysics.box, x: 300, y: 0, width: 20, height: 20);
+    FPhysicsSystem.setBodyVelocity(world.world, mover.bodyId, -600, 0);
+    for (int i = 0; i < 30; i++) {
+      world.update(1 / 60);
+    }
+
+    expect(world.broadphaseStats.pairCount, 1);
+  });
+
+  for (final broadphase in FBroadphase.values) {
+    group('${broadphase.name} broadphase', () {
+      late FPhysicsSystem physics;
+
+      setUp(() => physics = FPhysicsSystem(gravity: v.Vector2.zero(), broadphase: broadphase)
+        ..fixedTimeStep = 1 / 60);
+      tearDown(() => physics.dispose());
+
+      test('finds pairs with moving and static bodies', () {
+        FPhysicsBody(
+          world: physics.world,
+          type: FPhysics.staticBody,
+          shapeType: FPhysics.box,
+          x: 0,
+          y: -40,
+          width: 400,
+          height: 60,
+        );
+        FPhysicsBody(world: physics.world, shapeType: FPhysics.box, x: 0, y: 0, width: 20, height: 20);
+        final left = FPhysicsBody(world: physics.world, shapeType: FPhysics.box, x: -300, y: 200, width: 20, height: 20);
+        final right = FPhysicsBody(world: physics.world, shapeType: FPhysics.box, x: 300, y: 200, width: 20, height: 20);
+        FPhysicsSystem.setBodyVelocity(physics.world, left.bodyId, 600, 0);
+        FPhysicsSystem.setBodyVelocity(physics.world, right.bodyId, -600, 0);
+        physics.update(1 / 60);
+        expect(physics.broadphaseStats.pairCount, 1);
+
+        for (int i = 0; i < 60; i++) {
+          physics.update(1 / 60);
+        }
+
+        // They met in the middle instead of passing through each other.
+        final leftX = FPhysicsSystem.getBodyPosition(physics.world, left.bodyId).dx;
+        final rightX = FPhysicsSystem.getBodyPosition(physics.world, right.bodyId).dx;
+        expect(rightX - leftX, greaterThanOrEqualTo(19));
+      });
+
+      test('layers that ignore each other form no pair until both masks allow it', () {
+        final a = FPhysicsBody(
+          world: physics.world,
+          shapeType: FPhysics.box,
+          width: 20,
+          height: 20,
+          categoryBits: 0x0002,
+          maskBits: 0x0002,
+        );
+        final b = FPhysicsBody(
+          world: physics.world,
+          shapeType: FPhysics.box,
+          x: 10,
+          width: 20,
+          height: 20,
+          categoryBits: 0x0004,
+          maskBits: 0x0004,
+        );
+        physics.update(1 / 60);
+        expect(physics.broadphaseStats.pairCount, 0);
+
+        // Both sides have to want the other, as in the narrow phase.
+        b.maskBits = 0x0006;
+        physics.update(1 / 60);
+        expect(physics.broadphaseStats.pairCount, 0);
+
+        a.maskBits = 0x0006;
+        physics.update(1 / 60);
+        expect(physics.broadphaseStats.pairCount, 1);
+      });
+
+      test('raycasts hit dynamic bodies', () {
+        final body = FPhysicsBody(world: physics.world, shapeType: FPhysics.box, x: 100, y: 0, width: 20, height: 20);
+        physics.update(1 / 60);
+
+        final hit = FPhysicsSystem.rayCast(physics.world, -500, 0, 500, 0);
+        expect(hit?.bodyId, body.bodyId);
+        expect(hit?.x, closeTo(90, 0.5));
+        expect(FPhysicsSystem.rayCast(physics.world, -500, 100, 500, 100), isNull);
+      });
+    });
+  }
+}
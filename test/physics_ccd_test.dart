@@ -0,0 +1,74 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flash/flash.dart';
+import 'package:vector_math/vector_math_64.dart' as v;
+
+/// Continuous collision for bullet bodies.
+///
+/// At 20000 units/s a 20-unit body covers 333 units per 1/60 s frame, so the
+/// discrete narrow phase never sees it overlap a 10-unit wall. A bullet is
+/// swept and stopped at the wall; an ordinary body goes straight through.
+void main() {
+  late FPhysicsSystem world;
+
+  setUp(() {
+    world = FPhysicsSystem(gravity: v.Vector2(0, 0));
+    FPhysicsBody(
+      world: world.world,
+      type: FPhysics.staticBody,
+      shapeType: FPhysics.box,
+      x: 500,
+      y: 0,
+      width: 10,
+      height: 400,
+      restitution: 0,
+    );
+  });
+
+  tearDown(() => world.dispose());
+
+  double furthestX(FPhysicsBody body) {
+    var furthest = double.negativeInfinity;
+    for (int i = 0; i < 60; i++) {
+      world.update(1 / 60);
+      final x = (world.world.ref.bodies + body.bodyId).ref.x;
+      if (x > furthest) furthest = x;
+    }
+    return furthest;
+  }
+
+  FPhysicsBody shot(int shapeType, {required bool bullet}) {
+    final body = FPhysicsBody(
+      world: world.world,
+      shapeType: shapeType,
+      x: 0,
+      y: 0,
+      width: 20,
+      height: 20,
+      restitution: 0,
+      bullet: bullet,
+    );
+    body.setVelocity(20000, 0);
+    return body;
+  }
+
+  test('a fast circle without the flag tunnels', () {
+    final body = shot(FPhysics.circle, bullet: false);
+    expect(body.isBullet, isFalse);
+    expect(furthestX(body), greaterThan(1000));
+  });
+
+  for (final (name, shape) in [('circle', FPhysics.circle), ('box', FPhysics.box)]) {
+    test('a bullet $name stops at a thin wall', () {
+      final body = shot(shape, bullet: true);
+      expect(body.isBullet, isTrue);
+      // Face of the wall at 495, less the body's half width of 10.
+      expect(furthestX(body), lessThan(490));
+    });
+  }
+
+  test('soft step sweeps bullets too', () {
+    world.solverMode = FSolverMode.softStep;
+    final body = shot(FPhysics.circle, bullet: true);
+    expect(furthestX(body), lessThan(490));
+  });
+}
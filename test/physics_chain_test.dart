@@ -0,0 +1,96 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flash/flash.dart';
+import 'package:vector_math/vector_math_64.dart' as v;
+
+/// Chain bodies: static terrain as one polyline of one-sided segments rather
+/// than a box per tile. Bodies rest on and slide across it, and rays and
+/// bodies from behind pass through.
+void main() {
+  late FPhysicsSystem physics;
+
+  setUp(() {
+    physics = FPhysicsSystem(gravity: v.Vector2(0, -980), solverMode: FSolverMode.softStep);
+  });
+  tearDown(() => physics.dispose());
+
+  void run(int frames) {
+    for (int i = 0; i < frames; i++) {
+      physics.update(1 / 60);
+    }
+  }
+
+  // Flat ground at y = -270 in 25-pixel tiles, listed right to left so the
+  // top is the solid side.
+  List<v.Vector2> tiles() => [for (int i = 40; i >= -40; i--) v.Vector2(i * 25.0, -270)];
+
+  test('a box slides across the tile seams', () {
+    final ground = FPhysicsSystem.createChainBody(physics.world, tiles());
+    expect(ground, isNot(-1));
+    final box = FPhysicsBody(world: physics.world, shapeType: FPhysics.box, x: -800, y: -250, width: 40, height: 40);
+    run(30);
+    FPhysicsSystem.setBodyVelocity(physics.world, box.bodyId, 600, 0);
+    run(120);
+    box.process(1 / 60);
+
+    // Friction slows it, but no seam stops it dead or tips it over.
+    expect(box.transform.position.x, greaterThan(-200));
+    expect(box.transform.position.y, closeTo(-250, 1));
+    expect(box.transform.rotation.z.abs(), lessThan(0.05));
+  });
+
+  test('a ball rests on a hilltop', () {
+    FPhysicsSystem.createChainBody(physics.world, [
+      v.Vector2(600, -270),
+      v.Vector2(200, -270),
+      v.Vector2(100, -200),
+      v.Vector2(-100, -200),
+      v.Vector2(-200, -270),
+      v.Vector2(-600, -270),
+    ]);
+    final ball = FPhysicsBody(world: physics.world, x: 0, y: -100, width: 30, height: 30);
+    run(120);
+    ball.process(1 / 60);
+
+    expect(ball.transform.position.y, closeTo(-185, 1));
+  });
+
+  test('segments are one-sided', () {
+    FPhysicsSystem.createChainBody(physics.world, tiles());
+    final box = FPhysicsBody(world: physics.world, shapeType: FPhysics.box, x: 0, y: -400, width: 40, height: 40);
+    FPhysicsSystem.setBodyVelocity(physics.world, box.bodyId, 0, 900);
+    run(240);
+    box.process(1 / 60);
+
+    // Up through the ground from below, then back down onto its top.
+    expect(box.transform.position.y, closeTo(-250, 1));
+
+    expect(FPhysicsSystem.rayCast(physics.world, 100, 0, 100, -500)?.y, closeTo(-270, 0.01));
+    expect(FPhysicsSystem.rayCast(physics.world, 100, -500, 100, 0), isNull);
+  });
+
+  test('a counter-clockwise loop is solid outside', () {
+    final loop = FPhysicsSystem.createChainBody(
+      physics.world,
+      [v.Vector2(-50, -50), v.Vector2(50, -50), v.Vector2(50, 50), v.Vector2(-50, 50)],
+      loop: true,
+    );
+    final hit = FPhysicsSystem.rayCast(physics.world, -200, 0, 200, 0);
+    expect(hit?.bodyId, loop);
+    expect(hit?.x, closeTo(-50, 0.01));
+    expect(hit?.normalX, closeTo(-1, 1e-3));
+  });
+
+  test('too few points are rejected', () {
+    expect(FPhysicsSystem.createChainBody(physics.world, [v.Vector2(0, 0)]), -1);
+    expect(FPhysicsSystem.createChainBody(physics.world, [v.Vector2(0, 0), v.Vector2(0.1, 0)]), -1);
+    expect(FPhysicsSystem.createChainBody(physics.world, [v.Vector2(0, 0), v.Vector2(10, 0)], loop: true), -1);
+  });
+
+  test('a chain longer than its contacts can key is rejected', () {
+    // A contact is keyed on its segment in 16 bits; a 65537th segment would
+    // share its key with the first.
+    List<v.Vector2> steps(int count) => [for (int i = count; i >= 0; i--) v.Vector2(i * 2.0, -270)];
+    expect(FPhysicsSystem.createChainBody(physics.world, steps(65536)), isNot(-1));
+    expect(FPhysicsSystem.createChainBody(physics.world, steps(65537)), -1);
+  });
+}
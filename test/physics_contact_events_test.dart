@@ -0,0 +1,126 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flash/flash.dart';
+import 'package:vector_math/vector_math_64.dart' as v;
+
+/// The contact event stream.
+///
+/// Dart used to see only collision_count on each body and had to diff it every
+/// frame to guess when contacts began and ended. The native core now reports
+/// begin and end itself, and FPhysicsSystem drains them once per update.
+void main() {
+  late FPhysicsSystem world;
+  late FPhysicsBody ground;
+  late List<FContactEvent> events;
+
+  setUp(() {
+    world = FPhysicsSystem(gravity: v.Vector2(0, -980));
+    ground = FPhysicsBody(
+      world: world.world,
+      type: FPhysics.staticBody,
+      shapeType: FPhysics.box,
+      x: 0,
+      y: -300,
+      width: 4000,
+      height: 60,
+    );
+    events = [];
+    world.contactEvent.connect(events.add);
+  });
+
+  tearDown(() => world.dispose());
+
+  FPhysicsBody ball({double x = 0, double y = 0}) => FPhysicsBody(
+    world: world.world,
+    type: FPhysics.dynamicBody,
+    shapeType: FPhysics.circle,
+    x: x,
+    y: y,
+    width: 40,
+    height: 40,
+    restitution: 0,
+  );
+
+  void runUntil(bool Function() done, {int maxFrames = 240}) {
+    for (int i = 0; i < maxFrames && !done(); i++) {
+      world.update(1 / 60);
+    }
+  }
+
+  test('landing raises a begin with the point, normal and approach speed', () {
+    final b = ball(y: 0);
+    runUntil(() => events.isNotEmpty);
+
+    final e = events.first;
+    expect(e.type, FContactEventType.begin);
+    expect((e.bodyA, e.bodyB), (ground.bodyId, b.bodyId));
+    // Normal from the ground up to the ball; point on the ground's surface.
+    expect(e.normal.dy, closeTo(1, 1e-3));
+    expect(e.point.dy, closeTo(-270, 2));
+    // Dropped ~250 units under 980 units/s²: about 700 units/s at impact.
+    expect(e.approachSpeed, greaterThan(500));
+  });
+
+  test('leaving the ground raises end, and the body signals follow', () {
+    final b = ball(y: -250);
+    var entered = 0, exited = 0;
+    b.collisionEntered.connect((_) => entered++);
+    b.collisionExited.connect((_) => exited++);
+
+    world.update(1 / 60);
+    b.process(1 / 60);
+    expect(b.isColliding, isTrue);
+    expect(entered, 1);
+
+    b.setVelocity(0, 800);
+    runUntil(() => events.any((e) => e.type == FContactEventType.end));
+    b.process(1 / 60);
+    expect(b.isColliding, isFalse);
+    expect(exited, 1);
+  });
+
+  test('removing a body ends its contacts for the other side', () {
+    final resting = ball(x: -100, y: -250);
+    final removed = ball(x: 100, y: -250);
+    world.update(1 / 60);
+    resting.process(1 / 60);
+    expect(resting.isColliding, isTrue);
+
+    events.clear();
+    removed.dispose();
+    world.update(1 / 60);
+    expect(
+      events.where((e) => e.type == FContactEventType.end).map((e) => e.bodyB),
+      [removed.bodyId],
+    );
+    resting.process(1 / 60);
+    expect(resting.isColliding, isTrue, reason: 'the other body still rests on the ground');
+  });
+
+  test('a static body counts only this step\'s contacts', () {
+    // Statics are never awake, and their count was once only reset for awake
+    // bodies: under two rolling balls the ground's count grew every step,
+    // and the resync after a dropped event read it as hundreds of contacts.
+    final left = ball(x: -200, y: -250)..setVelocity(100, 0);
+    final right = ball(x: 200, y: -250)..setVelocity(100, 0);
+    for (int i = 0; i < 120; i++) {
+      world.update(1 / 60);
+    }
+
+    expect(FPhysicsSystem.getCollisionCount(world.world, ground.bodyId), 2);
+    expect(FPhysicsSystem.getCollisionCount(world.world, left.bodyId), 1);
+    expect(FPhysicsSystem.getCollisionCount(world.world, right.bodyId), 1);
+  });
+
+  test('persist events are opt-in', () {
+    ball(y: -250);
+    world.update(1 / 60);
+    events.clear();
+    world.update(1 / 60);
+    expect(events, isEmpty);
+
+    world.persistContactEvents = true;
+    world.update(1 / 60);
+    expect(events, isNotEmpty);
+    expect(events.every((e) => e.type == FContactEventType.persist), isTrue);
+  });
+}
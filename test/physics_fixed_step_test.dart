@@ -0,0 +1,55 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flash/flash.dart';
+import 'package:vector_math/vector_math_64.dart' as v;
+
+/// The native fixed-step accumulator and interpolated poses.
+///
+/// [FPhysicsSystem.update] hands the raw frame time to `step_physics_fixed`,
+/// which steps in whole fixed steps, carries the rest, and blends each body's
+/// pose between its last two steps for drawing.
+void main() {
+  late FPhysicsSystem world;
+  late FPhysicsBody ball;
+
+  setUp(() {
+    world = FPhysicsSystem(gravity: v.Vector2(0, -980))..fixedTimeStep = 1 / 60;
+    ball = FPhysicsBody(world: world.world, x: 0, y: 0, width: 20, height: 20);
+  });
+
+  tearDown(() => world.dispose());
+
+  double simulatedY() => (world.world.ref.bodies + ball.bodyId).ref.y;
+
+  test('frame time is stepped in whole fixed steps', () {
+    world.update(1 / 120);
+    expect(simulatedY(), 0, reason: 'half a step is carried, not stepped');
+    world.update(1 / 120);
+    expect(simulatedY(), lessThan(0));
+  });
+
+  test('drawn pose sits between the last two steps', () {
+    world.interpolation = true;
+    world.update(1 / 60);
+    final before = simulatedY();
+    world.update(1 / 60);
+    final after = simulatedY();
+
+    // Half a step into the next: halfway between the two.
+    world.update(1 / 120);
+    expect(simulatedY(), after);
+    ball.process(1 / 120);
+    expect(ball.transform.position.y, closeTo((before + after) / 2, 1e-3));
+
+    world.interpolation = false;
+    ball.process(1 / 120);
+    expect(ball.transform.position.y, after);
+  });
+
+  test('a long frame takes at most maxStepsPerUpdate steps', () {
+    world.maxStepsPerUpdate = 2;
+    world.update(1.0);
+    final vy = (world.world.ref.bodies + ball.bodyId).ref.vy;
+    // Two steps of gravity, not sixty.
+    expect(vy, closeTo(-980 * 2 / 60, 1));
+  });
+}
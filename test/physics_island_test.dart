@@ -0,0 +1,99 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flash/flash.dart';
+import 'package:vector_math/vector_math_64.dart' as v;
+
+/// Island sleep.
+///
+/// Sleep used to be per body, and the static ground counted as an awake body
+/// that woke whatever touched it — so nothing resting on the ground ever
+/// slept. Islands make the ground a boundary rather than a member, and put a
+/// group of touching bodies to sleep and wake it as one.
+void main() {
+  FPhysicsSystem makeWorld() {
+    final world = FPhysicsSystem(gravity: v.Vector2(0, -980));
+    FPhysicsBody(
+      world: world.world,
+      type: FPhysics.staticBody,
+      shapeType: FPhysics.box,
+      x: 0,
+      y: -300,
+      width: 4000,
+      height: 60,
+    );
+    return world;
+  }
+
+  FPhysicsBody ball(FPhysicsSystem world, {required double x, required double y}) => FPhysicsBody(
+    world: world.world,
+    type: FPhysics.dynamicBody,
+    shapeType: FPhysics.circle,
+    x: x,
+    y: y,
+    width: 40,
+    height: 40,
+  );
+
+  void run(FPhysicsSystem world, int frames) {
+    for (int i = 0; i < frames; i++) {
+      world.update(1 / 60);
+    }
+  }
+
+  test('a body at rest on the ground falls asleep', () {
+    final world = makeWorld();
+    addTearDown(world.dispose);
+
+    final b = ball(world, x: 0, y: -250);
+    expect(b.isAwake, isTrue);
+    run(world, 120);
+    expect(b.isAwake, isFalse);
+  });
+
+  test('a body landing on a sleeping one wakes it', () {
+    final world = makeWorld();
+    addTearDown(world.dispose);
+
+    final resting = ball(world, x: 0, y: -250);
+    run(world, 120);
+    expect(resting.isAwake, isFalse);
+
+    ball(world, x: 0, y: 0);
+    var woke = false;
+    for (int i = 0; i < 120 && !woke; i++) {
+      world.update(1 / 60);
+      woke = resting.isAwake;
+    }
+    expect(woke, isTrue, reason: 'the falling body reached the sleeping one without waking it');
+  });
+
+  test('pushing a sleeping body wakes it', () {
+    final world = makeWorld();
+    addTearDown(world.dispose);
+
+    final b = ball(world, x: 0, y: -250);
+    run(world, 120);
+    expect(b.isAwake, isFalse);
+
+    b.setVelocity(200, 0);
+    expect(b.isAwake, isTrue);
+    run(world, 10);
+    b.process(1 / 60);
+    expect(b.transform.position.x, greaterThan(5));
+  });
+
+  test('separate islands sleep independently', () {
+    final world = makeWorld();
+    addTearDown(world.dispose);
+
+    final still = ball(world, x: -500, y: -250);
+    final pushed = ball(world, x: 500, y: -250);
+    for (int i = 0; i < 120; i++) {
+      pushed.setVelocity(100, 0);
+      world.update(1 / 60);
+    }
+
+    // Both rest on the same static ground, which no longer joins them.
+    expect(pushed.isAwake, isTrue);
+    expect(still.isAwake, isFalse);
+  });
+}
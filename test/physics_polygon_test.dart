@@ -0,0 +1,107 @@
+import 'dart:math' as math;
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flash/flash.dart';
+import 'package:vector_math/vector_math_64.dart' as v;
+
+/// Convex polygon bodies: one hull where a ramp or wedge used to be several
+/// boxes. The body sits at the hull's centroid, collides with clipped
+/// manifolds, and raycasts against its real faces rather than a box.
+void main() {
+  late FPhysicsSystem physics;
+
+  setUp(() {
+    physics = FPhysicsSystem(gravity: v.Vector2(0, -980), solverMode: FSolverMode.softStep);
+    FPhysicsBody(
+      world: physics.world,
+      type: FPhysics.staticBody,
+      shapeType: FPhysics.box,
+      x: 0,
+      y: -300,
+      width: 4000,
+      height: 60,
+    );
+  });
+  tearDown(() => physics.dispose());
+
+  void run(int frames) {
+    for (int i = 0; i < frames; i++) {
+      physics.update(1 / 60);
+    }
+  }
+
+  // Right-angled, 80 wide and 40 tall; its centroid is a third of the way in.
+  final wedge = [v.Vector2(-40, -20), v.Vector2(40, -20), v.Vector2(40, 20)];
+
+  test('the body is placed at the hull centroid', () {
+    final body = FPhysicsBody(world: physics.world, x: 100, y: 0, vertices: wedge);
+    expect(body.shapeType, FPhysics.polygon);
+    final position = FPhysicsSystem.getBodyPosition(physics.world, body.bodyId);
+    expect(position.dx, closeTo(100 + 40 / 3, 1e-3));
+    expect(position.dy, closeTo(-20 / 3, 1e-3));
+    expect(body.vertices, hasLength(3));
+  });
+
+  test('a wedge comes to rest flat on the ground', () {
+    final body = FPhysicsBody(world: physics.world, x: 0, y: 0, vertices: wedge);
+    run(300);
+    body.process(1 / 60);
+
+    // The base is a third of the height below the centroid: -270 + 40 / 3.
+    expect(body.transform.position.y, closeTo(-270 + 40 / 3, 2));
+    expect(body.transform.rotation.z.abs(), lessThan(0.01));
+    expect(body.isAwake, isFalse);
+  });
+
+  test('hexagons stack', () {
+    final hexagon = [
+      for (int i = 0; i < 6; i++) v.Vector2(20 * math.cos(i * math.pi / 3), 20 * math.sin(i * math.pi / 3)),
+    ];
+    late FPhysicsBody top;
+    for (int i = 0; i < 5; i++) {
+      top = FPhysicsBody(world: physics.world, x: 0, y: -250 + i * 36.0, vertices: hexagon);
+    }
+    run(300);
+    top.process(1 / 60);
+
+    // Flat side down, each 2 * 20 * sin(60°) ≈ 34.6 tall.
+    expect(top.transform.position.y, closeTo(-270 + 4.5 * 34.64, 4));
+    expect(top.transform.position.x.abs(), lessThan(10));
+  });
+
+  test('a ray hits the slanted face with its normal', () {
+    final body = FPhysicsBody(world: physics.world, type: FPhysics.staticBody, x: 0, y: 0, vertices: wedge);
+
+    // Straight down at local x = 0 on the hypotenuse y = x / 2.
+    final hit = FPhysicsSystem.rayCast(physics.world, 0, 200, 0, -200);
+    expect(hit, isNotNull);
+    expect(hit!.bodyId, body.bodyId);
+    expect(hit.y, closeTo(0, 0.5));
+    expect(hit.normalX, closeTo(-0.4472, 1e-3));
+    expect(hit.normalY, closeTo(0.8944, 1e-3));
+  });
+
+  test('a ball rolls down a static ramp', () {
+    FPhysicsBody(
+      world: physics.world,
+      type: FPhysics.staticBody,
+      x: -400,
+      y: -270,
+      vertices: [v.Vector2(0, 0), v.Vector2(400, 0), v.Vector2(0, 200)],
+    );
+    final ball = FPhysicsBody(world: physics.world, x: -360, y: 0, width: 30, height: 30);
+    run(120);
+    ball.process(1 / 60);
+
+    // Down the slope and off its foot, never through it.
+    expect(ball.transform.position.x, greaterThan(0));
+    expect(ball.transform.position.y, closeTo(-255, 2));
+  });
+
+  test('points that do not span an area are rejected', () {
+    final collinear = [v.Vector2(0, 0), v.Vector2(10, 0), v.Vector2(20, 0)];
+    expect(FPhysicsSystem.createPolygonBody(physics.world, FPhysics.dynamicBody, 0, 0, 0, collinear, 1, 0xFFFF), -1);
+    final tooMany = [for (int i = 0; i < 9; i++) v.Vector2(i.toDouble(), (i * i).toDouble())];
+    expect(FPhysicsSystem.createPolygonBody(physics.world, FPhysics.dynamicBody, 0, 0, 0, tooMany, 1, 0xFFFF), -1);
+  });
+}
@@ -0,0 +1,100 @@
+import 'dart:ffi';
+import 'dart:math' as math;
+
+import 'package:ffi/ffi.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flash/flash.dart';
+import 'package:flash/src/core/native/flash_native_bindings.dart' as native;
+import 'package:vector_math/vector_math_64.dart' as v;
+
+/// Warm starting carries a contact point's impulses to the next step by its
+/// feature id, not by its place in the manifold.
+///
+/// A right-angled wedge rests on its long face with the heavier point under
+/// its right angle. Tipping it onto the other corner leaves one point, now
+/// first in the manifold; laying it flat again brings the lifted point back.
+/// Velocity iterations are off while it is moved, so each impulse read back
+/// is the one the step was warm started with.
+void main() {
+  late FPhysicsSystem world;
+  late FPhysicsBody ground;
+  late FPhysicsBody wedge;
+  late Pointer<native.ManifoldPoint> points;
+
+  setUp(() {
+    world = FPhysicsSystem(gravity: v.Vector2(0, -980))..fixedTimeStep = 1 / 60;
+    ground = FPhysicsBody(
+      world: world.world,
+      type: FPhysics.staticBody,
+      shapeType: FPhysics.box,
+      x: 0,
+      y: -300,
+      width: 4000,
+      height: 60,
+    );
+    // 60 wide and 60 tall; its centroid sits at (20, -250).
+    wedge = FPhysicsBody(
+      world: world.world,
+      x: 0,
+      y: -270,
+      vertices: [v.Vector2(0, 0), v.Vector2(60, 0), v.Vector2(0, 60)],
+    );
+    points = calloc<native.ManifoldPoint>(2);
+  });
+
+  tearDown(() {
+    calloc.free(points);
+    world.dispose();
+  });
+
+  /// (id, normal impulse) of each point, in manifold order.
+  List<(int, double)> manifold() {
+    final count = native.getContactPoints(world.world, ground.bodyId, wedge.bodyId, points, 2);
+    return [for (int i = 0; i < count; i++) (points[i].id, points[i].normalImpulse)];
+  }
+
+  /// Turns the wedge by [angle] about its right-hand corner. There is no
+  /// transform setter, so this writes the native pose the next step reads.
+  void tilt(double angle) {
+    final body = (world.world.ref.bodies + wedge.bodyId).ref;
+    final pivotX = body.x + 40, pivotY = body.y - 20;
+    final c = math.cos(angle), s = math.sin(angle);
+    final dx = body.x - pivotX, dy = body.y - pivotY;
+    body.x = pivotX + c * dx - s * dy;
+    body.y = pivotY + s * dx + c * dy;
+    body.rotation += angle;
+    body.q.c = math.cos(body.rotation);
+    body.q.s = math.sin(body.rotation);
+  }
+
+  test('a point keeps its own impulse when the manifold reorders', () {
+    for (int i = 0; i < 20; i++) {
+      world.update(1 / 60);
+    }
+    final resting = manifold();
+    expect(resting, hasLength(2));
+    final (heavyId, heavyImpulse) = resting[0];
+    final (lightId, lightImpulse) = resting[1];
+    expect(heavyImpulse, greaterThan(lightImpulse * 1.5));
+
+    world.world.ref.velocityIterations = 0;
+    tilt(-0.1);
+    world.update(1 / 60);
+
+    // The light point moved from second to first. Matched by index, it
+    // would have been handed the heavy point's impulse.
+    final tipped = manifold();
+    expect(tipped, hasLength(1));
+    expect(tipped[0].$1, lightId);
+    expect(tipped[0].$2, closeTo(lightImpulse, 1e-4));
+
+    tilt(0.1);
+    world.update(1 / 60);
+
+    // The heavy point is new again and starts from nothing.
+    final flat = {for (final (id, impulse) in manifold()) id: impulse};
+    expect(flat.keys, unorderedEquals([heavyId, lightId]));
+    expect(flat[heavyId], 0);
+    expect(flat[lightId], closeTo(lightImpulse, 1e-4));
+  });
+}
@@ -70,6 +70,16 @@ void main() {
     expect(hit.fraction, lessThan(0.5));
   });
 
+  test('a mask skips bodies outside its categories, however near', () {
+    FPhysicsSystem.createBody(physics.world, staticBody, circle, -100, 0, 80, 80, 0, 0x0002, 0xFFFF);
+    final far = addCircle(100, 0, 40);
+
+    expect(FPhysicsSystem.rayCast(physics.world, -500, 0, 500, 0, maskBits: 0x0001)?.bodyId, far);
+    expect(FPhysicsSystem.rayCast(physics.world, -500, 0, 500, 0, maskBits: 0x0004), isNull);
+    // Unmasked, the nearer one still wins.
+    expect(cast(-500, 0, 500, 0)?.bodyId, isNot(far));
+  });
+
   test('the ray is a segment, not an infinite line', () {
     addCircle(400, 0, 40);
     // Stops well short of the body.
@@ -137,4 +147,31 @@ void main() {
     final hit = cast(-500, 0, 500, 0);
     expect(hit?.bodyId, target);
   });
+
+  test('the nearest hit is found however many bodies the ray crosses', () {
+    // Candidates were collected into a 256-entry buffer before the exact
+    // test, and whichever did not fit were never tested — here, the nearest.
+    final near = addBox(-200, 0, 40, 40);
+    for (int i = 0; i < 400; i++) {
+      addBox(400, 0, 40, 40);
+    }
+    expect(cast(-500, 0, 500, 0)?.bodyId, near);
+  });
+
+  test('a tree queried often answers the same, and sees bodies added after', () {
+    // A tree queried enough between changes answers from a 4-wide copy of
+    // itself. Every ray must get the same answer on either side of the
+    // switch, and a body added later must make the copy stale.
+    for (int i = 0; i < 400; i++) {
+      addBox((i % 20) * 60.0 - 600, (i ~/ 20) * 60.0 - 600, 20, 20);
+    }
+    final first = [for (int i = 0; i < 40; i++) cast(-700, i * 30.0 - 600, 700, 600 - i * 30.0)?.bodyId];
+    for (int round = 0; round < 20; round++) {
+      final again = [for (int i = 0; i < 40; i++) cast(-700, i * 30.0 - 600, 700, 600 - i * 30.0)?.bodyId];
+      expect(again, first);
+    }
+
+    final added = addCircle(-650, -630, 10);
+    expect(cast(-700, -630, -600, -630)?.bodyId, added);
+  });
 }